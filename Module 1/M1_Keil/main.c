@@ -7,20 +7,26 @@
 * An assembly code subroutine was written to approximate the square root of an 
 * argument using the bisection method. All math is done with integers, so the 
 * resulting square root is a truncated integer
+*
+* The square roots now used are the constant time routines of my_sqrt.c. The
+* bisection is kept here as my_sqrt_bisect so main can time the two against
+* each other.
 ******************************************************************************/
 
  #include <MKL25Z4.H>
+ #include "my_sqrt.h"
  
  /**
- * @brief my_sqrt is an assembly function which approximates the square root of 
- *				an integer using the bisection method.
+ * @brief my_sqrt_bisect is an assembly function which approximates the square
+ *				root of an integer using the bisection method.
  *
  * @param[in] x is the integer you wish to find a square root for
  *
  * @return The function returns a truncated integer approximation of sqrt(x).
  */
-__asm int my_sqrt(int x)
+__asm int my_sqrt_bisect(int x)
 {
+	PUSH	{r4,r5,lr}	; r4 and r5 belong to the caller
 	MOV		r3,r0				; x is now r3, r0 will be the return value c
 	MOVS	r2,#1			 	; b is r2 initialized to 65536, the largest sqrt possible for 32 bits
 	LSLS  r2,#16			; 65536 is 1 << 16 since the compiler wont allow more than 8 bit immediates.
@@ -39,26 +45,99 @@ ret
 	CMP		r0,r4				; check c == c_old
 	BNE		loop				; return to loop if c has changed
 end	
-	BX		lr					; finished
+	POP		{r4,r5,pc}	; finished
 less								; 
 	MOV		r1,r0				; a <- c
 	B			ret					; return
 }
 
+#define BENCH_N 8		///< arguments timed per routine
+
+/// cycles taken by one routine, the smallest and largest over bench_args
+struct sqrt_bench {
+	const char *name;
+	uint32_t min;
+	uint32_t max;
+};
+
+/// arguments for the benchmark, from the cheapest to the dearest bisection
+static const uint32_t bench_args[BENCH_N] = {
+	0, 1, 2, 22, 121, 65535, 1000000, 1073676289
+};
+
+/// results of bench(), read them in the debugger's watch window
+struct sqrt_bench bench_table[4] = {
+	{ "bisect", 0, 0 },
+	{ "my_sqrt", 0, 0 },
+	{ "my_sqrt64", 0, 0 },
+	{ "batch/elem", 0, 0 },
+};
+
+/**
+* @brief bench_note adds one timing to a bench_table row
+*
+* @param[in] b is the row
+* @param[in] cycles is the time taken
+*/
+static void bench_note(struct sqrt_bench *b, uint32_t cycles)
+{
+	if(b->min == 0 || cycles < b->min) b->min = cycles;
+	if(cycles > b->max) b->max = cycles;
+}
+
+/**
+* @brief bench times each square root on bench_args with SysTick, counting
+*				core clocks. The call overhead is included and the same for each.
+*/
+static void bench(void)
+{
+	volatile uint32_t sink;
+	uint16_t roots[BENCH_N];
+	uint32_t t, i;
+
+	SysTick->LOAD = 0x00FFFFFF;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+	for(i = 0; i < BENCH_N; i++)
+	{
+		t = SysTick->VAL;
+		sink = my_sqrt_bisect(bench_args[i]);
+		bench_note(&bench_table[0], (t - SysTick->VAL) & 0x00FFFFFF);
+
+		t = SysTick->VAL;
+		sink = my_sqrt(bench_args[i]);
+		bench_note(&bench_table[1], (t - SysTick->VAL) & 0x00FFFFFF);
+
+		t = SysTick->VAL;
+		sink = my_sqrt64((uint64_t)bench_args[i] << 32);
+		bench_note(&bench_table[2], (t - SysTick->VAL) & 0x00FFFFFF);
+	}
+	t = SysTick->VAL;
+	my_sqrt_batch(bench_args, roots, BENCH_N);
+	t = ((t - SysTick->VAL) & 0x00FFFFFF) / BENCH_N;
+	bench_note(&bench_table[3], t);
+	(void)sink;
+}
+
 /*----------------------------------------------------------------------------
  MAIN function
  *----------------------------------------------------------------------------*/
  /**
  * @brief Main function
- * The main function tests my_sqrt with four values: 2, 4, 22, and 121.
+ * The main function tests my_sqrt with four values: 2, 4, 22, and 121, then
+ * times the square roots into bench_table.
  * once the values are computed, the program enters a while loop.
  */
 int main(void){
 	int r, j, k, l;                 
+	uint32_t m;
   r = my_sqrt(2);     // should be 1
   j = my_sqrt(4);     // should be 2
 	k = my_sqrt(22); 	  // should be 4
 	l = my_sqrt(121);   // should be 11
+	m = my_sqrt64(0xFFFFFFFFFFFFFFFFULL);	// should be 4294967295
+	bench();
 	while(1)
 		;
 }
@@ -0,0 +1,207 @@
+/************************************************************************//**
+* \file my_sqrt.c
+* \brief ECEN 5803 Project 1, Module 1, integer square roots
+*
+*	Authors: David Pasley, Ismail Yesildirek
+*
+* Bit by bit (non-restoring) integer square roots, replacing the bisection
+* of main.c. Each bit of the root takes one subtract and compare, 16 steps
+* for a 32 bit argument and 32 for a 64 bit one. The steps use the carry of
+* the compare as a mask instead of a branch, so every argument takes the
+* same number of cycles, and there is no multiply.
+*
+* With the ARM compiler the routines are Thumb-1 embedded assembly. With
+* any other compiler, the host benchmark in tools/ for one, the C versions
+* below do the same steps.
+******************************************************************************/
+
+#include "my_sqrt.h"
+
+#if defined(__CC_ARM)
+
+/**
+* @brief my_sqrt finds the square root of a 32 bit integer, 16 steps.
+*
+*	The root is built from the top bit down: a bit is kept when the rest of x
+*	is at least root + bit, and then root + bit is taken off x.
+*
+* @param[in] x is the integer you wish to find a square root for
+*
+* @return floor(sqrt(x))
+*/
+__asm uint32_t my_sqrt(uint32_t x)
+{
+	PUSH	{r4,lr}
+	MOVS	r1,#0				; root is r1
+	MOVS	r2,#1				; bit is r2, 1 << 30, the highest even bit
+	LSLS	r2,r2,#30
+sq32_loop
+	ADDS	r3,r1,r2		; t <- root + bit
+	LSRS	r1,r1,#1		; root <- root/2
+	CMP		r0,r3				; carry set if x >= t
+	SBCS	r4,r4				; r4 <- 0 if x >= t, else -1
+	MVNS	r4,r4				; mask, -1 if x >= t
+	ANDS	r3,r4
+	SUBS	r0,r0,r3		; x <- x - t if x >= t
+	ANDS	r4,r2
+	ADDS	r1,r1,r4		; root <- root + bit if x >= t
+	LSRS	r2,r2,#2		; next bit, 0 after the 16th step
+	BNE		sq32_loop
+	MOVS	r0,r1
+	POP		{r4,pc}
+}
+
+/**
+* @brief my_sqrt64 finds the square root of a 64 bit integer, 32 steps.
+*
+*	Two bits of x are moved into a remainder per step and the root grows by
+*	one bit: it is 1 when the remainder is at least root*4 + 1. The
+*	remainder stays below 2^35, so it and x take two registers each.
+*
+* @param[in] x is the integer you wish to find a square root for
+*
+* @return floor(sqrt(x))
+*/
+__asm uint32_t my_sqrt64(uint64_t x)
+{
+	PUSH	{r4-r7,lr}
+	MOVS	r2,#0				; rem is r3:r2
+	MOVS	r3,#0
+	MOVS	r4,#0				; root is r4
+	MOVS	r7,#32			; steps, kept in r12
+	MOV		r12,r7
+sq64_loop
+	LSLS	r3,r3,#2		; rem <- rem*4 + top two bits of x
+	LSRS	r7,r2,#30
+	ORRS	r3,r7
+	LSLS	r2,r2,#2
+	LSRS	r7,r1,#30
+	ORRS	r2,r7
+	LSLS	r1,r1,#2		; x <- x*4
+	LSRS	r7,r0,#30
+	ORRS	r1,r7
+	LSLS	r0,r0,#2
+	LSRS	r6,r4,#30		; t is r6:r5, root*4 + 1
+	LSLS	r5,r4,#2
+	ADDS	r5,r5,#1
+	LSLS	r4,r4,#1		; root <- root*2
+	SUBS	r5,r2,r5		; d is r7:r5, rem - t, carry set if rem >= t
+	MOV		r7,r3				; (MOV leaves the carry alone)
+	SBCS	r7,r6
+	SBCS	r6,r6				; mask, -1 if rem < t
+	EORS	r2,r5				; rem <- rem < t ? rem : d
+	ANDS	r2,r6
+	EORS	r2,r5
+	EORS	r3,r7
+	ANDS	r3,r6
+	EORS	r3,r7
+	ADDS	r6,r6,#1		; root <- root + 1 if rem >= t
+	ORRS	r4,r6
+	MOV		r7,r12			; count the steps
+	SUBS	r7,r7,#1
+	MOV		r12,r7
+	BNE		sq64_loop
+	MOVS	r0,r4
+	POP		{r4-r7,pc}
+}
+
+/**
+* @brief my_sqrt_batch finds the square roots of an array, the my_sqrt steps
+*				inline with no call per element.
+*
+* @param[in] in is the array of integers
+* @param[out] out receives floor(sqrt(in[i])), which fits 16 bits
+* @param[in] n is the number of elements
+*/
+__asm void my_sqrt_batch(const uint32_t *in, uint16_t *out, uint32_t n)
+{
+	PUSH	{r4-r7,lr}
+	CMP		r2,#0
+	BEQ		sqb_done
+sqb_next
+	LDM		r0!,{r3}		; x is r3, the next element
+	MOVS	r4,#0				; root is r4
+	MOVS	r5,#1				; bit is r5
+	LSLS	r5,r5,#30
+sqb_loop
+	ADDS	r6,r4,r5		; same steps as my_sqrt
+	LSRS	r4,r4,#1
+	CMP		r3,r6
+	SBCS	r7,r7
+	MVNS	r7,r7
+	ANDS	r6,r7
+	SUBS	r3,r3,r6
+	ANDS	r7,r5
+	ADDS	r4,r4,r7
+	LSRS	r5,r5,#2
+	BNE		sqb_loop
+	STRH	r4,[r1]			; *out++ <- root
+	ADDS	r1,r1,#2
+	SUBS	r2,r2,#1
+	BNE		sqb_next
+sqb_done
+	POP		{r4-r7,pc}
+}
+
+#else
+
+/**
+* @brief my_sqrt finds the square root of a 32 bit integer, 16 steps.
+*
+* @param[in] x is the integer you wish to find a square root for
+*
+* @return floor(sqrt(x))
+*/
+uint32_t my_sqrt(uint32_t x)
+{
+	uint32_t root = 0, bit = 1UL << 30, t, mask;
+	do
+	{
+		t = root + bit;
+		root >>= 1;
+		mask = 0 - (uint32_t)(x >= t);		// -1 if x >= t
+		x -= t & mask;
+		root += bit & mask;
+		bit >>= 2;
+	} while(bit != 0);
+	return root;
+}
+
+/**
+* @brief my_sqrt64 finds the square root of a 64 bit integer, 32 steps.
+*
+* @param[in] x is the integer you wish to find a square root for
+*
+* @return floor(sqrt(x))
+*/
+uint32_t my_sqrt64(uint64_t x)
+{
+	uint64_t rem = 0, t, mask;
+	uint32_t root = 0;
+	int i;
+	for(i = 0; i < 32; i++)
+	{
+		rem = (rem << 2) | (x >> 62);
+		x <<= 2;
+		t = ((uint64_t)root << 2) + 1;
+		root <<= 1;
+		mask = 0 - (uint64_t)(rem >= t);		// -1 if rem >= t
+		rem -= t & mask;
+		root |= (uint32_t)mask & 1;
+	}
+	return root;
+}
+
+/**
+* @brief my_sqrt_batch finds the square roots of an array
+*
+* @param[in] in is the array of integers
+* @param[out] out receives floor(sqrt(in[i])), which fits 16 bits
+* @param[in] n is the number of elements
+*/
+void my_sqrt_batch(const uint32_t *in, uint16_t *out, uint32_t n)
+{
+	while(n-- != 0) *out++ = (uint16_t)my_sqrt(*in++);
+}
+
+#endif
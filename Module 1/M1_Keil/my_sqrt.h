@@ -0,0 +1,28 @@
+/************************************************************************//**
+* \file my_sqrt.h
+* \brief ECEN 5803 Project 1, Module 1, integer square roots
+*
+*	Authors: David Pasley, Ismail Yesildirek
+*
+* Prototypes of the square root routines in my_sqrt.c. All of them return
+* floor(sqrt(x)).
+******************************************************************************/
+
+#ifndef MY_SQRT_H
+#define MY_SQRT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t my_sqrt(uint32_t x);
+uint32_t my_sqrt64(uint64_t x);
+void my_sqrt_batch(const uint32_t *in, uint16_t *out, uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Host check and benchmark for ../my_sqrt.c.
+ *
+ * Checks my_sqrt on every argument below 2^24 and around every square above, my_sqrt64 on the squares and
+ * their neighbours and on random arguments, and my_sqrt_batch against
+ * my_sqrt. Then prints the time per call of each routine and of a C copy of
+ * the bisection in main.c. The times are for the host; the cycles on the
+ * KL25Z are in bench_table after main has run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "my_sqrt.h"
+
+#define BATCH 4096
+
+/* the bisection of main.c, step for step */
+static int bisect(int x)
+{
+	int a = 0, b = 65536, c = 0, c_old;
+	do
+	{
+		c_old = c;
+		c = (int)(((unsigned)a + (unsigned)b) >> 1);
+		if(c * c == x) return c;
+		if(c * c < x) a = c;
+		else b = c;
+	} while(c != c_old);
+	return c;
+}
+
+/* floor(sqrt(x)) by Newton's method, for checking */
+static uint64_t ref64(uint64_t x)
+{
+	uint64_t r = x, s;
+	if(x < 2) return x;
+	s = (x >> 1) + (x & 1);
+	while(s < r)
+	{
+		r = s;
+		s = (r + x / r) >> 1;
+	}
+	return r;
+}
+
+static uint64_t rnd64(void)
+{
+	static uint64_t s = 0x9E3779B97F4A7C15ULL;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int fails;
+
+static void fail(const char *name, uint64_t x, uint64_t got, uint64_t want)
+{
+	if(fails++ < 10)
+		printf("FAIL %s(%llu) = %llu, want %llu\n", name,
+			(unsigned long long)x, (unsigned long long)got, (unsigned long long)want);
+}
+
+int main(void)
+{
+	static uint32_t in[BATCH];
+	static uint16_t out[BATCH];
+	volatile uint32_t sink = 0;
+	uint64_t x, r;
+	uint32_t i, n, root;
+	double t;
+
+	/* my_sqrt, every argument below 2^24: the root steps up at each square */
+	root = 0;
+	for(x = 0; x < 0x1000000; x++)
+	{
+		if((root + 1) * (root + 1) == x) root++;
+		r = my_sqrt((uint32_t)x);
+		if(r != root) fail("my_sqrt", x, r, root);
+	}
+	/* and either side of every square above */
+	for(root = 0x1000; root <= 0xFFFF; root++)
+	{
+		x = (uint64_t)root * root;
+		if(my_sqrt((uint32_t)x) != root) fail("my_sqrt", x, my_sqrt((uint32_t)x), root);
+		if(my_sqrt((uint32_t)x - 1) != root - 1) fail("my_sqrt", x - 1, my_sqrt((uint32_t)x - 1), root - 1);
+		if(my_sqrt((uint32_t)(x + 2 * root)) != root) fail("my_sqrt", x + 2 * root, my_sqrt((uint32_t)(x + 2 * root)), root);
+	}
+	if(my_sqrt(0xFFFFFFFFUL) != 0xFFFF) fail("my_sqrt", 0xFFFFFFFFUL, my_sqrt(0xFFFFFFFFUL), 0xFFFF);
+
+	/* my_sqrt64, around every square of a 32 bit root and at random */
+	for(x = 0; x < 0x100000000ULL; x += 1 + (x >> 12))
+	{
+		uint64_t sq = x * x;
+		if(my_sqrt64(sq) != x) fail("my_sqrt64", sq, my_sqrt64(sq), x);
+		if(x != 0 && my_sqrt64(sq - 1) != x - 1) fail("my_sqrt64", sq - 1, my_sqrt64(sq - 1), x - 1);
+		if(x != 0xFFFFFFFFULL && my_sqrt64(sq + 2 * x) != x) fail("my_sqrt64", sq + 2 * x, my_sqrt64(sq + 2 * x), x);
+	}
+	if(my_sqrt64(0xFFFFFFFFFFFFFFFFULL) != 0xFFFFFFFFUL)
+		fail("my_sqrt64", 0xFFFFFFFFFFFFFFFFULL, my_sqrt64(0xFFFFFFFFFFFFFFFFULL), 0xFFFFFFFFUL);
+	for(i = 0; i < 1000000; i++)
+	{
+		x = rnd64() >> (i & 63);
+		r = ref64(x);
+		if(my_sqrt64(x) != r) fail("my_sqrt64", x, my_sqrt64(x), r);
+	}
+
+	/* my_sqrt_batch, against my_sqrt */
+	for(i = 0; i < BATCH; i++) in[i] = (uint32_t)rnd64();
+	in[0] = 0;
+	in[1] = 0xFFFFFFFFUL;
+	my_sqrt_batch(in, out, BATCH);
+	for(i = 0; i < BATCH; i++)
+		if(out[i] != my_sqrt(in[i])) fail("my_sqrt_batch", in[i], out[i], my_sqrt(in[i]));
+
+	/* the bisection is only right below 2^30, where c*c cannot overflow */
+	for(i = 0; i < 1000000; i++)
+	{
+		x = rnd64() >> 34;
+		if((uint32_t)bisect((int)x) != my_sqrt((uint32_t)x))
+			fail("bisect", x, bisect((int)x), my_sqrt((uint32_t)x));
+	}
+
+	if(fails)
+	{
+		printf("%d failures\n", fails);
+		return 1;
+	}
+	printf("my_sqrt, my_sqrt64, my_sqrt_batch: ok\n\n");
+
+	for(i = 0; i < BATCH; i++) in[i] = (uint32_t)(rnd64() >> 34);
+	n = 2000;
+
+	printf("%-14s %10s\n", "routine", "ns/call");
+	t = now();
+	for(x = 0; x < n; x++)
+		for(i = 0; i < BATCH; i++) sink += bisect((int)in[i]);
+	printf("%-14s %10.2f\n", "bisect", (now() - t) * 1e9 / ((double)n * BATCH));
+	t = now();
+	for(x = 0; x < n; x++)
+		for(i = 0; i < BATCH; i++) sink += my_sqrt(in[i]);
+	printf("%-14s %10.2f\n", "my_sqrt", (now() - t) * 1e9 / ((double)n * BATCH));
+	t = now();
+	for(x = 0; x < n; x++)
+		for(i = 0; i < BATCH; i++) sink += my_sqrt64((uint64_t)in[i] << 32);
+	printf("%-14s %10.2f\n", "my_sqrt64", (now() - t) * 1e9 / ((double)n * BATCH));
+	t = now();
+	for(x = 0; x < n; x++)
+	{
+		my_sqrt_batch(in, out, BATCH);
+		sink += out[x & (BATCH - 1)];
+	}
+	printf("%-14s %10.2f\n", "my_sqrt_batch", (now() - t) * 1e9 / ((double)n * BATCH));
+	return 0;
+}
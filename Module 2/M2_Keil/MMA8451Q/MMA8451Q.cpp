@@ -18,15 +18,34 @@
 
 #include "MMA8451Q.h"
 
+#define REG_F_STATUS      0x00
 #define REG_WHO_AM_I      0x0D
+#define REG_F_SETUP       0x09
 #define REG_CTRL_REG_1    0x2A
+#define REG_CTRL_REG_4    0x2D
+#define REG_CTRL_REG_5    0x2E
 #define REG_OUT_X_MSB     0x01
 #define REG_OUT_Y_MSB     0x03
 #define REG_OUT_Z_MSB     0x05
 
-#define UINT14_MAX        16383
+#define CTRL_REG_1_ACTIVE 0x01
+#define F_STATUS_OVF      0x80
+#define F_STATUS_CNT      0x3F
+#define F_SETUP_CIRCULAR  0x40  // F_MODE = 01, oldest sample overwritten
+#define INT_FIFO          0x40  // FIFO bit in CTRL_REG4 (enable), CTRL_REG5 (INT1)
 
-MMA8451Q::MMA8451Q(PinName sda, PinName scl, int addr) : m_i2c(sda, scl), m_addr(addr) {
+#define FIFO_SIZE         32
+#define SAMPLE_BYTES      6     // X, Y, Z, MSB first
+#define I2C_FAST_HZ       400000
+
+// 14 bit left justified, MSB first, to counts
+static inline int16_t toCounts(const uint8_t * b) {
+    return (int16_t)((b[0] << 8) | b[1]) >> 2;
+}
+
+MMA8451Q::MMA8451Q(PinName sda, PinName scl, int addr) : m_i2c(sda, scl), m_addr(addr), m_fifo(false) {
+    // fast mode, 800 Hz of XYZ bursts does not fit in 100 kHz
+    m_i2c.frequency(I2C_FAST_HZ);
     // activate the peripheral
     uint8_t data[2] = {REG_CTRL_REG_1, 0x01};
     writeRegs(data, 2);
@@ -53,9 +72,74 @@ float MMA8451Q::getAccZ() {
 }
 
 void MMA8451Q::getAccAllAxis(float * res) {
-    res[0] = getAccX();
-    res[1] = getAccY();
-    res[2] = getAccZ();
+    int16_t acc[3];
+    getAccAllAxisRaw(acc);
+    res[0] = float(acc[0])/4096.0f;
+    res[1] = float(acc[1])/4096.0f;
+    res[2] = float(acc[2])/4096.0f;
+}
+
+void MMA8451Q::getAccAllAxisRaw(int16_t * res) {
+    uint8_t raw[SAMPLE_BYTES];
+    readRegs(REG_OUT_X_MSB, raw, SAMPLE_BYTES);
+    res[0] = toCounts(&raw[0]);
+    res[1] = toCounts(&raw[2]);
+    res[2] = toCounts(&raw[4]);
+}
+
+void MMA8451Q::enableFifo(uint8_t watermark) {
+    if (watermark < 1) watermark = 1;
+    if (watermark > FIFO_SIZE) watermark = FIFO_SIZE;
+    // F_SETUP and the interrupt routing only change in standby
+    setActive(false);
+    uint8_t setup[2] = {REG_F_SETUP, (uint8_t)(F_SETUP_CIRCULAR | watermark)};
+    writeRegs(setup, 2);
+    uint8_t int_en[2] = {REG_CTRL_REG_4, INT_FIFO};
+    writeRegs(int_en, 2);
+    uint8_t int_cfg[2] = {REG_CTRL_REG_5, INT_FIFO};
+    writeRegs(int_cfg, 2);
+    setActive(true);
+    m_fifo = true;
+}
+
+void MMA8451Q::disableFifo() {
+    setActive(false);
+    uint8_t setup[2] = {REG_F_SETUP, 0};
+    writeRegs(setup, 2);
+    uint8_t int_en[2] = {REG_CTRL_REG_4, 0};
+    writeRegs(int_en, 2);
+    setActive(true);
+    m_fifo = false;
+}
+
+int MMA8451Q::fifoCount() {
+    uint8_t status = 0;
+    readRegs(REG_F_STATUS, &status, 1);
+    if (status & F_STATUS_OVF)
+        return -1;
+    return status & F_STATUS_CNT;
+}
+
+int MMA8451Q::readSamples(int16_t * res, int n) {
+    int count = 1;
+    if (m_fifo) {
+        count = fifoCount();
+        if (count < 0)
+            count = FIFO_SIZE;
+    }
+    if (count > n)
+        count = n;
+    if (count <= 0)
+        return 0;
+
+    // In FIFO mode the register pointer wraps from OUT_Z_LSB back to
+    // OUT_X_MSB, so one burst drains count samples.  The bytes land in
+    // res and are converted in place, each pair to the int16_t it fills.
+    uint8_t * raw = (uint8_t *)res;
+    readRegs(REG_OUT_X_MSB, raw, count * SAMPLE_BYTES);
+    for (int i = 0; i < count * 3; i++)
+        res[i] = toCounts(&raw[2 * i]);
+    return count;
 }
 
 int16_t MMA8451Q::getAccAxis(uint8_t addr) {
@@ -63,13 +147,22 @@ int16_t MMA8451Q::getAccAxis(uint8_t addr) {
     uint8_t res[2];
     readRegs(addr, res, 2);
 
-    acc = (res[0] << 6) | (res[1] >> 2);
-    if (acc > UINT14_MAX/2)
-        acc -= UINT14_MAX;
+    acc = toCounts(res);
 
     return acc;
 }
 
+void MMA8451Q::setActive(bool active) {
+    uint8_t ctrl = 0;
+    readRegs(REG_CTRL_REG_1, &ctrl, 1);
+    if (active)
+        ctrl |= CTRL_REG_1_ACTIVE;
+    else
+        ctrl &= ~CTRL_REG_1_ACTIVE;
+    uint8_t data[2] = {REG_CTRL_REG_1, ctrl};
+    writeRegs(data, 2);
+}
+
 void MMA8451Q::readRegs(int addr, uint8_t * data, int len) {
     char t[1] = {addr};
     m_i2c.write(m_addr, t, 1, true);
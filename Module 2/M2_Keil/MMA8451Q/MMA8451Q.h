@@ -45,6 +45,30 @@
 *     }
 * }
 * @endcode
+*
+* For streaming at the full 800 Hz output data rate, let the sensor buffer
+* samples in its 32 sample FIFO and drain them in one burst when the
+* watermark interrupt fires:
+*
+* @code
+* MMA8451Q acc(PTE25, PTE24, MMA8451_I2C_ADDRESS);
+* InterruptIn acc_int1(PTA14);           // INT1 on the FRDM-KL25Z
+* volatile bool fifo_ready = false;
+* void on_watermark() { fifo_ready = true; }
+*
+* int main(void) {
+*     int16_t xyz[3 * 16];
+*     acc_int1.fall(&on_watermark);      // INT1 is active low
+*     acc.enableFifo(16);
+*     while (true) {
+*         if (fifo_ready) {
+*             fifo_ready = false;
+*             int n = acc.readSamples(xyz, 16);
+*             // xyz[3*i], xyz[3*i+1], xyz[3*i+2] = X, Y, Z of sample i
+*         }
+*     }
+* }
+* @endcode
 */
 class MMA8451Q
 {
@@ -98,11 +122,54 @@ public:
    */
   void getAccAllAxis(float * res);
 
+  /**
+   * Get XYZ axis acceleration as raw counts, one burst read of all
+   * three axes
+   *
+   * @param res array where X, Y, Z will be stored, 4096 counts per g
+   */
+  void getAccAllAxisRaw(int16_t * res);
+
+  /**
+   * Turn on the 32 sample FIFO in circular mode, with the watermark
+   * interrupt on INT1 (active low).  While it is on, the getAcc calls
+   * also take their sample from the FIFO.
+   *
+   * @param watermark samples in the FIFO that raise the interrupt, 1..32
+   */
+  void enableFifo(uint8_t watermark);
+
+  /**
+   * Turn the FIFO off, the output registers hold the latest sample again
+   */
+  void disableFifo();
+
+  /**
+   * Get the number of samples waiting in the FIFO
+   *
+   * @returns 0..32, or -1 if the FIFO overflowed since the last read
+   * (the oldest samples were lost, the FIFO still holds 32)
+   */
+  int fifoCount();
+
+  /**
+   * Read buffered XYZ samples as raw counts.  With the FIFO on, reads up to
+   * n of the samples waiting in one burst; with it off, reads the current
+   * sample.
+   *
+   * @param res array of 3 * n int16_t, X, Y, Z of each sample in turn
+   * @param n most samples to read
+   * @returns samples read
+   */
+  int readSamples(int16_t * res, int n);
+
 private:
   I2C m_i2c;
   int m_addr;
+  bool m_fifo;
   void readRegs(int addr, uint8_t * data, int len);
   void writeRegs(uint8_t * data, int len);
+  void setActive(bool active);
   int16_t getAccAxis(uint8_t addr);
 
 };
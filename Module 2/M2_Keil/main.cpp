@@ -41,15 +41,18 @@ int main(void)
     PwmOut bled(LED3); //!< PWM output for BLUE LED
 	  
 	  float t; //!< Holds touch slider percentage
+	  float xyz[3]; //!< Holds X, Y, Z acceleration (g)
 /* @brief Read touch slider and write to LED based on position */	
     while (1)
 		{
 			  // read touch slider percentage
 			  t = tsi.readPercentage();	
+				// read all three axes in one I2C burst
+				acc.getAccAllAxis(xyz);
 				// generate RGB values from touch slider & accelerometer
-        rled = t + abs(acc.getAccZ());
-        gled = t + abs(acc.getAccY());
-        bled = t + abs(acc.getAccX());
+        rled = t + abs(xyz[2]);
+        gled = t + abs(xyz[1]);
+        bled = t + abs(xyz[0]);
 			  // 10 Hz update rate
         wait(0.1f);
 			  i++;
@@ -30,9 +30,25 @@
 */              
 
 #include <stdio.h>
+#include <string.h>
 #include "shared.h"
+
+#define REPORT_MAX_CHARS 244 /* longest status report, header included */
+#define PROF_LINE_CHARS 90   /* one line of the profile report */
+#define HELP_LINE_CHARS 60   /* one line of the command list */
+#define SCHED_LINE_CHARS 40  /* one line of the task table */
+#define REPORT_PERIOD_DEFAULT 16  /* status report every 1.6 s, tenths of a second */
+#define REPORT_PERIOD_MAX 600     /* once a minute */
+
 DigitalOut greenLED(LED_GREEN);
 bool green_led_status = 1; //default is on.
+UCHAR prof_report_line = PROF_STAGES + 1; // next profile line, idle past the last
+static UCHAR help_line = CMD_NONE;        // next command list line, idle past the last
+static UCHAR sched_line = CMD_NONE;       // next task table line, idle past the last
+static uint16_t report_period = REPORT_PERIOD_DEFAULT;  // tenths of a second
+static struct swtimer report_timer;       // sets display_flag every report_period
+static UCHAR cmd_first[26];               // first monitor_cmds[] entry per letter
+#ifdef __CC_ARM
 /*****************************************************************************/
 /// \fn uint32_t getR0(void) 
 /// @brief assembly routine which returns the unaltered contents of register r0
@@ -83,6 +99,15 @@ __asm uint32_t getWord(uint32_t address)
 	LDR r0, [r0]	; data @ r0 -> r0
 	BX lr					; return
 }
+#else
+/*****************************************************************************/
+/// @brief builds without the ARM compiler (host simulator) have no target
+/// registers or memory map to show, the register dump reads as zeros
+/*****************************************************************************/
+uint32_t getR0() { return 0; }
+void getRn(uint32_t reglist[16]) { for(int i=1;i<16;i++) reglist[i] = 0; }
+uint32_t getWord(uint32_t address) { return 0; }
+#endif
 
 
 /*****************************************************************************/
@@ -170,155 +195,513 @@ uint32_t hex2hexInt(uint32_t hex)
 ///
 /// There is deliberate delay in switching between modes to allow the RS-232 cable 
 /// to be plugged into the header without causing problems. 
+///
+/// The command list is longer than the transmit buffer, help_report_poll()
+/// sends it a line at a time.
 /*****************************************************************************/
 void set_display_mode(void)   
 {
-  UART_direct_msg_put("\r\nSelect Mode");
-  UART_direct_msg_put("\r\n Hit NOR - Normal");
-  UART_direct_msg_put("\r\n Hit QUI - Quiet");
-  UART_direct_msg_put("\r\n Hit DEB - Debug" );
-  UART_direct_msg_put("\r\n Hit V - Version#");
-	UART_direct_msg_put("\r\n Hit L - Toggle Green LED");
-  UART_direct_msg_put("\r\nSelect:  ");
+  UART_msg_put("\r\nSelect Mode");
+  help_line = 0;
 }
 
 /*****************************************************************************/
 /// \fn void chk_UART_msg(void) 
-/// @brief checks for messages in serial port
+/// @brief sends the echo of what was typed and processes the command lines
+/// UART0_IRQHandler has queued
 /*****************************************************************************/
 void chk_UART_msg(void)    
 {
-   UCHAR j;
-   while( UART_input() )      // becomes true only when a byte has been received
-   {                                    // skip if no characters pending
-      j = UART_get();                 // get next character
+   UCHAR len;
+   while( UART_input() )      // echo, queued by the interrupt
+   {
+      UART_put(UART_get());
+   }
+   while( UART_line_get(msg_buf, &len) )
+   {                // complete message (all messages end in carriage return)
+      msg_buf_idx = len;
+      UART_msg_process();
+   }
+}
 
-      if( j == '\r' )          // on a enter (return) key press
-      {                // complete message (all messages end in carriage return)
-         UART_msg_process();
-      }
-      else 
-      {
-         if ((j != 0x02) )         // if not ^B
-         {                             // if not command, then   
-            UART_direct_put(j);              // echo the character   
-         }
-         if( j == '\b' ) 
-         {                             // backspace editor
-            if( msg_buf_idx != 0) 
-            {                       // if not 1st character then destructive 
-               UART_direct_msg_put(" \b");// backspace
-               msg_buf_idx--;
-            }
-         }
-         else if( msg_buf_idx >= MSG_BUF_SIZE )  
-         {                                // check message length too large
-            msg_buf_idx = 0;
-         }
-         else if ((display_mode == QUIET) && (msg_buf[0] != 0x02) && 
-                  (msg_buf[0] != 'D') && (msg_buf[0] != 'd') && 
-									(msg_buf[0] != 'N') && (msg_buf[0] != 'n') &&
-                  (msg_buf[0] != 'V') && (msg_buf[0] != 'v') &&
-									(msg_buf[0] != 'L') && (msg_buf[0] != 'l') &&
-                  (msg_buf_idx != 0))
-         {                          // if first character is bad in Quiet mode
-            msg_buf_idx = 0;        // then start over
-         }
-         else {                        // not complete message, store character
- 
-            msg_buf[msg_buf_idx] = j;
-            msg_buf_idx++;
-         }
-      }
+/*****************************************************************************/
+/// \fn static void report_restart(void)
+/// @brief the next status report a whole report_period from now
+/*****************************************************************************/
+static void report_restart(void)
+{
+   uint32_t ticks = (uint32_t)report_period*(SEC/10);
+   swt_start(&report_timer, ticks, ticks);
+}
+
+/*****************************************************************************/
+/// Command handlers, one per entry of monitor_cmds[].  argc numbers are in
+/// argv, already checked against the entry's min and max.  A handler
+/// returns 0 for a bad argument, the monitor answers "Error!".
+/*****************************************************************************/
+
+static UCHAR cmd_debug(UCHAR argc, const uint32_t *argv)
+{
+   display_mode = DEBUG;
+   UART_msg_put("\r\nMode=DEBUG\n");
+   return 1;
+}
+
+static UCHAR cmd_normal(UCHAR argc, const uint32_t *argv)
+{
+   display_mode = NORMAL;
+   UART_msg_put("\r\nMode=NORMAL\n");
+   return 1;
+}
+
+static UCHAR cmd_quiet(UCHAR argc, const uint32_t *argv)
+{
+   display_mode = QUIET;
+   UART_msg_put("\r\nMode=QUIET\n");
+   return 1;
+}
+
+static UCHAR cmd_version(UCHAR argc, const uint32_t *argv)
+{
+   UART_msg_put("\r\n");
+   UART_msg_put( CODE_VERSION ); 
+   return 1;
+}
+
+static UCHAR cmd_stats(UCHAR argc, const uint32_t *argv)
+{
+   sched_line = 0;
+   return 1;
+}
+
+static UCHAR cmd_profile(UCHAR argc, const uint32_t *argv)
+{
+   prof_report_start();
+   return 1;
+}
+
+static UCHAR cmd_profile_clear(UCHAR argc, const uint32_t *argv)
+{
+   prof_reset();
+   UART_msg_put("\r\nProfile cleared");
+   return 1;
+}
+
+static UCHAR cmd_freq(UCHAR argc, const uint32_t *argv)
+{
+   if(argc == 0)
+   {
+      freq_engine_report();
+      return 1;
    }
+   if(argv[0] > 0xFF || !freq_engine_select(argv[0])) return 0;
+   UART_msg_put("\r\nFrequency engine: ");
+   UART_msg_put(freq_engine_get(freq_engine_current())->name);
+   return 1;
+}
+
+static UCHAR cmd_freq_beside(UCHAR argc, const uint32_t *argv)
+{
+   if(argc == 0) freq_engine_compare(FREQ_ENGINE_NONE);
+   else if(argv[0] >= FREQ_ENGINE_NONE || !freq_engine_compare(argv[0])) return 0;
+   freq_engine_report();
+   return 1;
+}
+
+static UCHAR cmd_fft(UCHAR argc, const uint32_t *argv)
+{
+   if(argc != 0 && (argc < 2 || argv[0] > 0xFF || argv[1] > 0xFF ||
+                    !fp_config(argv[0], argv[1])))
+      return 0;
+   fft_report();
+   return 1;
+}
+
+static UCHAR cmd_bench(UCHAR argc, const uint32_t *argv)
+{
+   fmt_bench_report();
+   return 1;
+}
+
+static UCHAR cmd_binary(UCHAR argc, const uint32_t *argv)
+{
+   if(argc != 0 && (argv[0] > TEL_EVERY_MAX || !tel_config(argv[0]))) return 0;
+   display_mode = BINARY;
+   UART_msg_put("\r\nMode=BINARY, every ");
+   UART_put('0' + tel_every());
+   UART_msg_put("\n");
+   return 1;
+}
+
+static UCHAR cmd_led(UCHAR argc, const uint32_t *argv)
+{
+   greenLED = !greenLED;	
+   green_led_status = !green_led_status;
+   UART_msg_put("\r\nGreen LED");
+   if (green_led_status ==0){
+      UART_msg_put(" OFF"); 
+   }
+   else
+   {
+      UART_msg_put(" ON");
+   }
+   return 1;
+}
+
+static UCHAR cmd_rate(UCHAR argc, const uint32_t *argv)
+{
+   if(argc != 0)
+   {
+      if(argv[0] < 1 || argv[0] > REPORT_PERIOD_MAX) return 0;
+      report_period = argv[0];      // report_restart() after every command
+   }
+   UART_msg_put("\r\nReport every ");
+   UART_dec_put(report_period, 1);
+   UART_msg_put(" s");
+   return 1;
+}
+
+static UCHAR cmd_avg(UCHAR argc, const uint32_t *argv)
+{
+   if(argc != 0 && (argv[0] > 0xFF || !flow_engine_avg(argv[0]))) return 0;
+   UART_msg_put("\r\nSt average of 2^");
+   UART_dec_put(flow_engine_params()->st_shift, 0);
+   UART_msg_put(" updates");
+   return 1;
+}
+
+static UCHAR cmd_pipe(UCHAR argc, const uint32_t *argv)
+{
+   const struct flow_params *p = flow_engine_params();
+   if(argc != 0 && (argc < 2 || argv[0] > 0xFFFF || argv[1] > 0xFFFF ||
+                    !flow_engine_pipe(argv[0], argv[1])))
+      return 0;
+   UART_msg_put("\r\nPipe ");
+   UART_dec_put(p->pid, 3);
+   UART_msg_put(" in, bluff body ");
+   UART_dec_put(p->d, 3);
+   UART_msg_put(" in");
+   return 1;
+}
+
+static UCHAR cmd_tick(UCHAR argc, const uint32_t *argv)
+{
+   const struct tick_stat *t = pit_tick_stat();
+   if(argc != 0 && (argv[0] > 0xFFFF || !pit_tick_period(argv[0]))) return 0;
+   UART_msg_put("\r\nTick ");
+   UART_dec_put(t->period_us, 0);
+   UART_msg_put(" us, runs ");
+   UART_dec_put(t->runs, 0);
+   UART_msg_put("\r\nLatency cycles min avg max ");
+   UART_dec_put(t->runs ? t->lat_min : 0, 0);
+   UART_put(' ');
+   UART_dec_put(t->lat_avg, 0);
+   UART_put(' ');
+   UART_dec_put(t->lat_max, 0);
+   UART_msg_put("\r\ntimer0 cycles avg max ");
+   UART_dec_put(t->exec_avg, 0);
+   UART_put(' ');
+   UART_dec_put(t->exec_max, 0);
+   UART_msg_put("\r\nMasked cycles max ");
+   UART_dec_put(t->mask_max, 0);
+   UART_msg_put(", missed ticks ");
+   UART_dec_put(t->missed, 0);
+   return 1;
+}
+
+static UCHAR cmd_log(UCHAR argc, const uint32_t *argv)
+{
+   const struct flog_stat *l;
+   if(argc != 0 && (argv[0] > 0xFFFF || !flog_config(argv[0]))) return 0;
+   l = flog_stat_get();
+   UART_msg_put("\r\nLog every ");
+   UART_dec_put(l->every, 0);
+   UART_msg_put(" s, boot ");
+   UART_dec_put(l->boot, 0);
+   UART_msg_put(", sectors ");
+   UART_dec_put(l->sectors, 0);
+   UART_msg_put(" erasing ");
+   UART_dec_put(l->erasing, 0);
+   UART_msg_put("\r\nRecords ");
+   UART_dec_put(l->records, 0);
+   UART_msg_put(", staged ");
+   UART_dec_put(l->staged, 0);
+   UART_msg_put(", dropped ");
+   UART_dec_put(l->drops, 0);
+   UART_msg_put("\r\nErases ");
+   UART_dec_put(l->erases, 0);
+   UART_msg_put(", errors ");
+   UART_dec_put(l->errors, 0);
+   UART_msg_put(", slices max ");
+   UART_dec_put(l->slices_max, 0);
+   UART_msg_put(", timeouts ");
+   UART_dec_put(l->erase_timeouts, 0);
+   UART_msg_put("\r\nStall cycles ");
+   UART_dec_put(l->stall_max, 0);
+   return 1;
+}
+
+static UCHAR cmd_log_clear(UCHAR argc, const uint32_t *argv)
+{
+   flog_clear();
+   UART_msg_put("\r\nLog cleared");
+   return 1;
+}
+
+static UCHAR cmd_log_dump(UCHAR argc, const uint32_t *argv)
+{
+   flog_dump_start();
+   return 1;
+}
+
+static UCHAR cmd_trace(UCHAR argc, const uint32_t *argv)
+{
+   if(argc != 0)
+   {
+      if(argv[0] > 0xFF) return 0;
+      trace_config(argv[0]);
+   }
+   UART_msg_put("\r\nTrace classes ");
+   UART_dec_put(trace_classes(), 0);
+   UART_msg_put(", events loop ");
+   UART_dec_put(trace_count(TRACE_RING_LOOP), 0);
+   UART_msg_put(" interrupts ");
+   UART_dec_put(trace_count(TRACE_RING_IRQ), 0);
+   return 1;
+}
+
+static UCHAR cmd_trace_dump(UCHAR argc, const uint32_t *argv)
+{
+   trace_dump_start();
+   return 1;
+}
+
+static UCHAR cmd_aout(UCHAR argc, const uint32_t *argv)
+{
+   const struct aout_stat *a = aout_stat_get();
+   UART_msg_put("\r\n4-20 mA out ");
+   UART_dec_put(a->out_ua/10, 2);
+   UART_msg_put(" mA, for ");
+   UART_dec_put(a->target_ua/10, 2);
+   UART_msg_put(a->fault ? " mA, FAULT" : " mA");
+   UART_msg_put("\r\nRange ");
+   UART_dec_put(a->flow_lo, 2);
+   UART_msg_put(" to ");
+   UART_dec_put(a->flow_hi, 2);
+   UART_msg_put(" GPM, slew ");
+   UART_dec_put(a->slew, 0);
+   UART_msg_put(" mA/s, alarm ");
+   UART_dec_put(a->alarm_ua/10, 2);
+   UART_msg_put(" mA\r\nRamps ");
+   UART_dec_put(a->ramps, 0);
+   UART_msg_put(", faults ");
+   UART_dec_put(a->faults, 0);
+   return 1;
+}
+
+static UCHAR cmd_aout_alarm(UCHAR argc, const uint32_t *argv)
+{
+   if(argv[0] > 0xFFFF || !aout_alarm(argv[0])) return 0;
+   return cmd_aout(0, argv);
+}
+
+static UCHAR cmd_aout_range(UCHAR argc, const uint32_t *argv)
+{
+   if(argv[0] > AOUT_FLOW_MAX || argv[1] > AOUT_FLOW_MAX ||
+      !aout_range(argv[0]*100, argv[1]*100))
+      return 0;
+   return cmd_aout(0, argv);
+}
+
+static UCHAR cmd_aout_slew(UCHAR argc, const uint32_t *argv)
+{
+   if(argv[0] > 0xFFFF || !aout_slew(argv[0])) return 0;
+   return cmd_aout(0, argv);
+}
+
+static UCHAR cmd_pulse(UCHAR argc, const uint32_t *argv)
+{
+   const struct pulse_stat *p = pulse_stat_get();
+   UART_msg_put("\r\nPulse out ");
+   UART_dec_put(p->hz, 2);
+   UART_msg_put(" Hz, K ");
+   UART_dec_put(p->k, 3);
+   UART_msg_put(p->gated ? " per gallon, gated" : " per gallon");
+   UART_msg_put("\r\nTPM0 MOD ");
+   UART_dec_put(p->mod, 0);
+   UART_msg_put(" prescale 2^");
+   UART_dec_put(p->ps, 0);
+   UART_msg_put("\r\nOwed ");
+   UART_dec_put(p->owed, 0);
+   UART_msg_put(", behind ");
+   if(p->lag < 0)
+   {
+      UART_put('-');
+      UART_dec_put(-p->lag, 3);
+   }
+   else UART_dec_put(p->lag, 3);
+   UART_msg_put("\r\nOverrange ");
+   UART_dec_put(p->overrange, 0);
+   UART_msg_put(", deferred ");
+   UART_dec_put(p->deferred, 0);
+   return 1;
+}
+
+static UCHAR cmd_pulse_k(UCHAR argc, const uint32_t *argv)
+{
+   if(!pulse_k(argv[0])) return 0;
+   return cmd_pulse(0, argv);
+}
+
+static UCHAR cmd_help(UCHAR argc, const uint32_t *argv)
+{
+   help_line = 0;
+   return 1;
+}
+
+/*****************************************************************************/
+/// The monitor commands.  Entries with the same first letter are kept
+/// together, monitor_init() indexes them by it.  Of the names that start a
+/// line the longest is taken, so "FA2" is FA with 2 and "F2" is F with 2.
+/// Numbers follow the name, separated by spaces or commas.  A command
+/// without numbers passes over the rest of the word, as the baseline did,
+/// so "DEBUG", "NORMAL" and "QUIET" are DEB, NOR and QUI.
+/*****************************************************************************/
+static const struct monitor_cmd monitor_cmds[] =
+{
+  /* name   args  modes           handler            help */
+   {"AO",   0, 0, CMD_MODES_ALL,  cmd_aout,          "AO - 4-20 mA Output"},
+   {"AOA",  1, 1, CMD_MODES_ALL,  cmd_aout_alarm,    "AOA<ua> - Fault Current in uA, 0 Holds"},
+   {"AOR",  2, 2, CMD_MODES_ALL,  cmd_aout_range,    "AOR <lo> <hi> - GPM at 4 and 20 mA"},
+   {"AOS",  1, 1, CMD_MODES_ALL,  cmd_aout_slew,     "AOS<n> - Slew Limit n mA/s, 0 None"},
+   {"AVG",  0, 1, CMD_MODES_ALL,  cmd_avg,           "AVG<n> - St Average of 2^n Updates"},
+   {"B",    0, 0, CMD_MODES_ALL,  cmd_bench,         "B - Decimal Format Benchmark"},
+   {"BIN",  0, 1, CMD_MODES_ALL,  cmd_binary,        "BIN<n> - Binary Records Every n Flow Updates"},
+   {"DEB",  0, 0, CMD_MODES_ALL,  cmd_debug,         "DEB - Debug"},
+   {"F",    0, 1, CMD_MODES_ALL,  cmd_freq,          "F - Frequency Engines, F<n> - Select"},
+   {"FA",   0, 1, CMD_MODES_ALL,  cmd_freq_beside,   "FA<n> - Run Engine n Beside, FA - Stop"},
+   {"FT",   0, 2, CMD_MODES_ALL,  cmd_fft,           "FT - FFT Setup, FT<k> <b> - 2^k Points Every b Blocks"},
+   {"H",    0, 0, CMD_MODES_ALL,  cmd_help,          "H - This List"},
+   {"L",    0, 0, CMD_MODES_ALL,  cmd_led,           "L - Toggle Green LED"},
+   {"LOG",  0, 1, CMD_MODES_ALL,  cmd_log,           "LOG - Flash Log, LOG<s> - Record Every s Seconds"},
+   {"LOGC", 0, 0, CMD_MODES_ALL,  cmd_log_clear,     "LOGC - Clear Flash Log"},
+   {"LOGD", 0, 0, CMD_MODES_ALL,  cmd_log_dump,      "LOGD - Send Flash Log, Binary (tools/log_decode)"},
+   {"NOR",  0, 0, CMD_MODES_ALL,  cmd_normal,        "NOR - Normal"},
+   {"P",    0, 0, CMD_MODES_ALL,  cmd_profile,       "P - Profile"},
+   {"PC",   0, 0, CMD_MODES_ALL,  cmd_profile_clear, "PC - Clear Profile"},
+   {"PIPE", 0, 2, CMD_MODES_ALL,  cmd_pipe,          "PIPE <pid> <d> - Pipe and Bluff Body in 0.001 in"},
+   {"PO",   0, 0, CMD_MODES_ALL,  cmd_pulse,         "PO - Pulse Output"},
+   {"POK",  1, 1, CMD_MODES_ALL,  cmd_pulse_k,       "POK<k> - K-Factor, k Pulses per 1000 Gallons"},
+   {"QUI",  0, 0, CMD_NOT_QUIET,  cmd_quiet,         "QUI - Quiet"},
+   {"RATE", 0, 1, CMD_MODES_ALL,  cmd_rate,          "RATE<n> - Report Every n/10 s"},
+   {"S",    0, 0, CMD_MODES_ALL,  cmd_stats,         "S - Task Statistics"},
+   {"TICK", 0, 1, CMD_MODES_ALL,  cmd_tick,          "TICK - Tick Timing, TICK<us> - Set Period"},
+   {"TR",   0, 1, CMD_MODES_ALL,  cmd_trace,         "TR - Trace, TR<m> - Event Classes, Bit n for 0xn0-0xnF"},
+   {"TRD",  0, 0, CMD_MODES_ALL,  cmd_trace_dump,    "TRD - Send Trace, Binary (tools/trace_view)"},
+   {"V",    0, 0, CMD_MODES_ALL,  cmd_version,       "V - Version#"},
+};
+#define MONITOR_CMDS (sizeof(monitor_cmds)/sizeof(monitor_cmds[0]))
+
+/*****************************************************************************/
+///  \fn void monitor_init(void) 
+/// @brief indexes monitor_cmds[] by first letter, call before the first
+/// command
+/*****************************************************************************/
+void monitor_init(void)
+{
+   UCHAR i, c;
+   for(c=0;c<26;c++) cmd_first[c] = CMD_NONE;
+   for(i=MONITOR_CMDS;i>0;i--)     // backwards, the first of each letter stays
+      cmd_first[monitor_cmds[i-1].name[0] - 'A'] = i-1;
+   swt_setup(&report_timer, NULL, NULL, &display_flag);
+   report_restart();
 }
 
 /*****************************************************************************/
 ///  \fn void UART_msg_process(void) 
 /// @brief UART Input Message Processing
+///
+/// Finds the command in msg_buf by the first letter index, then reads its
+/// numbers and calls the handler.  The time taken depends on the commands
+/// that share the first letter, not on how many there are.  A command not
+/// allowed in the display mode is passed over, in QUIET mode that is
+/// everything that is not meant to work there.
 /*****************************************************************************/
 void UART_msg_process(void)
 {
-   UCHAR chr,err=0;
-	 chr = msg_buf[0];
-//   unsigned char  data;
+   const struct monitor_cmd *cmd = NULL, *c;
+   uint32_t argv[CMD_ARGS_MAX];
+   UCHAR argc = 0, err = 0, i, n, first;
 
-      switch( chr ) 
+   first = msg_buf[0] & ~0x20;        // upper case
+   if(msg_buf_idx > 0 && first >= 'A' && first <= 'Z' &&
+      cmd_first[first - 'A'] != CMD_NONE)
+   {
+      for(c = &monitor_cmds[cmd_first[first - 'A']];
+          c < &monitor_cmds[MONITOR_CMDS] && c->name[0] == first; c++)
       {
-         case 'D':
-				 case 'd':
-            if((msg_buf[1] == 'E' || msg_buf[1] == 'e') && 
-							 (msg_buf[2] == 'B' || msg_buf[2] == 'b')) 
-            {
-               display_mode = DEBUG;
-               UART_direct_msg_put("\r\nMode=DEBUG\n");
-               display_timer = 0;
-            }
-            else
-               err = 1;
-            break;
-						
-         case 'N':
-				 case 'n':
-            if((msg_buf[1] == 'O' || msg_buf[1] == 'o') && 
-							 (msg_buf[2] == 'R' || msg_buf[2] == 'r')) 
-            {
-               display_mode = NORMAL;
-               UART_direct_msg_put("\r\nMode=NORMAL\n");
-               //display_timer = 0;
-            }
-            else
-               err = 1;
-            break;
-						
-         case 'Q':
-				 case 'q':
-            if((msg_buf[1] == 'U' || msg_buf[1] == 'u') && 
-							 (msg_buf[2] == 'I' || msg_buf[2] == 'i')) 
-            {
-               display_mode = QUIET;
-               UART_direct_msg_put("\r\nMode=QUIET\n");
-               display_timer = 0;
-            }
-            else
-               err = 1;
-            break;
-									
-         case 'V':
-				 case 'v':
-            //display_mode = VERSION;
-            UART_direct_msg_put("\r\n");
-            UART_direct_msg_put( CODE_VERSION ); 
-            display_timer = 0;
-            break;
-		 
-         case 'L':
-				 case 'l':
-            greenLED = !greenLED;	
-						green_led_status = !green_led_status;
-						//display_mode = LED;
-				    UART_direct_msg_put("\r\nGreen LED");
-						if (green_led_status ==0){
-				    UART_direct_msg_put(" OFF"); 
-						}
-						else
-						{
-						UART_direct_msg_put(" ON");
-						}
-            display_timer = 0;
+         for(n=1; c->name[n] != 0 && n < msg_buf_idx &&
+                  (msg_buf[n] & ~0x20) == c->name[n]; n++);
+         if(c->name[n] == 0 && (cmd == NULL || n > strlen(cmd->name))) cmd = c;
+      }
+   }
+   if(cmd == NULL) err = 1;
+   else if(!(cmd->modes & (1 << display_mode)))
+   {
+      msg_buf_idx = 0;
+      return;                          // not in this mode, pass it over
+   }
+   else
+   {
+      i = strlen(cmd->name);
+      if(cmd->max_args == 0)           // "DEBUG" is DEB
+         while(i < msg_buf_idx && (msg_buf[i] & ~0x20) >= 'A' &&
+               (msg_buf[i] & ~0x20) <= 'Z') i++;
+      while(i < msg_buf_idx && !err)   // the numbers
+      {
+         if(msg_buf[i] == ' ' || msg_buf[i] == ',') { i++; continue; }
+         if(msg_buf[i] < '0' || msg_buf[i] > '9' || argc == CMD_ARGS_MAX)
+         {
+            err = 1;
             break;
-				 
-				default:
-         err = 1;
+         }
+         argv[argc] = 0;
+         while(i < msg_buf_idx && msg_buf[i] >= '0' && msg_buf[i] <= '9')
+         {
+            if(argv[argc] > 99999999) err = 1;    // too long to be meant
+            argv[argc] = argv[argc]*10 + (msg_buf[i++] - '0');
+         }
+         argc++;
+      }
+      if(!err && (argc < cmd->min_args || argc > cmd->max_args)) err = 1;
+      if(!err && !cmd->handler(argc, argv)) err = 1;
+      report_restart();                // the next report after a pause
    }
 
    if( err == 1 )
    {
-      UART_direct_msg_put("\n\rError!");
+      UART_msg_put("\n\rError!");
    }     
    msg_buf_idx = 0;          // put index to start of buffer for next message
 }
 
+/*******************************************************************************/
+///  @brief  sends the next line of the command list when the transmit buffer
+///  has room for it, called every monitor() pass
+/*******************************************************************************/
+void help_report_poll()
+{
+	if(help_line > MONITOR_CMDS || UART_tx_space() < HELP_LINE_CHARS) return;
+	if(help_line == MONITOR_CMDS)
+		UART_msg_put("\r\nSelect:  ");
+	else
+	{
+		UART_msg_put("\r\n Hit ");
+		UART_msg_put(monitor_cmds[help_line].help);
+	}
+	help_line++;
+}
+
 
 /*****************************************************************************/
 ///   \fn   is_hex
@@ -335,6 +718,196 @@ UCHAR is_hex(UCHAR c)
    return 0;
 }
 */
+/*******************************************************************************/
+///  @brief  sends the next line of the scheduler table when the transmit
+///  buffer has room for it, called every monitor() pass: runs, overruns, and
+///  the average and worst run time in core clock cycles (24 bit, so 6 hex
+///  digits), then how much of the last second the core was awake.  The table
+///  is longer than the transmit buffer.
+/*******************************************************************************/
+void sched_report_poll()
+{
+	UCHAR n;
+	const struct sched_task *t;
+	if(sched_line == CMD_NONE || UART_tx_space() < SCHED_LINE_CHARS) return;
+	if(sched_line == 0)
+		UART_msg_put("\r\nTask    runs     ovr  avg    max");
+	else if((t = sched_task_get(sched_line - 1)) != NULL)
+	{
+		UART_msg_put("\r\n");
+		UART_msg_put(t->name);
+		for(n=strlen(t->name); n<8; n++) UART_put(' ');	// pad the name column
+		UART_word_hex_put(t->runs);
+		UART_put(' ');
+		UART_hex_put((t->overruns>>8)&0xFF);
+		UART_hex_put(t->overruns&0xFF);
+		UART_put(' ');
+		UART_hex_put((t->cycles_avg>>16)&0xFF);
+		UART_hex_put((t->cycles_avg>>8)&0xFF);
+		UART_hex_put(t->cycles_avg&0xFF);
+		UART_put(' ');
+		UART_hex_put((t->cycles_max>>16)&0xFF);
+		UART_hex_put((t->cycles_max>>8)&0xFF);
+		UART_hex_put(t->cycles_max&0xFF);
+	}
+	else
+	{
+		UART_msg_put("\r\nAwake ");	// the rest of the last second in WFI
+		UART_dec_put(sched_awake_permille(), 1);
+		UART_put('%');
+		sched_line = CMD_NONE;
+		return;
+	}
+	sched_line++;
+}
+
+/*******************************************************************************/
+///  @brief  output the frequency engines, * marks the one in use and +
+///  the one run beside it, both with their latest frequency
+/*******************************************************************************/
+void freq_engine_report()
+{
+	UCHAR i;
+	const struct freq_engine *e;
+	for(i=0; (e = freq_engine_get(i)) != NULL; i++)
+	{
+		UART_msg_put("\r\n");
+		UART_put('0' + i);
+		UART_put(i == freq_engine_current() ? '*' :
+		         i == freq_engine_compared() ? '+' : ' ');
+		UART_msg_put(e->name);
+		if(i == freq_engine_current() || i == freq_engine_compared())
+		{
+			UART_msg_put("  ");
+			UART_dec_put(e->frequency(), 2);
+		}
+	}
+}
+
+/*******************************************************************************/
+///  @brief  output 24 bits as 6 hex digits, the width of a cycle count
+/*******************************************************************************/
+static void hex24_put(uint32_t x)
+{
+	UART_hex_put((x>>16)&0xFF);
+	UART_hex_put((x>>8)&0xFF);
+	UART_hex_put(x&0xFF);
+}
+
+/*******************************************************************************/
+///  @brief  output the spectral peak engine settings and its core clock
+///  cycles per estimate, last and max
+/*******************************************************************************/
+void fft_report()
+{
+	const struct fft_peak_vars *v = fp_vars();
+	UART_msg_put("\r\nFFT 2^");
+	UART_put('0' + v->log2n);
+	UART_msg_put(" points, every ");
+	UART_hex_put(v->every);
+	UART_msg_put(" blocks, cycles ");
+	hex24_put(v->cycles_last);
+	UART_put(' ');
+	hex24_put(v->cycles_max);
+}
+
+/*******************************************************************************/
+///  @brief  the text UART_hex_int_put(hex2hexInt(x), deci) sends, into a
+///  buffer instead, for fmt_bench_report()
+/*******************************************************************************/
+static UCHAR hex_int_text(char *dst, uint32_t x, UCHAR deci)
+{
+	UCHAR n = 0;
+	int8_t i;
+	bool zeros = true;
+	x = hex2hexInt(x);
+	for(i=7;i>=0;i--)
+	{
+		if(zeros && ((x>>(i*4))&0xF)==0);
+		else
+		{
+			zeros = false;
+			dst[n++] = hex_to_asc((x>>i*4)&0xF);
+			if(i == deci && deci>0) dst[n++] = '.';
+		}
+	}
+	return n;
+}
+
+/*******************************************************************************/
+///  @brief  output the core clock cycles to format the three status values,
+///  Flow, temperature and frequency, by hex2hexInt() and by fmt_dec()
+/*******************************************************************************/
+void fmt_bench_report()
+{
+	const uint32_t x[3] = {Flow, temperature, frequency};
+	static char text[3][FMT_DEC_MAX];	// static, kept whatever the optimizer sees
+	uint32_t start, old_cycles, new_cycles;
+	UCHAR i;
+
+	start = cycle_stamp();
+	for(i=0;i<3;i++) hex_int_text(text[i], x[i], 2);
+	old_cycles = cycles_since(start);
+	start = cycle_stamp();
+	for(i=0;i<3;i++) fmt_dec(text[i], x[i], 2, 0);
+	new_cycles = cycles_since(start);
+
+	UART_msg_put("\r\nFormat cycles, 3 values: hex2hexInt ");
+	UART_dec_put(old_cycles, 0);
+	UART_msg_put(", fmt_dec ");
+	UART_dec_put(new_cycles, 0);
+}
+
+/*******************************************************************************/
+///  @brief  starts the profile report, prof_report_poll() sends it
+/*******************************************************************************/
+void prof_report_start()
+{
+	prof_report_line = 0;
+}
+
+/*******************************************************************************/
+///  @brief  sends the next line of the profile report when the transmit
+///  buffer has room for it, called every monitor() pass.  The whole report
+///  is larger than the buffer, so it goes out one stage at a time.
+///
+///  Per stage: passes, min, max and mean in core clock cycles, then the
+///  histogram counts (bins in prof.cpp)
+/*******************************************************************************/
+void prof_report_poll()
+{
+	const struct prof_stat *p;
+	UCHAR n;
+	
+	if(prof_report_line > PROF_STAGES || UART_tx_space() < PROF_LINE_CHARS) return;
+	
+	if(prof_report_line == 0)
+	{
+		UART_msg_put("\r\nStage    count       min    max   mean   <64  <256   <1k   <4k  <16k  <64k <256k  more");
+	}
+	else
+	{
+		p = prof_stat_get(prof_report_line - 1);
+		UART_msg_put("\r\n");
+		UART_msg_put(p->name);
+		for(n=strlen(p->name); n<9; n++) UART_put(' ');	// pad the name column
+		UART_word_hex_put(p->count);
+		UART_put(' ');
+		hex24_put(p->count ? p->min : 0);
+		UART_put(' ');
+		hex24_put(p->max);
+		UART_put(' ');
+		hex24_put(p->count ? (uint32_t)(p->sum / p->count) : 0);
+		for(n=0; n<PROF_HIST_BINS; n++)
+		{
+			UART_msg_put("  ");
+			UART_hex_put(p->hist[n]>>8);
+			UART_hex_put(p->hist[n]&0xFF);
+		}
+	}
+	prof_report_line++;
+}
+
 /*******************************************************************************/
 ///  @brief  output flow, temperature and velocity
 /*******************************************************************************/
@@ -343,42 +916,63 @@ void status_report()
 	if(display_mode == DEBUG)
 	{//decimal printouts are commented out for debug
 		
-	//UART_direct_msg_put("\r\nFlow (GPM): ");
-	//UART_direct_hex_int_put(hex2hexInt(Flow), 2);
-	UART_direct_msg_put("\r\nFlow (GPM): 0x");
-	UART_direct_word_hex_put(Flow);
-	//UART_direct_msg_put("\r\nTemp (C): ");
-	//UART_direct_hex_int_put(hex2hexInt(temperature), 2);
-	UART_direct_msg_put("\r\nTemp (C): 0x");
-	UART_direct_word_hex_put(temperature);
-	//UART_direct_msg_put("\r\nFreq (Hz): ");
-	//UART_direct_hex_int_put(hex2hexInt(frequency), 2);
-	UART_direct_msg_put("\r\nFreq (Hz): 0x");
-	UART_direct_word_hex_put(frequency);
+	//UART_msg_put("\r\nFlow (GPM): ");
+	//UART_hex_int_put(hex2hexInt(Flow), 2);
+	UART_msg_put("\r\nFlow (GPM): 0x");
+	UART_word_hex_put(Flow);
+	//UART_msg_put("\r\nTemp (C): ");
+	//UART_hex_int_put(hex2hexInt(temperature), 2);
+	UART_msg_put("\r\nTemp (C): 0x");
+	UART_word_hex_put(temperature);
+	//UART_msg_put("\r\nFreq (Hz): ");
+	//UART_hex_int_put(hex2hexInt(frequency), 2);
+	UART_msg_put("\r\nFreq (Hz): 0x");
+	UART_word_hex_put(frequency);
+	if(freq_engine_compared() != FREQ_ENGINE_NONE)
+	{
+		UART_msg_put("\r\nFreq B (Hz): 0x");
+		UART_word_hex_put(freq_engine_get(freq_engine_compared())->frequency());
+	}
+	UART_msg_put("\r\nVelocity: 0x");
+	UART_word_hex_put(flow_engine_vars()->velocity);
+	UART_msg_put("\r\nRe: 0x");
+	UART_word_hex_put(flow_engine_vars()->Re);
+	UART_msg_put("\r\nFlow cycles: 0x");
+	UART_word_hex_put(flow_engine_vars()->cycles_last);
+	UART_msg_put("\r\nTX drops: 0x");
+	UART_word_hex_put(tx_drop_count);
+	UART_msg_put("\r\nBIN skips: 0x");
+	UART_word_hex_put(tel_skip_count);
+	UART_msg_put("\r\nRX overrun/lost: 0x");
+	UART_hex_put(rx_overrun_count>>8);
+	UART_hex_put(rx_overrun_count&0xFF);
+	UART_msg_put(" 0x");
+	UART_hex_put(rx_line_lost>>8);
+	UART_hex_put(rx_line_lost&0xFF);
 		
-	// These variables need to be made available in shared.h and main.cpp
+	// The other flow variables are in flow_engine_vars()
 		// if you want to print them.
-	//UART_direct_msg_put("\r\nVelocity: ");
-	//UART_direct_hex_int_put(hex2hexInt(velocity), 2);
-  //UART_direct_msg_put("\r\nVelocity: ");
-	//UART_direct_word_hex_put(velocity);
-	//UART_direct_msg_put("\r\nViscosity (x10^-6): ");
-	//UART_direct_hex_int_put(hex2hexInt(viscosity), 0);
-	//UART_direct_msg_put("\r\nDensity: ");
-	//UART_direct_hex_int_put(hex2hexInt(rho_density),0);
-	//UART_direct_msg_put("\r\nSt: ");
-	//UART_direct_hex_int_put(hex2hexInt(St_const),0);
-	//UART_direct_msg_put("\r\nRe: ");
-	//UART_direct_hex_int_put(hex2hexInt(Re),0);
+	//UART_msg_put("\r\nVelocity: ");
+	//UART_hex_int_put(hex2hexInt(velocity), 2);
+  //UART_msg_put("\r\nVelocity: ");
+	//UART_word_hex_put(velocity);
+	//UART_msg_put("\r\nViscosity (x10^-6): ");
+	//UART_hex_int_put(hex2hexInt(viscosity), 0);
+	//UART_msg_put("\r\nDensity: ");
+	//UART_hex_int_put(hex2hexInt(rho_density),0);
+	//UART_msg_put("\r\nSt: ");
+	//UART_hex_int_put(hex2hexInt(St_const),0);
+	//UART_msg_put("\r\nRe: ");
+	//UART_hex_int_put(hex2hexInt(Re),0);
 	}
 	else
 	{
-		UART_direct_msg_put("\r\nFlow (GPM): ");
-		UART_direct_hex_int_put(hex2hexInt(Flow), 2);
-		UART_direct_msg_put("\r\nTemp (C): ");
-		UART_direct_hex_int_put(hex2hexInt(temperature), 2);
-		UART_direct_msg_put("\r\nFreq (Hz): ");
-		UART_direct_hex_int_put(hex2hexInt(frequency), 2);
+		UART_msg_put("\r\nFlow (GPM): ");
+		UART_dec_put(Flow, 2);
+		UART_msg_put("\r\nTemp (C): ");
+		UART_dec_put(temperature, 2);
+		UART_msg_put("\r\nFreq (Hz): ");
+		UART_dec_put(frequency, 2);
 	}
 }
 /*****************************************************************************/
@@ -391,6 +985,12 @@ void monitor(void)
 /*     Spew outputs               */
 /**********************************/
 
+   prof_report_poll();         // a profile report in progress, any mode
+   help_report_poll();         // the command list, any mode
+   sched_report_poll();        // the S task table, any mode
+   flog_dump_poll();           // a LOGD read back in progress, any mode
+   trace_dump_poll();          // a TRD read back in progress, any mode
+
    switch(display_mode)
    {
       case(QUIET):
@@ -399,11 +999,17 @@ void monitor(void)
          }  
          break;  
 			 
+      case(BINARY):
+         {   // records go out from tel_update(), no text reports
+             display_flag = 0;
+         }
+         break;
+
       case(NORMAL):
          {
-            if (display_flag == 1)
-            {
-               UART_direct_msg_put("\r\n\r\nNORMAL ");
+            if (display_flag == 1 && UART_tx_space() >= REPORT_MAX_CHARS)
+            {          // wait for room so the report goes out in one piece
+               UART_msg_put("\r\n\r\nNORMAL ");
                status_report();
                display_flag = 0;
             }
@@ -412,9 +1018,9 @@ void monitor(void)
 				 
       case(DEBUG):
          {
-            if (display_flag == 1)
-            {
-               UART_direct_msg_put("\r\n\r\nDEBUG ");
+            if (display_flag == 1 && UART_tx_space() >= REPORT_MAX_CHARS)
+            {          // wait for room so the report goes out in one piece
+               UART_msg_put("\r\n\r\nDEBUG ");
 							 //show_regs_and_mem(); // function displays register contents over UART
                status_report();
                //  Create a command to read 16 words from the current stack 
@@ -427,7 +1033,7 @@ void monitor(void)
 
       default:
       {
-         UART_direct_msg_put("Mode Error");
+         UART_msg_put("Mode Error");
       }  
    }
 }  
@@ -28,6 +28,7 @@
 --    to and from the UART port.  Included are:
 --       Serial() - a routine to send/receive bytes on the UART port to
 --                      the transmit/receive buffers
+--       UART_init() - sets up the buffers and the transmit interrupt
 --       UART_put()  - a routine that puts a character in the transmit buffer
 --       UART_get()  - a routine that gets the next character from the receive
 --                      buffer
@@ -41,6 +42,26 @@
 --				UART_low_nibble_direct_put() - puts the low nibble of a byte in hex directly
 --  																			(no ram buffer) to the UART.
 --			  UART_direct_word_hex_put() - puts a word in hex directly to the UART
+--
+--			NEW TO VERSION 2.0.3:
+--				Transmit is interrupt driven.  UART_put(), UART_msg_put() and the
+--				hex routines queue into tx_buf and return at once, UART0_IRQHandler
+--				sends a byte each time the transmit data register empties.  When
+--				tx_buf is full the data is dropped and counted in tx_drop_count,
+--				UART_tx_space() lets a caller wait for room instead.
+
+			NEW TO VERSION 2.0.4:
+				Receive is interrupt driven too.  UART0_IRQHandler reads each byte
+				as it arrives and builds the command line, with the backspace
+				editing chk_UART_msg() used to do.  A finished line (carriage
+				return) goes into a queue of RX_LINE_QUEUE
+				lines, UART_line_get() takes them out in order.  The echo goes
+				through rx_buf to the loop, which sends it, since only the loop
+				may put into tx_buf.  A line that finds the queue full is counted
+				in rx_line_lost, a byte that came before the last was read (the
+				interrupt held off for a whole character) in rx_overrun_count.
+--				The UART_direct_ routines still busy-wait and are only meant for
+--				use before UART_init() or while tx_buf is empty.
 --      Copyright (c) 2015 Tim Scherr  All rights reserved.
 --
 */              
@@ -55,6 +76,7 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 #include "shared.h"
 #include "MKL25Z4.h"
 
@@ -73,64 +95,175 @@
  ***********************************/
  
  UCHAR error_count = 0;
+ uint16_t tx_drop_count = 0;   // bytes dropped because tx_buf was full
+ volatile uint16_t rx_overrun_count = 0;  // bytes lost in the UART, OR set
+ volatile uint16_t rx_line_lost = 0;      // lines lost, queue full
+
+/// \struct rx_line one received command line
+ struct rx_line
+ {
+    UCHAR len;
+    UCHAR text[MSG_BUF_SIZE];
+ };
+ static struct rx_line rx_lines[RX_LINE_QUEUE];  // filled by the interrupt
+ static volatile UCHAR rx_line_in = 0;    // next to fill, moved by the interrupt
+ static volatile UCHAR rx_line_out = 0;   // next to read, moved by UART_line_get
+ static UCHAR rx_edit[MSG_BUF_SIZE];      // line being typed
+ static UCHAR rx_edit_len = 0;
  
 /*****************************************************************************/
 ///  \fn void serial(void) 
-/// @brief function polls the serial port for Rx or Tx data
+/// @brief sets serial_flag, the receive and transmit work is in the UART0
+/// interrupt now
+/*****************************************************************************/
+void serial(void)
+{
+                    // receive and transmit are done by UART0_IRQHandler
+//  serial_count++;         // increment serial counter, for debugging only
+  serial_flag = 1;        // and set flag
+}
+
+/*****************************************************************************/
+///  \fn void UART_init(void) 
+/// @brief empties the receive and transmit buffers and enables the UART0
+/// interrupt for receive, the transmit interrupt itself is enabled by
+/// UART_put()
+/*****************************************************************************/
+void UART_init(void)
+{
+   rx_in_ptr =  rx_buf; //! pointer to the receive in data 
+   rx_out_ptr = rx_buf; //! pointer to the receive out data*/
+   tx_in_ptr =  tx_buf; //! pointer to the transmit in data*/
+   tx_out_ptr = tx_buf; //! pointer to the transmit out */
+   tx_in_progress = false;
+   rx_line_in = rx_line_out = rx_edit_len = 0;
+   UART0->C2 |= UARTLP_C2_RIE_MASK;    /* interrupt on each received byte */
+   NVIC_EnableIRQ(UART0_IRQn);
+}
+
 /*****************************************************************************/
-void serial(void)       // The serial function polls the serial port for 
-                        // received data or data to transmit
+///  \fn static void rx_echo(UCHAR c)
+/// @brief queues a byte of echo for chk_UART_msg(), dropped if rx_buf is
+/// full (the line itself is kept)
+/*****************************************************************************/
+static void rx_echo(UCHAR c)
 {
-                         // deals with error handling first
-   if ( OERR )           // if an overrun error, clear it and continue.
+   UCHAR *next = rx_in_ptr + 1;
+   if( next >= RX_BUF_SIZE + rx_buf )
+      next = rx_buf;
+   if( next == rx_out_ptr ) return;
+   *rx_in_ptr = c;
+   rx_in_ptr = next;
+}
+
+/*****************************************************************************/
+///  \fn static void rx_line_char(UCHAR j)
+/// @brief adds a received byte to the line being typed, called from
+/// UART0_IRQHandler.  A carriage return queues the line.
+/*****************************************************************************/
+static void rx_line_char(UCHAR j)
+{
+   if( j == '\r' )                  // a complete message
    {
-      error_count++;         
-                            // resets and sets continous receive enable bit
-      UART0->C2 = UART0->C2 & (!UARTLP_C2_RE_MASK);
-      UART0->C2 = UART0->C2 | UARTLP_C2_RE_MASK;
+      if( (UCHAR)(rx_line_in - rx_line_out) >= RX_LINE_QUEUE )
+         rx_line_lost++;             // the loop is that far behind
+      else
+      {
+         struct rx_line *l = &rx_lines[rx_line_in % RX_LINE_QUEUE];
+         for( l->len = 0; l->len < rx_edit_len; l->len++ )
+            l->text[l->len] = rx_edit[l->len];
+         rx_line_in++;               // after the copy, the loop may read it
+      }
+      rx_edit_len = 0;
+      return;
+   }
+   if( (j != 0x02) && (display_mode != BINARY) )  // if not ^B
+      rx_echo(j);                    // echo the character
+   if( j == '\b' )
+   {                                 // backspace editor
+      if( rx_edit_len != 0 )
+      {                              // if not 1st character then destructive
+         rx_echo(' ');               // backspace
+         rx_echo('\b');
+         rx_edit_len--;
+      }
    }
-   
-   if ( FERR){       // if a framing error, read bad byte, clear it and continue.
+   else if( rx_edit_len >= MSG_BUF_SIZE )
+   {                                 // check message length too large
+      rx_edit_len = 0;
+   }
+   else
+      rx_edit[rx_edit_len++] = j;    // not complete message, store character
+}
+
+/*****************************************************************************/
+///  \fn UCHAR UART_line_get(UCHAR *dst, UCHAR *len)
+/// @brief takes the oldest received command line from the queue
+/// @param dst receives up to MSG_BUF_SIZE characters, no terminator
+/// @param len receives the number of characters, 0 for a bare return
+/// @return 1 if there was a line, 0 if the queue is empty
+/*****************************************************************************/
+UCHAR UART_line_get(UCHAR *dst, UCHAR *len)
+{
+   const struct rx_line *l;
+   UCHAR i;
+
+   if( rx_line_in == rx_line_out ) return 0;
+   l = &rx_lines[rx_line_out % RX_LINE_QUEUE];
+   for( i = 0; i < l->len; i++ ) dst[i] = l->text[i];
+   *len = l->len;
+   rx_line_out++;                    // after the copy, the slot is free
+   TRACE(TR_UART_LINE, *len);
+   return 1;
+}
+
+/*****************************************************************************/
+///  \fn void UART0_IRQHandler(void) 
+/// @brief receive data register full: adds the byte to the command line.
+/// transmit data register empty: sends the next byte of tx_buf, or
+/// turns the transmit interrupt off when tx_buf is empty
+/*****************************************************************************/
+extern "C" void UART0_IRQHandler(void)
+{
+   UCHAR s1 = UART0->S1;
+   if (s1 & UARTLP_S1_OR_MASK)    // a byte came before the last was read
+   {
+      rx_overrun_count++;
       error_count++;
-      RCREG;         // This will also clear RCIF if only one byte has been 
-                     // received since the last int, which is our assumption.
-                     
-                     // resets and sets continous receive enable bit
-      UART0->C2 = UART0->C2 & (!UARTLP_C2_RE_MASK);
-      UART0->C2 = UART0->C2 | UARTLP_C2_RE_MASK;
+      UART0->S1 = UARTLP_S1_OR_MASK;          /* write 1 to clear */
    }
-   else              // else if no frame error,
+   if (s1 & UARTLP_S1_FE_MASK)    // framing error, drop the byte
    {
-      if ( RCIF )   // Check if we have received a byte
-      {             // Read byte to enable reception of more bytes
-                    // For PIC, RCIF automatically cleared when RCREG is read
-                    // Also true of Freescale KL25Z
-         *rx_in_ptr++ = RCREG;         /* get received character */    
-         if( rx_in_ptr >= RX_BUF_SIZE + rx_buf )
-         {
-            rx_in_ptr = rx_buf;    /* if at end of buffer, circles rx_in_ptr 
-                                      to top of buffer */ 
-         } 
-
-      }     
+      error_count++;
+      RCREG;
+      UART0->S1 = UARTLP_S1_FE_MASK;          /* write 1 to clear */
    }
-   
-   if (TXIF)          //  Check if transmit buffer empty  
+   else if (s1 & UARTLP_S1_RDRF_MASK)
+   {
+      UCHAR c = RCREG;            // reading the data clears RDRF
+      TRACE(TR_UART_RX, c);
+      rx_line_char(c);
+      sched_post(EV_UART_RX);     // the loop echoes it, or runs the line
+   }
+
+   if (TXIF && (UART0->C2 & UARTLP_C2_TIE_MASK))
    {
-      if ((tx_in_ptr != tx_out_ptr) && (display_mode != QUIET))
+      if (tx_in_ptr != tx_out_ptr)
       {
-         TXREG = *tx_out_ptr++;     /* send next char */
-         if( tx_out_ptr >= TX_BUF_SIZE + tx_buf )
-            tx_out_ptr = tx_buf;           /* 0 <= tx_out_idx < TX_BUF_SIZE */        
-         tx_in_progress = true;          /* flag needed to start up after idle */
+         TXREG = *tx_out_ptr;       /* send next char */
+         TRACE(TR_UART_TX, *tx_out_ptr);
+         if( tx_out_ptr + 1 >= TX_BUF_SIZE + tx_buf )
+            tx_out_ptr = tx_buf;           /* 0 <= tx_out_idx < TX_BUF_SIZE */
+         else
+            tx_out_ptr++;
+         tx_in_progress = true;
       }
       else
       {
+         UART0->C2 &= ~UARTLP_C2_TIE_MASK;   /* UART_put() turns it back on */
          tx_in_progress = false;             /* no more to send */
       }
-  }                   
-//  serial_count++;         // increment serial counter, for debugging only
-  serial_flag = 1;        // and set flag
+   }
 }
 /*******************************************************************************/
 /// @brief The function UART_direct_msg_put puts a null terminated string directly
@@ -157,20 +290,39 @@ void UART_direct_msg_put(const char *str)
 
 /*******************************************************************************
 * The function UART_put puts a byte, to the transmit buffer at the location 
-* pointed to by tx_in_idx.  The pointer is incremented circularly as described
-* previously.  If the transmit buffer should wrap around (should be designed 
-* not to happen), data will be lost.  The serial interrupt must be temporarily
-* disabled since it reads tx_in_idx and this routine updates tx_in_idx which is 
-* a 16 bit value.           
+* pointed to by tx_in_ptr.  The pointer is incremented circularly as described
+* previously.  If the transmit buffer is full the byte is dropped and counted
+* in tx_drop_count.  Only this routine moves tx_in_ptr and only the interrupt
+* moves tx_out_ptr, and each is a single 32 bit store, so the interrupt does
+* not need to be disabled.
+* Returns 1 if the byte was queued, 0 if it was dropped.
 *******************************************************************************/
-/*
-void UART_put(UCHAR c)
+UCHAR UART_put(UCHAR c)
 {
-   *tx_in_ptr++ = c;                    // save character to transmit buffer
-   if( tx_in_ptr >= TX_BUF_SIZE + tx_buf)
-      tx_in_ptr = tx_buf;                     // 0 <= tx_in_idx < TX_BUF_SIZE          
+   UCHAR *next = tx_in_ptr + 1;
+   if( next >= TX_BUF_SIZE + tx_buf)
+      next = tx_buf;                          // 0 <= tx_in_idx < TX_BUF_SIZE          
+   if( next == tx_out_ptr )
+   {                                    // full, drop it
+      tx_drop_count++;
+      return 0;
+   }
+   *tx_in_ptr = c;                      // save character to transmit buffer
+   tx_in_ptr = next;
+   UART0->C2 |= UARTLP_C2_TIE_MASK;     // interrupt when the UART can take it
+   return 1;
+}
+
+/*****************************************************************************/
+/// @brief UART_tx_space returns the number of bytes that can be queued in
+/// tx_buf without a drop.
+/*****************************************************************************/
+uint16_t UART_tx_space(void)
+{
+   UCHAR *out = tx_out_ptr;
+   if( out > tx_in_ptr ) return out - tx_in_ptr - 1;
+   return TX_BUF_SIZE - (tx_in_ptr - out) - 1;
 }
-*/
 /*****************************************************************************/
 /// @brief UART_direct_msg_put puts a character directly
 /// (no ram buffer) to the UART in ASCII format.
@@ -227,19 +379,22 @@ UCHAR UART_input(void)
 
 /*****************************************************************************/
 /// @brief UART_msg_put puts a null terminated string through the transmit
-/// buffer to the UART port in ASCII format. (commented out)
+/// buffer to the UART port in ASCII format.  A string that does not fit is
+/// dropped whole, so the output never has half a message in it.
+/// Returns 1 if the string was queued, 0 if it was dropped.
 /*****************************************************************************/
-/*
-void UART_msg_put(const char *str)
+UCHAR UART_msg_put(const char *str)
 {
-   while( *str != '\0' )
+   uint16_t len = strlen(str);
+   if( len > UART_tx_space() )
    {
-      *tx_in_ptr++ = *str++;        // save character to transmit buffer
-      if( tx_in_ptr >= TX_BUF_SIZE + tx_buf)
-         tx_in_ptr = tx_buf;                  // 0 <= tx_in_idx < TX_BUF_SIZE        
-   }   
+      tx_drop_count += len;
+      return 0;
+   }
+   while( *str != '\0' )
+      UART_put( *str++ );           // save character to transmit buffer
+   return 1;
 }
-*/
 /*****************************************************************************/
 /// @brief HEX_TO_ASCII Function
 /// Function takes a single hex character (0 thru Fh) and converts to ASCII.
@@ -284,16 +439,26 @@ void UART_low_nibble_direct_put(UCHAR c)
 
 /*******************************************************************************
 *! \brief UART_hex_put puts 1 byte in hex through the transmit buffer to 
-* the UART port. (commented out)
+* the UART port.
 *******************************************************************************/
-/*
 void UART_hex_put(unsigned char c)
 {
    UART_put( hex_to_asc( (c>>4) & 0x0f ));  // could eliminate & as >> of UCHAR
                                              // by definition clears upper bits.
    UART_put( hex_to_asc( c & 0x0f ));
 }
-*/
+
+/*****************************************************************************/
+/// @brief UART_word_hex_put puts 4 bytes in hex through the transmit buffer
+/// to the UART port.
+/*****************************************************************************/
+void UART_word_hex_put(uint32_t word)
+{
+	UART_hex_put((word>>24)&0xFF);
+	UART_hex_put((word>>16)&0xFF);
+	UART_hex_put((word>>8)&0xFF);
+	UART_hex_put(word&0xFF);
+}
 /*****************************************************************************/
 /// @brief UART_direct_hex_put puts 1 byte in hex directly (no ram buffer) 
 /// to the UART.
@@ -339,3 +504,35 @@ void UART_direct_hex_int_put(uint32_t word, uint8_t deci)
 		}
   }
 }
+
+/*******************************************************************************/
+/// @brief The function UART_hex_int_put is UART_direct_hex_int_put through the
+/// transmit buffer.
+/******************************************************************************/
+void UART_hex_int_put(uint32_t word, uint8_t deci)
+{
+	bool zeros = true;
+	int8_t i = 7; //must be signed because of wrap-around
+	for(i=7;i>=0;i--)
+	{
+		if(zeros && ((word>>(i*4))&0xF)==0);
+		else
+		{
+			zeros = false;
+			UART_put(hex_to_asc((word>>i*4)&0xF));
+			if(i == deci && deci>0) UART_put('.');	
+		}
+  }
+}
+
+/*******************************************************************************/
+/// @brief The function UART_dec_put puts x in decimal with deci decimals
+/// through the transmit buffer, 128376 with 2 is "1283.76". It takes the
+/// value itself, not hex2hexInt() of it, and has no divide (fmt.cpp).
+/******************************************************************************/
+void UART_dec_put(uint32_t x, UCHAR deci)
+{
+	char text[FMT_DEC_MAX + 1];
+	text[fmt_dec(text, x, deci, 0)] = 0;
+	UART_msg_put(text);
+}
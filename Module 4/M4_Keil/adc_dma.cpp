@@ -0,0 +1,193 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file adc_dma.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      adc_dma.cpp                                          --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   ADC acquisition pipeline for the flow sensor.
+
+   TPM1 overflows at ADC_SAMPLE_HZ and hardware-triggers ADC0 on the flow
+   channel (PTB0, ADC0_SE8).  Each conversion complete raises a DMA request
+   and DMA channel DMA_CH_ADC moves the result into one of two sample blocks.
+   When a block is full the DMA interrupt hands it to the super loop and
+   points the DMA at the other block, so the loop processes one block while
+   the next one is being captured.  The CPU never waits on COCO and the
+   sample spacing is set by the timer, not by the loop.
+
+   The slow housekeeping channels (internal temperature and VREFL) are
+   converted once per block.  The DMA interrupt arrives right after a flow
+   conversion, so there is most of a sample period free: the ISR switches
+   the ADC to a software triggered conversion of one housekeeping channel,
+   and the ADC interrupt stores the result and restores the hardware
+   trigger before the next TPM1 overflow.
+
+   Note: the mbed library for this target has no dma_api implementation,
+   so the DMA channel is programmed directly.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+#include "MKL25Z4.h"
+
+#define ADC_FLOW_CH        8       /* PTB0, ADC0_SE8 */
+#define ADC_TEMP_CH        26      /* internal temperature sensor */
+#define ADC_VREFL_CH       30      /* VREFL */
+#define ADC_TRGSEL_TPM1    9       /* SIM_SOPT7 ADC0TRGSEL, TPM1 overflow */
+#define DMAMUX_SRC_ADC0    40      /* DMA request source for ADC0 */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static uint16_t adc_block[2][ADC_BLOCK_SIZE];   // ping-pong sample blocks
+   static volatile UCHAR adc_fill = 0;      // block the DMA is filling
+   static volatile UCHAR adc_ready = 0;     // 1 when adc_ready_idx is valid
+   static volatile UCHAR adc_ready_idx = 0; // completed block for the loop
+   static volatile UCHAR adc_hk_idx = 0;    // housekeeping channel in progress
+   static const UCHAR adc_hk_ch[ADC_HK_COUNT] = {ADC_TEMP_CH, ADC_VREFL_CH};
+   static volatile uint16_t adc_hk[ADC_HK_COUNT];  // housekeeping results
+   volatile uint16_t adc_overrun = 0;       // blocks dropped, loop too slow
+
+/*****************************************************************************/
+/// \fn static void adc_dma_arm(void)
+/// @brief points the DMA at the block being filled and enables the request
+/*****************************************************************************/
+static void adc_dma_arm(void)
+{
+   DMA0->DMA[DMA_CH_ADC].DAR = (uintptr_t)adc_block[adc_fill];
+   DMA0->DMA[DMA_CH_ADC].DSR_BCR = DMA_DSR_BCR_BCR(ADC_BLOCK_SIZE*2);
+   DMA0->DMA[DMA_CH_ADC].DCR |= DMA_DCR_ERQ_MASK;
+}
+
+/*****************************************************************************/
+/// \fn void adc_init(void)
+/// @brief sets up the ADC, its hardware trigger and the DMA channel,
+/// then starts sampling
+/*****************************************************************************/
+void adc_init(void)
+{
+   SIM->SCGC5 |= SIM_SCGC5_PORTB_MASK;      /* clock to PORTB */
+   PORTB->PCR[0] = 0;                       /* PTB0 analog input, flow */
+   PORTB->PCR[1] = 0;                       /* PTB1 analog input */
+   PORTB->PCR[2] = 0;                       /* PTB2 analog input */
+   SIM->SCGC6 |= SIM_SCGC6_ADC0_MASK | SIM_SCGC6_TPM1_MASK |
+                 SIM_SCGC6_DMAMUX_MASK;
+   SIM->SCGC7 |= SIM_SCGC7_DMA_MASK;
+
+/* ADC: no low power, bus clock / 2, long sample time, single ended 16 bit */
+   ADC0->CFG1 = ADC_CFG1_ADIV(1) | ADC_CFG1_ADLSMP_MASK | ADC_CFG1_MODE(3);
+   ADC0->SC3 = 0;                           /* one conversion per trigger */
+   SIM->SOPT7 = SIM_SOPT7_ADC0ALTTRGEN_MASK | SIM_SOPT7_ADC0TRGSEL(ADC_TRGSEL_TPM1);
+   ADC0->SC2 = ADC_SC2_ADTRG_MASK | ADC_SC2_DMAEN_MASK;  /* hardware trigger */
+   ADC0->SC1[0] = ADC_FLOW_CH;              /* no AIEN, the DMA takes COCO */
+
+/* DMA: 16 bit reads of the result register into the current block */
+   DMAMUX0->CHCFG[DMA_CH_ADC] = 0;
+   DMA0->DMA[DMA_CH_ADC].DSR_BCR = DMA_DSR_BCR_DONE_MASK;
+   DMA0->DMA[DMA_CH_ADC].SAR = (uintptr_t)&ADC0->R[0];
+   DMA0->DMA[DMA_CH_ADC].DCR = DMA_DCR_EINT_MASK | DMA_DCR_CS_MASK |
+                 DMA_DCR_SSIZE(2) | DMA_DCR_DINC_MASK | DMA_DCR_DSIZE(2) |
+                 DMA_DCR_D_REQ_MASK;
+   adc_fill = 0;
+   adc_ready = 0;
+   adc_dma_arm();
+   DMAMUX0->CHCFG[DMA_CH_ADC] = DMAMUX_CHCFG_ENBL_MASK |
+                                DMAMUX_CHCFG_SOURCE(DMAMUX_SRC_ADC0);
+   NVIC_EnableIRQ(DMA0_IRQn);
+   NVIC_EnableIRQ(ADC0_IRQn);
+
+/* TPM1: free running, overflows at the sample rate and triggers the ADC */
+   SIM->SOPT2 |= SIM_SOPT2_PLLFLLSEL_MASK;
+   SIM->SOPT2 = (SIM->SOPT2 & ~SIM_SOPT2_TPMSRC_MASK) | SIM_SOPT2_TPMSRC(1);
+   TPM1->SC = 0;
+   TPM1->CNT = 0;
+   TPM1->MOD = TPM_CLOCK_HZ/ADC_SAMPLE_HZ - 1;
+   TPM1->SC = TPM_SC_CMOD(1) | TPM_SC_PS(0);
+}
+
+/*****************************************************************************/
+/// \fn const uint16_t *adc_block_get(void)
+/// @brief returns the oldest completed sample block, or NULL if none.
+/// The block belongs to the caller until adc_block_release().
+/*****************************************************************************/
+const uint16_t *adc_block_get(void)
+{
+   if(!adc_ready) return NULL;
+   return adc_block[adc_ready_idx];
+}
+
+/*****************************************************************************/
+/// \fn void adc_block_release(void)
+/// @brief gives the block from adc_block_get() back to the DMA
+/*****************************************************************************/
+void adc_block_release(void)
+{
+   adc_ready = 0;
+}
+
+/*****************************************************************************/
+/// \fn uint16_t adc_hk_read(UCHAR idx)
+/// @brief returns the last housekeeping conversion, ADC_HK_TEMP or ADC_HK_VREFL
+/*****************************************************************************/
+uint16_t adc_hk_read(UCHAR idx)
+{
+   return adc_hk[idx];
+}
+
+/*****************************************************************************/
+/// \fn void DMA0_IRQHandler(void)
+/// @brief a sample block is full: hand it to the loop, re-arm the DMA and
+/// start one housekeeping conversion
+/*****************************************************************************/
+extern "C" void DMA0_IRQHandler(void)
+{
+   DMA0->DMA[DMA_CH_ADC].DSR_BCR = DMA_DSR_BCR_DONE_MASK;  /* clear DONE */
+   TRACE(TR_ADC_BLOCK, adc_ready);
+   if(adc_ready)
+   {                // the loop still owns the other block, drop this one
+      adc_overrun++;
+   }
+   else
+   {
+      adc_ready_idx = adc_fill;
+      adc_ready = 1;
+      adc_fill ^= 1;
+      sched_post(EV_ADC_BLOCK);   // releases task_freq
+   }
+   adc_dma_arm();
+
+   adc_hk_idx = (adc_hk_idx + 1) % ADC_HK_COUNT;
+   ADC0->SC2 &= ~(ADC_SC2_ADTRG_MASK | ADC_SC2_DMAEN_MASK);
+   ADC0->SC1[0] = ADC_SC1_AIEN_MASK | adc_hk_ch[adc_hk_idx];  /* start */
+}
+
+/*****************************************************************************/
+/// \fn void ADC0_IRQHandler(void)
+/// @brief housekeeping conversion complete, go back to triggered sampling
+/*****************************************************************************/
+extern "C" void ADC0_IRQHandler(void)
+{
+   adc_hk[adc_hk_idx] = ADC0->R[0];         /* also clears COCO */
+   TRACE(TR_ADC_HK, adc_hk_idx);
+   ADC0->SC2 |= ADC_SC2_ADTRG_MASK | ADC_SC2_DMAEN_MASK;
+   ADC0->SC1[0] = ADC_FLOW_CH;              /* waits for the next trigger */
+}
@@ -0,0 +1,289 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file amdf.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      amdf.cpp                                             --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Period estimator on the average magnitude difference function (AMDF),
+   one of the engines behind readFREQ() (freq_engine.cpp).
+
+      D(lag) = sum |x[i] - x[i - lag]|   over the newest ADC block
+
+   dips to near 0 when lag is a whole number of periods, whatever the
+   amplitude does, so a vortex signal whose amplitude swings from one
+   cycle to the next reads as well as a steady one.  The threshold edge
+   detector needs a peak near the maximum every cycle.  The previous block
+   is kept for the lags that reach back past the start of the block.
+
+   I.   Search (no lock): D at every lag up to AM_LAG_MAX, the period
+        is the first dip from AM_LAG_MIN on that goes below AM_DIP_PCT of
+        the highest D before it, the one at half a period.  Later dips
+        are its multiples.  Noise raises D at every lag alike, so the dip
+        is against D and not the signal level.
+   II.  The period is refined over k periods, the fewest that span
+        AM_LAG_REF lags, so a lag counted to a fraction of a sample is
+        a fraction of k periods.
+   III. Tracking (lock): only the lags around the last k periods are
+        evaluated, 2*AM_TRACK + 1 of them, walking on when the least is at
+        the edge, and the dip is tested against D half a period before.
+        The walk stops at a quarter period, and after a walk the dip has
+        to be k periods of one length (a dip a period less, none at a
+        fraction), else it is on a multiple of a new period and the new
+        one is searched.
+        The bottom of the dip is a V, the fraction of a lag is where the
+        two sides meet: (a - c)/(2(max(a, c) - b)).
+
+   A block without a dip goes back to the search, holding the last
+   frequency, which drops to 0 after a second.  What the search finds is
+   published when the next block tracks it and has no dip at a whole
+   fraction of it, which would make it a multiple of the period.  Away
+   from the held frequency it takes AM_CONFIRM blocks, so a block where
+   the amplitude fades into the noise does not move the reading.
+
+   Integer only: D is at most AM_N*2^14, so D*100 fits 32 bits.  The
+   worst block, a search, is a fixed number of lags.
+
+   The period has to be AM_LAG_MIN samples or more (1 kHz): shorter ones
+   are not a whole number of samples, D does not dip at them and the
+   search takes a multiple.  The FFT engine covers the top of the band.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+#define AM_N            ADC_BLOCK_SIZE   /* samples per D, and history */
+#define AM_LAG_MIN      10        /* shortest period, 1 kHz */
+#define AM_LAG_MAX      200       /* longest, 50 Hz */
+#define AM_LAG_REF      64        /* refine over at least this many lags */
+#define AM_TRACK        3         /* lags either side when tracking */
+#define AM_WALK_MAX     16        /* lags the window may walk per block */
+#define AM_DIP_PCT      75        /* dip, D(period)/D(half period) in % */
+#define AM_FRAC_MAX     (AM_LAG_MAX/AM_LAG_MIN)  /* fractions of a new period */
+#define AM_CONFIRM      3         /* blocks to confirm a lock away from the
+                                     held frequency, 1 near it */
+#define AM_LOST_BLOCKS  (ADC_SAMPLE_HZ/ADC_BLOCK_SIZE)  /* 1 s, no flow */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static int16_t  am_hist[2*AM_N];       // previous block, newest block
+   static UCHAR    am_locked = 0;
+   static UCHAR    am_fresh = 0;          // locked by the search, unconfirmed
+   static UCHAR    am_k = 1;              // periods in am_lag
+   static uint32_t am_lag = 0;            // k periods, samples Q8
+   static uint16_t am_miss = 0;           // blocks without a dip
+   static uint32_t am_freq = 0;           // latest estimate, Hz (x100)
+
+/*****************************************************************************/
+/// \fn static uint32_t am_d(uint16_t lag)
+/// @return D(lag) over the newest block, lag up to AM_N
+/*****************************************************************************/
+static uint32_t am_d(uint16_t lag)
+{
+   const int16_t *x = &am_hist[AM_N], *y = &am_hist[AM_N - lag];
+   uint32_t d = 0;
+   uint16_t i;
+   int32_t e;
+   for(i=0;i<AM_N;i++)
+   {
+      e = x[i] - y[i];
+      d += (e < 0) ? -e : e;
+   }
+   return d;
+}
+
+/*****************************************************************************/
+/// \fn static uint32_t am_hz(void)
+/// @return the frequency of am_k periods in am_lag, Hz (x100)
+/*****************************************************************************/
+static uint32_t am_hz(void)
+{
+   return ((uint32_t)am_k*(100UL*ADC_SAMPLE_HZ << 8) + (am_lag >> 1))/am_lag;
+}
+
+/*****************************************************************************/
+/// \fn static int32_t am_vertex(uint32_t a, uint32_t b, uint32_t c)
+/// @return where the sides of the V through D at lags -1, 0, +1 meet,
+/// in lags Q8, b the least
+/*****************************************************************************/
+static int32_t am_vertex(uint32_t a, uint32_t b, uint32_t c)
+{
+   uint32_t den = 2*(((a > c) ? a : c) - b);
+   if(den == 0) return 0;
+   if(a >= c) return (int32_t)(((a - c) << 8)/den);
+   return -(int32_t)(((c - a) << 8)/den);
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR am_search(void)
+/// @brief full search for the first dip, sets the lock on k periods
+/// @return 1 if found
+/*****************************************************************************/
+static UCHAR am_search(void)
+{
+   uint32_t a, b, c, f, top = 0;
+   uint16_t lag;
+   int32_t t;
+
+   a = am_d(AM_LAG_MIN/2 - 1);
+   b = am_d(AM_LAG_MIN/2);
+   for(lag=AM_LAG_MIN/2; lag<=AM_LAG_MAX; lag++)
+   {
+      c = am_d(lag + 1);
+      if(b > top) top = b;
+      if(lag >= AM_LAG_MIN && b <= a && b < c &&
+         b*100 < top*AM_DIP_PCT) break;
+      a = b;
+      b = c;
+   }
+   if(lag > AM_LAG_MAX) return 0;
+
+   t = ((uint32_t)lag << 8) + am_vertex(a, b, c);   // one period, Q8
+   am_k = (AM_LAG_REF + lag - 1)/lag;
+   am_lag = am_k*t;
+   am_locked = 1;
+   f = am_hz();
+   am_fresh = (am_freq == 0 || (f > am_freq ? f - am_freq : am_freq - f) <
+               (am_freq >> 3)) ? 1 : AM_CONFIRM;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR am_track(void)
+/// @brief evaluates the lags around am_lag and moves it to the dip
+/// @return 1 if the dip is there, 0 if it is lost
+/*****************************************************************************/
+static UCHAR am_track(void)
+{
+   uint32_t d[2*AM_TRACK + 1];
+   uint16_t lo = ((am_lag + 128) >> 8) - AM_TRACK;   // lag of d[0]
+   UCHAR i, m = 0, walk = 0;
+   UCHAR walk_max = am_lag/am_k >> 10;               // quarter period
+   uint32_t t, ref;
+
+   if(walk_max > AM_WALK_MAX) walk_max = AM_WALK_MAX;
+   for(i=0;i<2*AM_TRACK+1;i++) d[i] = am_d(lo + i);
+   for(;;)
+   {
+      for(i=1, m=0;i<2*AM_TRACK+1;i++) if(d[i] < d[m]) m = i;
+      if(m == 0 && lo > AM_LAG_MIN && walk < walk_max)
+      {                           // least at an edge, walk the window on
+         for(i=2*AM_TRACK;i>0;i--) d[i] = d[i-1];
+         d[0] = am_d(--lo);
+      }
+      else if(m == 2*AM_TRACK && lo + 2*AM_TRACK < AM_N && walk < walk_max)
+      {
+         for(i=0;i<2*AM_TRACK;i++) d[i] = d[i+1];
+         d[2*AM_TRACK] = am_d(++lo + 2*AM_TRACK);
+      }
+      else break;
+      walk++;
+   }
+   if(m == 0 || m == 2*AM_TRACK) return 0;
+
+   am_lag = ((uint32_t)(lo + m) << 8) + am_vertex(d[m-1], d[m], d[m+1]);
+   t = am_lag/am_k;                          // one period
+   ref = am_d((am_lag - t/2 + 128) >> 8);
+   if(d[m]*100 >= ref*AM_DIP_PCT) return 0;
+   // walked on: a period less is a dip too, else the window is on the
+   // multiple of a new period
+   if(walk && am_k > 1 && am_d((am_lag - t + 128) >> 8)*100 >=
+                          ref*AM_DIP_PCT) return 0;
+   // blocks after a search, or a walk: no dip at a whole fraction of the
+   // period, against D half that fraction before, else it is a multiple
+   if(am_fresh || walk)
+   {
+      for(i=2; i <= AM_FRAC_MAX && (t/i >> 8) >= AM_LAG_MIN; i++)
+         if(am_d((t/i + 128) >> 8)*100 <
+            am_d((t/(2*i) + 128) >> 8)*AM_DIP_PCT) return 0;
+      if(am_fresh) am_fresh--;
+   }
+
+   // keep k periods the fewest that span AM_LAG_REF
+   if(am_k > 1 && am_lag - t >= ((uint32_t)AM_LAG_REF << 8))
+   {
+      am_k--;
+      am_lag -= t;
+   }
+   else if(am_lag < ((uint32_t)AM_LAG_REF << 8) &&
+           am_lag + t < ((uint32_t)(AM_N - AM_TRACK - AM_WALK_MAX - 1) << 8))
+   {
+      am_k++;
+      am_lag += t;
+   }
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn void am_init(void)
+/// @brief starts with a search, holding the last published frequency
+/*****************************************************************************/
+void am_init(void)
+{
+   uint16_t i;
+   for(i=0;i<2*AM_N;i++) am_hist[i] = 0;
+   am_freq = frequency;
+   am_locked = 0;
+   am_miss = 0;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR am_block(const uint16_t *blk, uint16_t n)
+/// @brief adds a block to the history and looks for the period in it
+/// @param blk raw 16 bit ADC readings, AM_N of them
+/// @return 1 if a new frequency was published, 0 otherwise
+/*****************************************************************************/
+UCHAR am_block(const uint16_t *blk, uint16_t n)
+{
+   uint16_t i;
+   UCHAR found;
+
+   if(n > AM_N) n = AM_N;
+   for(i=0;i<AM_N;i++) am_hist[i] = am_hist[i + AM_N];
+   for(i=0;i<n;i++) am_hist[AM_N + i] = blk[i] >> 2;  // 14 bits, D fits 32
+
+   found = am_locked ? am_track() : 0;
+   if(found && !am_fresh)
+   {
+      am_miss = 0;
+      am_freq = am_hz();
+      return 1;
+   }
+   if(!found)
+   {                    // a new lock is published once the following
+      am_locked = 0;    // blocks have the dip too, a weak block can dip
+      am_search();      // anywhere
+   }
+   if(am_freq == 0 || ++am_miss < AM_LOST_BLOCKS) return 0;
+   am_freq = 0;                              // no flow
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t am_frequency(void)
+/// @return the latest published frequency in Hz (x100), 0 if no signal
+/*****************************************************************************/
+uint32_t am_frequency(void)
+{
+   return am_freq;
+}
@@ -0,0 +1,272 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file aout.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      aout.cpp                                             --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   4-20 mA current loop output of Flow, from DAC0 (PTE30) into an
+   external voltage to current stage, AOUT_FULL_UA at code 4095.
+
+   Flow from aout_range()'s low to high end maps to 4 to 20 mA.  Outside
+   it the current goes on along the same line up to the NAMUR NE 43
+   limits, 3.8 and 20.5 mA.  A fault drives the alarm current set with
+   aout_alarm(), below 3.6 or above 21 mA, or holds the output if it is 0.
+
+   The loop does not write the DAC.  aout_update(), from task_flow after
+   each Flow, works out a ramp from the code the DAC holds to the new one,
+   no steeper than the aout_slew() limit, and DMA channel DMA_CH_AOUT
+   writes it to DAC0 one code per PIT channel PIT_CH_AOUT period (the
+   DMAMUX periodic trigger), AOUT_UPDATE_HZ.  At the end of the ramp the
+   DMA stops and the DAC holds the last code.  A ramp covers
+   AOUT_RAMP_SIZE updates, longer than the flow update period, so a steep
+   change goes on in the next ramp, started from where this one got to.
+   The output changes on the PIT's time grid whatever the loop is doing;
+   a late loop only starts the next ramp late, and a loop later than
+   AOUT_RAMP_SIZE updates leaves the output where the ramp ended.
+
+   If no Flow comes for AOUT_STALE_TICKS, aout_tick() in timer0() stops
+   the DMA and writes the alarm code itself, so a loop that has stopped
+   cannot leave a live looking current behind.
+
+   The mbed AnalogOut writes the DAC from the CPU, so the DAC is set up
+   here directly, for the DMA to write DAT0.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+#include "MKL25Z4.h"
+
+#define DMAMUX_SRC_ALWAYS  60      /* always on source, for the PIT trigger */
+#define AOUT_DAC_MAX       4095
+#define AOUT_CODE_K ((uint32_t)(((uint64_t)AOUT_DAC_MAX << 16)/AOUT_FULL_UA))
+                                   /* codes per uA, Q16 */
+#define AOUT_CODE(ua) (((uint32_t)(ua)*AOUT_CODE_K) >> 16)
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static struct aout_stat aout_stat;
+   static uint16_t aout_ramp[AOUT_RAMP_SIZE];     // DMA source, DAC codes
+   static uint32_t aout_k;               // uA per GPM (x100) << aout_sh, Q16
+   static UCHAR aout_sh;                 // Flow bits dropped before aout_k
+   static uint16_t aout_step;            // codes per update at most
+   static uint16_t aout_alarm_code;      // of aout_stat.alarm_ua, 0 holds
+   static volatile uint16_t aout_stale;  // ticks left without a Flow
+
+/*****************************************************************************/
+/// \fn static uint16_t aout_dac(void)
+/// @return the code DAC0 puts out now
+/*****************************************************************************/
+static uint16_t aout_dac(void)
+{
+   return DAC0->DAT[0].DATL | ((DAC0->DAT[0].DATH & 0x0F) << 8);
+}
+
+/*****************************************************************************/
+/// \fn static void aout_dac_set(uint16_t code)
+/// @brief puts code out at once, from the CPU
+/*****************************************************************************/
+static void aout_dac_set(uint16_t code)
+{
+   DAC0->DAT[0].DATL = code;
+   DAC0->DAT[0].DATH = code >> 8;
+}
+
+/*****************************************************************************/
+/// \fn static void aout_ramp_start(uint16_t code)
+/// @brief stops the ramp under way and starts one from the DAC's code to
+/// code, AOUT_RAMP_SIZE updates at most
+/*****************************************************************************/
+static void aout_ramp_start(uint16_t code)
+{
+   uint16_t v, n = 0;
+
+   DMA0->DMA[DMA_CH_AOUT].DCR &= ~DMA_DCR_ERQ_MASK;   /* no more updates */
+   v = aout_dac();
+   while(v != code && n < AOUT_RAMP_SIZE)
+   {
+      if(v < code) v = (code - v > aout_step) ? v + aout_step : code;
+      else v = (v - code > aout_step) ? v - aout_step : code;
+      aout_ramp[n++] = v;
+   }
+   if(n == 0) return;                             /* there already */
+
+   DMA0->DMA[DMA_CH_AOUT].DSR_BCR = DMA_DSR_BCR_DONE_MASK;
+   DMA0->DMA[DMA_CH_AOUT].SAR = (uintptr_t)aout_ramp;
+   DMA0->DMA[DMA_CH_AOUT].DSR_BCR = DMA_DSR_BCR_BCR(n*2);
+   DMA0->DMA[DMA_CH_AOUT].DCR |= DMA_DCR_ERQ_MASK;
+   aout_stat.ramps++;
+}
+
+/*****************************************************************************/
+/// \fn void aout_init(void)
+/// @brief starts DAC0 at the alarm current (4 mA if there is none), and
+/// the PIT and DMA that update it
+/*****************************************************************************/
+void aout_init(void)
+{
+   uint32_t bus_hz = SystemCoreClock/
+                     (((SIM->CLKDIV1 & SIM_CLKDIV1_OUTDIV4_MASK) >>
+                       SIM_CLKDIV1_OUTDIV4_SHIFT) + 1);
+
+   aout_range(AOUT_FLOW_LO_DEFAULT, AOUT_FLOW_HI_DEFAULT);
+   aout_slew(AOUT_SLEW_DEFAULT);
+   aout_alarm(AOUT_ALARM_LO_UA);
+
+/* DAC0: VDDA reference, no buffer, DAT0 goes straight to the output */
+   SIM->SCGC5 |= SIM_SCGC5_PORTE_MASK;
+   PORTE->PCR[30] = PORT_PCR_MUX(0);         /* PTE30 analog, DAC0_OUT */
+   SIM->SCGC6 |= SIM_SCGC6_DAC0_MASK | SIM_SCGC6_PIT_MASK |
+                 SIM_SCGC6_DMAMUX_MASK;
+   SIM->SCGC7 |= SIM_SCGC7_DMA_MASK;
+   DAC0->C1 = 0;
+   DAC0->C2 = 0;
+   DAC0->C0 = DAC_C0_DACEN_MASK | DAC_C0_DACRFS_MASK;
+   aout_dac_set(aout_stat.alarm_ua ? aout_alarm_code : AOUT_CODE(AOUT_ZERO_UA));
+
+/* DMA: a 16 bit code to DAT0 per PIT_CH_AOUT period, no interrupt */
+   DMAMUX0->CHCFG[DMA_CH_AOUT] = 0;
+   DMA0->DMA[DMA_CH_AOUT].DSR_BCR = DMA_DSR_BCR_DONE_MASK;
+   DMA0->DMA[DMA_CH_AOUT].DAR = (uintptr_t)&DAC0->DAT[0].DATL;
+   DMA0->DMA[DMA_CH_AOUT].DCR = DMA_DCR_CS_MASK | DMA_DCR_SINC_MASK |
+                 DMA_DCR_SSIZE(2) | DMA_DCR_DSIZE(2) | DMA_DCR_D_REQ_MASK;
+   DMAMUX0->CHCFG[DMA_CH_AOUT] = DMAMUX_CHCFG_ENBL_MASK |
+                                 DMAMUX_CHCFG_TRIG_MASK |
+                                 DMAMUX_CHCFG_SOURCE(DMAMUX_SRC_ALWAYS);
+
+/* PIT: free running, each expiry is the trigger, no interrupt */
+   PIT->MCR = PIT_MCR_FRZ_MASK;
+   PIT->CHANNEL[PIT_CH_AOUT].TCTRL = 0;
+   PIT->CHANNEL[PIT_CH_AOUT].LDVAL = bus_hz/AOUT_UPDATE_HZ - 1;
+   PIT->CHANNEL[PIT_CH_AOUT].TCTRL = PIT_TCTRL_TEN_MASK;
+
+   aout_stale = AOUT_STALE_TICKS;
+}
+
+/*****************************************************************************/
+/// \fn void aout_update(uint32_t flow)
+/// @brief the current for a new Flow, ramped to by the DMA; called from
+/// task_flow after every Flow
+/// @param flow GPM (x100)
+/*****************************************************************************/
+void aout_update(uint32_t flow)
+{
+   uint32_t d, span = aout_stat.flow_hi - aout_stat.flow_lo;
+   int32_t ua;
+
+   aout_stale = AOUT_STALE_TICKS;
+   if(flow >= aout_stat.flow_lo)
+   {                         // d*aout_k stays under 2^31 up to twice the span
+      d = flow - aout_stat.flow_lo;
+      if(d > 2*span) d = 2*span;
+      ua = AOUT_ZERO_UA + (((d >> aout_sh)*aout_k) >> 16);
+   }
+   else
+   {
+      d = aout_stat.flow_lo - flow;
+      if(d > span) d = span;
+      ua = AOUT_ZERO_UA - (int32_t)(((d >> aout_sh)*aout_k) >> 16);
+   }
+   if(ua < AOUT_SAT_LO_UA) ua = AOUT_SAT_LO_UA;
+   if(ua > AOUT_SAT_HI_UA) ua = AOUT_SAT_HI_UA;
+   aout_stat.target_ua = ua;
+   aout_stat.fault = 0;
+   aout_ramp_start(AOUT_CODE(ua));
+}
+
+/*****************************************************************************/
+/// \fn void aout_tick(void)
+/// @brief called from timer0() every tick: with no Flow for
+/// AOUT_STALE_TICKS the alarm current goes out, from here
+/*****************************************************************************/
+void aout_tick(void)
+{
+   if(aout_stale == 0 || --aout_stale != 0) return;
+   aout_stat.faults++;
+   aout_stat.fault = 1;
+   if(aout_stat.alarm_ua == 0) return;   /* hold; 1 to 5 uA is code 0 */
+   DMA0->DMA[DMA_CH_AOUT].DCR &= ~DMA_DCR_ERQ_MASK;
+   aout_dac_set(aout_alarm_code);
+}
+
+/*****************************************************************************/
+/// \fn UCHAR aout_range(uint32_t lo, uint32_t hi)
+/// @brief sets the Flow at 4 and at 20 mA, GPM (x100).  A span over 16
+/// bits is shifted down to 16 first, and the Flow with it in aout_update(),
+/// so aout_k keeps 15 bits or more: AOR 0 1000000 would be 4.6% low with
+/// 10 uA per 65536 GPM (x100) in place of 10.49.
+/// @return 1 if done, 0 unless lo < hi
+/*****************************************************************************/
+UCHAR aout_range(uint32_t lo, uint32_t hi)
+{
+   UCHAR sh = 0;
+
+   if(hi <= lo) return 0;
+   aout_stat.flow_lo = lo;
+   aout_stat.flow_hi = hi;
+   while(((hi - lo) >> sh) > 0xFFFF) sh++;
+   aout_sh = sh;
+   aout_k = ((uint32_t)AOUT_SPAN_UA << 16)/((hi - lo) >> sh);
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR aout_slew(uint16_t ma_s)
+/// @brief sets the slew limit, mA per second, 0 for none
+/// @return 1
+/*****************************************************************************/
+UCHAR aout_slew(uint16_t ma_s)
+{
+   uint32_t ua = (uint32_t)ma_s*1000/AOUT_UPDATE_HZ;  // per update
+   aout_stat.slew = ma_s;
+   if(ma_s == 0 || ua >= AOUT_FULL_UA) aout_step = AOUT_DAC_MAX;
+   else aout_step = AOUT_CODE(ua) ? AOUT_CODE(ua) : 1;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR aout_alarm(uint16_t ua)
+/// @brief sets the current for a fault, 0 to hold the output instead
+/// @param ua AOUT_ALARM_LO_UA or less, or AOUT_ALARM_HI_UA to AOUT_FULL_UA
+/// @return 1 if done, 0 for a current inside the measuring range
+/*****************************************************************************/
+UCHAR aout_alarm(uint16_t ua)
+{
+   if(ua != 0 && ((ua > AOUT_ALARM_LO_UA && ua < AOUT_ALARM_HI_UA) ||
+                  ua > AOUT_FULL_UA))
+      return 0;
+   aout_stat.alarm_ua = ua;
+   aout_alarm_code = AOUT_CODE(ua);
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn const struct aout_stat *aout_stat_get(void)
+/// @return the output settings, the current now and the counts, for AO
+/*****************************************************************************/
+const struct aout_stat *aout_stat_get(void)
+{
+   aout_stat.code = aout_dac();
+   aout_stat.out_ua = (uint32_t)aout_stat.code*AOUT_FULL_UA/AOUT_DAC_MAX;
+   return &aout_stat;
+}
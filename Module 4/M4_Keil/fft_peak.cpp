@@ -0,0 +1,347 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file fft_peak.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      fft_peak.cpp                                         --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Spectral peak frequency estimator, one of the engines behind readFREQ()
+   (freq_engine.cpp).  Meant for turbulent installations, where broadband
+   noise makes the zero crossing detector count extra edges.
+
+   A frame of 2^fp_log2n samples is captured from the ADC blocks, and one
+   estimate is made every fp_every blocks (fp_config(), the monitor 'FT'
+   command).  Blocks between frames are not looked at, so the CPU load
+   goes down with the cadence.  Per estimate:
+
+   I.   Remove the frame mean, scale to q14 and apply a Hann window
+   II.  Real FFT: the frame is packed as N/2 complex samples (even, odd),
+        transformed by an in place radix-2 q15 FFT that halves every stage
+        so nothing overflows, and split into the N/2+1 real spectrum bins
+        as they are needed
+   III. Find the strongest bin between FP_F_MIN and FP_F_MAX.  It is a
+        tone when it stands FP_PEAK_RATIO above the mean of the band
+   IV.  Refine between the bins from the magnitudes a, b, c of the peak and
+        its neighbours, offset = 2(c - a)/(a + 2b + c) bins.  For a Hann
+        window this ratio is exact for a pure tone (Grandke), where the
+        parabolic fit on magnitudes is off by up to a tenth of a bin.
+
+   Without a tone the last frequency is held, and dropped to 0 after a
+   second, as in the other engines.
+
+   The CMSIS-DSP library behind arm_math.h (arm_rfft_q15) is not part of
+   this project, so the FFT is done here with the sine table of
+   tone_track.cpp.  That table sets the largest frame, FP_LOG2N_MAX.
+   Cycles per estimate are kept in fp_vars().
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+#define FP_LOG2N_MIN      7       /* frame of 128 samples, 78 Hz bins */
+#define FP_LOG2N_MAX      9       /* 512, 19.5 Hz bins, SIN_Q15_SIZE limit */
+#define FP_N_MAX          (1 << FP_LOG2N_MAX)
+#define FP_EVERY_MAX      40      /* blocks per estimate, about 1 s */
+#define FP_F_MIN          5000    /* shedding band, Hz (x100), and at least
+                                     2 bins, the window width */
+#define FP_F_MAX          450000
+#define FP_PEAK_RATIO     16      /* peak bin power / mean bin power */
+#define FP_LOST_BLOCKS    (ADC_SAMPLE_HZ/ADC_BLOCK_SIZE)  /* 1 s, no flow */
+#define FP_HALF_COS       32766   /* cos(pi/256), q15 */
+#define FP_HALF_SIN       402     /* sin(pi/256), q15 */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static int16_t fp_buf[FP_N_MAX];       // frame, then its complex FFT
+   static UCHAR    fp_log2n = FP_LOG2N_MAX;
+   static UCHAR    fp_every = 2;          // blocks per estimate
+   static UCHAR    fp_count = 0;          // blocks into the period
+   static uint16_t fp_pos = 0;            // samples captured
+   static uint16_t fp_miss = 0;           // blocks without a tone
+   static uint32_t fp_freq = 0;           // latest estimate, Hz (x100)
+   static struct fft_peak_vars fp;        // settings and cycle counts
+
+/*****************************************************************************/
+/// \fn static uint32_t fp_isqrt(uint32_t x)
+/// @return floor(sqrt(x)), bit by bit, no divide
+/*****************************************************************************/
+static uint32_t fp_isqrt(uint32_t x)
+{
+   uint32_t r = 0, b = 1UL << 30;
+   while(b > x) b >>= 2;
+   while(b != 0)
+   {
+      if(x >= r + b)
+      {
+         x -= r + b;
+         r = (r >> 1) + b;
+      }
+      else
+         r >>= 1;
+      b >>= 2;
+   }
+   return r;
+}
+
+/*****************************************************************************/
+/// \fn static void fp_fft(int16_t *z, UCHAR log2m)
+/// @brief in place radix-2 FFT of 2^log2m complex q15 samples (re, im
+/// pairs), decimation in time.  Every stage halves, the result is the DFT
+/// over 2^log2m.
+/*****************************************************************************/
+static void fp_fft(int16_t *z, UCHAR log2m)
+{
+   uint16_t m = 1 << log2m;
+   uint16_t i, j, k, half, span;
+   UCHAR shift;
+   int16_t t;
+
+   // bit reversed order
+   for(i=1, j=0; i<m; i++)
+   {
+      for(k=m>>1; j & k; k>>=1) j ^= k;
+      j |= k;
+      if(i < j)
+      {
+         t = z[2*i];   z[2*i] = z[2*j];     z[2*j] = t;
+         t = z[2*i+1]; z[2*i+1] = z[2*j+1]; z[2*j+1] = t;
+      }
+   }
+
+   // butterflies, twiddle W = exp(-j 2pi k/span) from the sine table
+   for(half=1, shift=8-1; half<m; half<<=1, shift--)
+   {
+      span = half << 1;
+      for(k=0;k<half;k++)
+      {
+         UCHAR idx = k << shift;             // k*SIN_Q15_SIZE/span
+         int32_t wr = sin_q15[(UCHAR)(idx + SIN_Q15_SIZE/4)];
+         int32_t wi = -sin_q15[idx];
+         for(i=k;i<m;i+=span)
+         {
+            int16_t *a = &z[2*i], *b = &z[2*(i + half)];
+            int32_t tr = (b[0]*wr - b[1]*wi) >> 15;
+            int32_t ti = (b[0]*wi + b[1]*wr) >> 15;
+            int32_t ar = a[0], ai = a[1];
+            a[0] = (ar + tr) >> 1;  a[1] = (ai + ti) >> 1;
+            b[0] = (ar - tr) >> 1;  b[1] = (ai - ti) >> 1;
+         }
+      }
+   }
+}
+
+/*****************************************************************************/
+/// \fn static void fp_twiddle(UCHAR log2n, uint16_t k, int32_t *wr,
+///                            int32_t *wi)
+/// @brief W^k = exp(-j 2pi k/N), q15.  The sine table has a point every
+/// 1/256 turn, an odd k of a 512 frame is the point below turned on by
+/// half a step.
+/*****************************************************************************/
+static void fp_twiddle(UCHAR log2n, uint16_t k, int32_t *wr, int32_t *wi)
+{
+   UCHAR idx = (log2n > 8) ? (k >> (log2n - 8)) : (k << (8 - log2n));
+   int32_t c = sin_q15[(UCHAR)(idx + SIN_Q15_SIZE/4)];
+   int32_t s = sin_q15[idx];
+   if(log2n > 8 && (k & 1))
+   {                       // cos, sin of a + pi/256
+      int32_t c2 = (c*FP_HALF_COS - s*FP_HALF_SIN) >> 15;
+      s = (s*FP_HALF_COS + c*FP_HALF_SIN) >> 15;
+      c = c2;
+   }
+   *wr = c;
+   *wi = -s;
+}
+
+/*****************************************************************************/
+/// \fn static uint32_t fp_power(UCHAR log2n, uint16_t k)
+/// @brief bin k of the real spectrum from the complex FFT in fp_buf,
+/// X[k] = (Z[k] + Z*[m-k])/2 - j W^k (Z[k] - Z*[m-k])/2
+/// @return |X[k]|^2, 0 < k < N/2
+/*****************************************************************************/
+static uint32_t fp_power(UCHAR log2n, uint16_t k)
+{
+   uint16_t m = 1 << (log2n - 1);
+   const int16_t *p = &fp_buf[2*k], *q = &fp_buf[2*(m - k)];
+   int32_t er = p[0] + q[0], ei = p[1] - q[1];     // 2 x even part
+   int32_t orr = p[1] + q[1], oi = q[0] - p[0];    // 2 x odd part, -j(Z - Z*)
+   int32_t wr, wi, xr, xi;
+
+   fp_twiddle(log2n, k, &wr, &wi);
+   xr = (er + ((orr*wr - oi*wi) >> 15)) >> 1;
+   xi = (ei + ((orr*wi + oi*wr) >> 15)) >> 1;
+   return (uint32_t)(xr*xr) + (uint32_t)(xi*xi);
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR fp_estimate(void)
+/// @brief window, transform and search the captured frame
+/// @return 1 if a new frequency was published, 0 otherwise
+/*****************************************************************************/
+static UCHAR fp_estimate(void)
+{
+   uint16_t n = 1 << fp_log2n;
+   uint16_t i, k, kp, k_min, k_max;
+   uint32_t sum = 0, pw, peak = 0, band = 0;
+   uint32_t a, b, c, pos;
+   int32_t mean, x, w;
+   UCHAR idx;
+
+// I. Mean, q14, Hann window (1 - cos)/2, odd points of a 512 frame
+//    between two table points
+   for(i=0;i<n;i++) sum += fp_buf[i];
+   mean = sum >> fp_log2n;
+   for(i=0;i<n;i++)
+   {
+      idx = (fp_log2n > 8) ? (i >> (fp_log2n - 8)) : (i << (8 - fp_log2n));
+      w = sin_q15[(UCHAR)(idx + SIN_Q15_SIZE/4)];
+      if(fp_log2n > 8 && (i & 1))
+         w = (w + sin_q15[(UCHAR)(idx + 1 + SIN_Q15_SIZE/4)]) >> 1;
+      x = (fp_buf[i] - mean) >> 1;
+      fp_buf[i] = (x*((32768 - w) >> 1)) >> 15;
+   }
+
+// II. FFT of the even/odd pairs
+   fp_fft(fp_buf, fp_log2n - 1);
+
+// III. Peak in the band
+   k_min = ((uint32_t)FP_F_MIN << fp_log2n)/(100UL*ADC_SAMPLE_HZ);
+   k_max = ((uint32_t)FP_F_MAX << fp_log2n)/(100UL*ADC_SAMPLE_HZ);
+   if(k_min < 2) k_min = 2;
+   if(k_max > n/2 - 2) k_max = n/2 - 2;
+   kp = k_min;
+   for(k=k_min;k<=k_max;k++)
+   {
+      pw = fp_power(fp_log2n, k);
+      band += pw >> 8;
+      if(pw > peak) { peak = pw; kp = k; }
+   }
+   // peak/mean > ratio, with band and the mean scaled by 1/256
+   if(peak == 0 ||
+      (peak >> 8)*(k_max - k_min + 1) < band*FP_PEAK_RATIO) return 0;
+
+// IV. Between the bins, offset = 2(c - a)/(a + 2b + c)
+   a = fp_isqrt(fp_power(fp_log2n, kp - 1));
+   b = fp_isqrt(peak);
+   c = fp_isqrt(fp_power(fp_log2n, kp + 1));
+   pos = (uint32_t)kp << 8;                       // bins, Q8
+   if(c >= a) pos += ((c - a) << 9)/(a + 2*b + c);
+   else       pos -= ((a - c) << 9)/(a + 2*b + c);
+   fp_freq = ((uint64_t)pos*(100UL*ADC_SAMPLE_HZ) + (1UL << (fp_log2n + 7)))
+             >> (fp_log2n + 8);
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn void fp_init(void)
+/// @brief starts a new frame, holding the last published frequency
+/*****************************************************************************/
+void fp_init(void)
+{
+   fp_freq = frequency;
+   fp_count = 0;
+   fp_pos = 0;
+   fp_miss = 0;
+   fp.cycles_last = 0;
+   fp.cycles_max = 0;
+   fp.estimates = 0;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR fp_config(UCHAR log2n, UCHAR every)
+/// @brief sets the frame size and the cadence, and starts a new frame
+/// @param log2n frame of 2^log2n samples, FP_LOG2N_MIN..FP_LOG2N_MAX
+/// @param every ADC blocks per estimate, at least the blocks of a frame
+/// @return 1 if set, 0 if out of range
+/*****************************************************************************/
+UCHAR fp_config(UCHAR log2n, UCHAR every)
+{
+   if(log2n < FP_LOG2N_MIN || log2n > FP_LOG2N_MAX) return 0;
+   if(every > FP_EVERY_MAX ||
+      (uint16_t)every*ADC_BLOCK_SIZE < (1U << log2n)) return 0;
+   fp_log2n = log2n;
+   fp_every = every;
+   fp_count = 0;
+   fp_pos = 0;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR fp_block(const uint16_t *blk, uint16_t n)
+/// @brief captures the blocks that make up the frame, the last fp_every
+/// of the period, and estimates on the last one
+/// @param blk raw 16 bit ADC readings
+/// @return 1 if a new frequency was published, 0 otherwise
+/*****************************************************************************/
+UCHAR fp_block(const uint16_t *blk, uint16_t n)
+{
+   uint16_t size = 1 << fp_log2n;
+   uint16_t i, start = 0;
+   uint32_t t0;
+   UCHAR found;
+
+   fp_count++;
+   if(fp_count + (size + n - 1)/n <= fp_every)
+      return 0;                            // not in the frame yet
+
+   if(n > size - fp_pos) start = n - (size - fp_pos);   // the newest ones
+   for(i=start;i<n;i++) fp_buf[fp_pos++] = blk[i] >> 1; // 0..32767
+   if(fp_count < fp_every) return 0;
+
+   fp_count = 0;
+   fp_pos = 0;
+   t0 = cycle_stamp();
+   found = fp_estimate();
+   fp.cycles_last = cycles_since(t0);
+   if(fp.cycles_last > fp.cycles_max) fp.cycles_max = fp.cycles_last;
+   fp.estimates++;
+
+   if(found)
+   {
+      fp_miss = 0;
+      return 1;
+   }
+   fp_miss += fp_every;
+   if(fp_freq == 0 || fp_miss < FP_LOST_BLOCKS) return 0;
+   fp_freq = 0;                            // no flow
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t fp_frequency(void)
+/// @return the latest published frequency in Hz (x100), 0 if no signal
+/*****************************************************************************/
+uint32_t fp_frequency(void)
+{
+   return fp_freq;
+}
+
+/*****************************************************************************/
+/// \fn const struct fft_peak_vars *fp_vars(void)
+/// @return the frame settings and the cycles per estimate
+/*****************************************************************************/
+const struct fft_peak_vars *fp_vars(void)
+{
+   fp.log2n = fp_log2n;
+   fp.every = fp_every;
+   return &fp;
+}
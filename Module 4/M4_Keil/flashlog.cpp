@@ -0,0 +1,604 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file flashlog.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      flashlog.cpp                                         --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Flow history in the KL25Z's own flash: a record of time, Flow,
+   frequency and temperature every flog_every seconds (LOG<s> command),
+   kept through power cycles, read back with LOGD.
+
+   The mbed library built for this target has no flash_api, so FlashIAP
+   is not there to use.  The flash controller (FTFA) is driven here
+   directly, with the two commands the logger needs: program longword and
+   erase sector.
+
+   Records are taken by a software timer callback into a RAM stage, the
+   first with its values and the rest as zigzag varint changes (format in
+   shared.h), about 4 bytes each while the flow is steady.  When the stage
+   is nearly full, or a LOGD needs it, it is moved whole into a chunk,
+   headed by the values of its first record, and the stage fills again
+   while the chunk goes to flash.  A chunk is the unit that is either in
+   flash or not: its longwords are programmed last to first, and the
+   first holds the length, so a chunk cut short by a power loss reads as
+   no chunk at all.
+
+   The flash is also where the code runs from, and it cannot be read
+   while a command runs.  So the CPU waits in flash_exec(), which runs
+   from RAM (RAMCODE in the scatter file), with interrupts masked, as
+   their vectors and handlers are in flash too.  flog_run(), a low
+   priority task, does one step per release: one longword (65 us), or
+   FLOG_SLICE_US of a sector erase, which is then suspended (ERSSUSP)
+   and resumed on the next release.  A 14 ms erase is done in slices over
+   a couple of seconds.  Each resume costs some of the slice, and an
+   erase suspended too often may make no progress, so after
+   FLOG_SLICES_MAX slices (120 ms of erase, more than the data sheet's
+   longest) the rest is waited out unsuspended and counted as a timeout.
+
+   That does not keep the mask within a tick: a longword takes up to
+   145 us, a slice ends with the suspend latency on top of FLOG_SLICE_US,
+   and a timed out erase masks for the rest of it.  At the 100 us tick a
+   longword can lose one.  flash_cmd() tells pit_tick_masked() each
+   stretch, so TICK shows the longest and the ticks missed; stall_max in
+   LOG is the longest here.
+
+   Wear levelling: the sectors are used in turn, each with a sequence
+   number in its header.  The one after the sector being written is
+   erased ahead, so it is ready when the current one fills, and so the
+   log holds the last FLOG_SECTORS - 1 of them.  Every sector is erased
+   once per turn of the ring whatever the record rate.  After a power up
+   the next sector after the newest is started, the tail of the last one
+   is not appended to, it may end in a chunk cut short.
+
+   Records still in the stage at a power loss are lost, up to about 25
+   of them.  The stage is flushed before a LOGD read back.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+#include "MKL25Z4.h"
+
+#define FLOG_SLICE_US      60    /* longest erase step, interrupts masked */
+#define FLOG_SLICES_MAX    2000  /* then the erase is finished in one go */
+#define FLOG_STAGE_SIZE    104   /* record changes in RAM */
+#define FLOG_REC_MAX       20    /* longest record, 4 varints of 5 bytes */
+#define FLOG_CHUNK_SIZE    128   /* length byte, first record, the stage */
+#define FLOG_NONE          0xFF  /* no sector */
+#define FLOG_DUMP_FRAMES   3     /* LOGD frames per flog_dump_poll() */
+
+#define FTFA_CMD_PROGRAM   0x06  /* program longword */
+#define FTFA_CMD_ERASE     0x09  /* erase flash sector */
+#define FTFA_ERRORS (FTFA_FSTAT_ACCERR_MASK | FTFA_FSTAT_FPVIOL_MASK | \
+                     FTFA_FSTAT_MGSTAT0_MASK)
+
+#ifndef FLASH_MEM
+#define FLASH_MEM ((uintptr_t)0)       /* program flash, from address 0 */
+#endif
+#define FLOG_SECTOR(s) (FLOG_BASE + (uint32_t)(s)*FLOG_SECTOR_SIZE)
+#define FLOG_MEM(s) ((const UCHAR *)(FLASH_MEM + FLOG_SECTOR(s)))  /* sector s */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   struct flog_point                      // one record, absolute
+   {
+      uint32_t time;                      // 0.1 s since the boot
+      uint32_t flow;
+      uint32_t freq;
+      uint32_t temp;
+   };
+
+   static struct flog_stat flog_stat;
+   static struct swtimer flog_timer;      // releases flog_sample()
+   static uint32_t flog_tick_last;        // System_Timer_count at the last
+   static uint32_t flog_tick_rem;         //   record, and ticks left over
+   static uint32_t flog_time = 0;         // 0.1 s since the boot
+
+   static UCHAR flog_stage[FLOG_STAGE_SIZE];   // changes after the first
+   static uint16_t flog_stage_n = 0;
+   static uint16_t flog_stage_recs = 0;
+   static struct flog_point flog_first, flog_last;
+
+   static UCHAR flog_chunk[FLOG_CHUNK_SIZE];   // being programmed
+   static uint16_t flog_chunk_n = 0;           // bytes, longword multiple
+   static uint16_t flog_chunk_next = 0;        // next longword, last first
+   static uint32_t flog_chunk_addr;
+
+   static UCHAR flog_cur = FLOG_NONE;     // sector being written
+   static uint16_t flog_ofs;              // next chunk in it
+   static UCHAR flog_ahead;               // the next one, erased ahead
+   static UCHAR flog_newest = FLOG_NONE;  // last one started, for LOGD
+   static uint32_t flog_seq = 1;          // of the next sector started
+   static uint16_t flog_erase_mask = 0;   // sectors to erase
+   static UCHAR flog_erasing = FLOG_NONE; // erase started, suspended
+   static uint16_t flog_slices;           // of the erase under way
+   static UCHAR flog_flush = 0;           // stage to flash now
+
+   static UCHAR flog_dump = 0;            // LOGD: 1 flushing, 2 sending
+   static UCHAR flog_dump_i;              // sectors looked at, oldest first
+   static UCHAR flog_dump_s;              // the one being sent
+   static uint16_t flog_dump_pos;
+   static uint16_t flog_dump_end;
+
+#ifdef __CC_ARM
+#pragma arm section code = "RAMCODE"
+#endif
+/*****************************************************************************/
+/// \fn static UCHAR flash_exec(uint32_t budget)
+/// @brief launches (or resumes) the command in FCCOB and waits for it.
+/// Runs from RAM with interrupts masked: nothing may be fetched from flash
+/// until the command is done, so no calls.  noinline, as armcc at -O3
+/// inlines a static function called once, and the copy in flash_cmd()
+/// would run from flash.
+/// @param budget core clock cycles before an erase is suspended, 0 to wait
+/// for the end
+/// @return FSTAT, ERSSUSP in FCNFG tells a suspended erase
+/*****************************************************************************/
+static __attribute__((noinline)) UCHAR flash_exec(uint32_t budget)
+{
+   uint32_t start = SysTick->VAL;                /* counts down */
+
+   FTFA->FSTAT = FTFA_FSTAT_CCIF_MASK;           /* launch */
+   while(!(FTFA->FSTAT & FTFA_FSTAT_CCIF_MASK))
+   {
+      if(budget && ((start - SysTick->VAL) & CYCLE_MASK) > budget)
+      {
+         FTFA->FCNFG |= FTFA_FCNFG_ERSSUSP_MASK; /* suspend the erase */
+         while(!(FTFA->FSTAT & FTFA_FSTAT_CCIF_MASK));
+         break;
+      }
+   }
+   return FTFA->FSTAT;
+}
+#ifdef __CC_ARM
+#pragma arm section code
+#endif
+
+/*****************************************************************************/
+/// \fn static UCHAR flash_cmd(UCHAR cmd, uint32_t addr, const UCHAR *data,
+///                            uint32_t budget)
+/// @brief runs one FTFA command, or a slice of an erase
+/// @param data the 4 bytes for FTFA_CMD_PROGRAM, in address order
+/// @return 0 if it failed, else 1
+/*****************************************************************************/
+static UCHAR flash_cmd(UCHAR cmd, uint32_t addr, const UCHAR *data,
+                       uint32_t budget)
+{
+   uint32_t start, phase;
+   UCHAR fstat;
+
+   FTFA->FSTAT = FTFA_FSTAT_ACCERR_MASK | FTFA_FSTAT_FPVIOL_MASK; /* w1c */
+   FTFA->FCNFG &= ~FTFA_FCNFG_ERSSUSP_MASK;   /* a suspended erase resumes */
+   FTFA->FCCOB0 = cmd;
+   FTFA->FCCOB1 = addr >> 16;
+   FTFA->FCCOB2 = addr >> 8;
+   FTFA->FCCOB3 = addr;
+   if(data)
+   {
+      FTFA->FCCOB4 = data[3];
+      FTFA->FCCOB5 = data[2];
+      FTFA->FCCOB6 = data[1];
+      FTFA->FCCOB7 = data[0];
+   }
+   TRACE(TR_FLASH, cmd);
+   __disable_irq();
+   phase = pit_tick_phase();
+   start = cycle_stamp();
+   fstat = flash_exec(budget);
+   start = cycles_since(start);
+   pit_tick_masked(phase, start);             /* the ticks it held back */
+   __enable_irq();
+   TRACE(TR_FLASH_END, fstat);
+   if(start > flog_stat.stall_max) flog_stat.stall_max = start;
+   MCM->PLACR |= MCM_PLACR_CFCC_MASK;         /* stale lines in the cache */
+   if(fstat & FTFA_ERRORS)
+   {
+      flog_stat.errors++;
+      return 0;
+   }
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn static uint32_t flog_get32(const UCHAR *p)
+/// @return the little endian 32 bits at p
+/*****************************************************************************/
+static uint32_t flog_get32(const UCHAR *p)
+{
+   return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR flog_valid(UCHAR s)
+/// @return 1 if sector s has a header and is not waiting to be erased
+/*****************************************************************************/
+static UCHAR flog_valid(UCHAR s)
+{
+   const UCHAR *h = FLOG_MEM(s);
+   return (h[0] | (h[1] << 8)) == FLOG_MAGIC && s != flog_erasing &&
+          !(flog_erase_mask & (1 << s));
+}
+
+/*****************************************************************************/
+/// \fn static uint16_t flog_used(UCHAR s)
+/// @return bytes of sector s in use, header and whole chunks
+/*****************************************************************************/
+static uint16_t flog_used(UCHAR s)
+{
+   const UCHAR *p = FLOG_MEM(s);
+   uint16_t ofs = FLOG_HDR_SIZE;
+   while(ofs < FLOG_SECTOR_SIZE && p[ofs] != FLOG_CHUNK_NONE && p[ofs] != 0)
+      ofs += (p[ofs] + 1 + 3) & ~3;
+   return ofs < FLOG_SECTOR_SIZE ? ofs : FLOG_SECTOR_SIZE;
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR flog_blank(UCHAR s)
+/// @return 1 if sector s reads as erased
+/*****************************************************************************/
+static UCHAR flog_blank(UCHAR s)
+{
+   const uint32_t *p = (const uint32_t *)FLOG_MEM(s);
+   uint16_t i;
+   for(i=0;i<FLOG_SECTOR_SIZE/4;i++)
+      if(p[i] != 0xFFFFFFFF) return 0;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR flog_varint(UCHAR *p, uint32_t x)
+/// @brief 7 bits a byte, least significant first
+/// @return bytes stored
+/*****************************************************************************/
+static UCHAR flog_varint(UCHAR *p, uint32_t x)
+{
+   UCHAR n = 0;
+   while(x >= 0x80)
+   {
+      p[n++] = x | 0x80;
+      x >>= 7;
+   }
+   p[n++] = x;
+   return n;
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR flog_zigzag(UCHAR *p, uint32_t now, uint32_t before)
+/// @brief stores the change as a varint, small either way is short
+/// @return bytes stored
+/*****************************************************************************/
+static UCHAR flog_zigzag(UCHAR *p, uint32_t now, uint32_t before)
+{
+   int32_t d = (int32_t)(now - before);
+   return flog_varint(p, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+}
+
+/*****************************************************************************/
+/// \fn static void flog_sample(void *arg)
+/// @brief the record timer: stages the latest Flow, frequency and
+/// temperature
+/*****************************************************************************/
+static void flog_sample(void *arg)
+{
+   struct flog_point p;
+   UCHAR *s;
+   uint32_t now = System_Timer_count;
+   uint32_t ticks = now - flog_tick_last + flog_tick_rem;
+
+   flog_tick_last = now;
+   flog_time += ticks/(SEC/10);
+   flog_tick_rem = ticks%(SEC/10);
+   p.time = flog_time;
+   p.flow = Flow;
+   p.freq = frequency;
+   p.temp = temperature;
+
+   if(flog_stage_recs == 0) flog_first = p;
+   else if(flog_stage_n + FLOG_REC_MAX > FLOG_STAGE_SIZE)
+   {                                       // the chunk has not gone yet
+      flog_stat.drops++;
+      return;
+   }
+   else
+   {
+      s = &flog_stage[flog_stage_n];
+      s += flog_varint(s, p.time - flog_last.time);
+      s += flog_zigzag(s, p.flow, flog_last.flow);
+      s += flog_zigzag(s, p.freq, flog_last.freq);
+      s += flog_zigzag(s, p.temp, flog_last.temp);
+      flog_stage_n = s - flog_stage;
+   }
+   flog_last = p;
+   flog_stage_recs++;
+   flog_stat.records++;
+}
+
+/*****************************************************************************/
+/// \fn static void flog_cut(void)
+/// @brief moves the stage into the chunk, for the current sector
+/*****************************************************************************/
+static void flog_cut(void)
+{
+   UCHAR *c = &flog_chunk[1];
+   uint16_t n;
+
+   c += flog_varint(c, flog_first.time);
+   c += flog_varint(c, flog_first.flow);
+   c += flog_varint(c, flog_first.freq);
+   c += flog_varint(c, flog_first.temp);
+   memcpy(c, flog_stage, flog_stage_n);
+   n = c + flog_stage_n - flog_chunk;
+   flog_chunk[0] = n - 1;                  // length of the records
+   while(n & 3) flog_chunk[n++] = 0xFF;
+   flog_chunk_n = n;
+   flog_chunk_next = n - 4;
+   flog_chunk_addr = FLOG_SECTOR(flog_cur) + flog_ofs;
+   flog_ofs += n;
+   flog_stage_n = 0;
+   flog_stage_recs = 0;
+}
+
+/*****************************************************************************/
+/// \fn static void flog_start_sector(void)
+/// @brief makes the erased sector ahead the current one: its header goes
+/// out as a chunk, and the one after it is erased ahead
+/*****************************************************************************/
+static void flog_start_sector(void)
+{
+   flog_cur = flog_ahead;
+   flog_newest = flog_cur;
+   flog_chunk[0] = FLOG_MAGIC & 0xFF;
+   flog_chunk[1] = FLOG_MAGIC >> 8;
+   flog_chunk[FLOG_OFS_BOOT] = flog_stat.boot;
+   flog_chunk[FLOG_OFS_BOOT + 1] = flog_stat.boot >> 8;
+   flog_chunk[FLOG_OFS_SEQ] = flog_seq;
+   flog_chunk[FLOG_OFS_SEQ + 1] = flog_seq >> 8;
+   flog_chunk[FLOG_OFS_SEQ + 2] = flog_seq >> 16;
+   flog_chunk[FLOG_OFS_SEQ + 3] = flog_seq >> 24;
+   flog_seq++;
+   flog_chunk_n = FLOG_HDR_SIZE;
+   flog_chunk_next = FLOG_HDR_SIZE - 4;    // the magic goes last
+   flog_chunk_addr = FLOG_SECTOR(flog_cur);
+   flog_ofs = FLOG_HDR_SIZE;
+   flog_ahead = (flog_cur + 1) % FLOG_SECTORS;
+   flog_erase_mask |= 1 << flog_ahead;
+}
+
+/*****************************************************************************/
+/// \fn void flog_init(void)
+/// @brief finds the newest sector of the log, queues the erase of the next
+/// one and starts the record timer.  Call after swt_init().
+/*****************************************************************************/
+void flog_init(void)
+{
+   const UCHAR *h;
+   uint32_t seq, newest_seq = 0;
+   UCHAR s;
+
+   flog_newest = FLOG_NONE;
+   flog_stat.boot = 1;
+   for(s=0;s<FLOG_SECTORS;s++)
+   {
+      h = FLOG_MEM(s);
+      if((h[0] | (h[1] << 8)) != FLOG_MAGIC) continue;
+      seq = flog_get32(&h[FLOG_OFS_SEQ]);
+      if(flog_newest == FLOG_NONE || (int32_t)(seq - newest_seq) > 0)
+      {
+         flog_newest = s;
+         newest_seq = seq;
+         flog_stat.boot = (h[FLOG_OFS_BOOT] | (h[FLOG_OFS_BOOT + 1] << 8)) + 1;
+      }
+   }
+   flog_seq = newest_seq + 1;
+   flog_ahead = (flog_newest == FLOG_NONE) ? 0 : (flog_newest + 1) % FLOG_SECTORS;
+   flog_erase_mask = 1 << flog_ahead;
+   flog_cur = FLOG_NONE;
+
+   flog_tick_last = System_Timer_count;
+   swt_setup(&flog_timer, flog_sample, NULL, NULL);
+   if(flog_stat.every == 0) flog_stat.every = FLOG_EVERY_DEFAULT;
+   flog_config(flog_stat.every);
+}
+
+/*****************************************************************************/
+/// \fn UCHAR flog_config(uint16_t every)
+/// @brief sets the seconds between records, the next one is that far away
+/// @return 1 if done, 0 if every is out of range
+/*****************************************************************************/
+UCHAR flog_config(uint16_t every)
+{
+   uint32_t ticks = (uint32_t)every*SEC;
+   if(every < 1 || every > FLOG_EVERY_MAX) return 0;
+   flog_stat.every = every;
+   swt_start(&flog_timer, ticks, ticks);
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn void flog_clear(void)
+/// @brief forgets the log: every sector is erased, the staged records
+/// start the new log
+/*****************************************************************************/
+void flog_clear(void)
+{
+   flog_erase_mask = (1 << FLOG_SECTORS) - 1;
+   flog_chunk_n = 0;                       // its sector goes too
+   flog_cur = FLOG_NONE;
+   flog_newest = FLOG_NONE;
+   flog_ahead = 0;
+   flog_dump = 0;
+}
+
+/*****************************************************************************/
+/// \fn void flog_run(void)
+/// @brief the logger task, one flash step per release: a slice of the
+/// erase under way, a longword of the chunk, the start of an erase, or
+/// the stage moved to a chunk
+/*****************************************************************************/
+void flog_run(void)
+{
+   uint32_t budget;
+   UCHAR s;
+
+   if(flog_erasing != FLOG_NONE)
+   {
+      budget = FLOG_SLICE_US*(SystemCoreClock/1000000);
+      if(++flog_slices > flog_stat.slices_max) flog_stat.slices_max = flog_slices;
+      if(flog_slices >= FLOG_SLICES_MAX)
+      {                                    // not getting there in slices
+         flog_stat.erase_timeouts++;
+         budget = 0;
+      }
+      if(!flash_cmd(FTFA_CMD_ERASE, FLOG_SECTOR(flog_erasing), NULL, budget) ||
+         !(FTFA->FCNFG & FTFA_FCNFG_ERSSUSP_MASK))
+      {                                    // done, or given up
+         if(!(FTFA->FSTAT & FTFA_ERRORS)) flog_stat.erases++;
+         flog_erase_mask &= ~(1 << flog_erasing);
+         flog_erasing = FLOG_NONE;
+      }
+      return;
+   }
+
+   if(flog_chunk_n != 0)
+   {                                       // the first longword last
+      if(!flash_cmd(FTFA_CMD_PROGRAM, flog_chunk_addr + flog_chunk_next,
+                    &flog_chunk[flog_chunk_next], 0))
+         flog_chunk_n = 0;                 // the chunk reads as none
+      else if(flog_chunk_next == 0) flog_chunk_n = 0;
+      else flog_chunk_next -= 4;
+      return;
+   }
+
+   if(flog_stage_recs != 0 &&
+      (flog_flush || flog_stage_n + FLOG_REC_MAX > FLOG_STAGE_SIZE))
+   {
+      if(flog_cur != FLOG_NONE &&
+         flog_ofs + FLOG_CHUNK_SIZE <= FLOG_SECTOR_SIZE)
+      {
+         flog_cut();
+         return;
+      }
+      if(!(flog_erase_mask & (1 << flog_ahead)))
+      {
+         flog_start_sector();              // the stage goes next time
+         return;
+      }
+   }
+   else flog_flush = 0;
+
+   if(flog_erase_mask != 0)
+   {
+      for(s=0; !(flog_erase_mask & (1 << s)); s++);
+      if(flog_blank(s)) flog_erase_mask &= ~(1 << s);
+      else
+      {
+         flog_erasing = s;                 // the first slice next time
+         flog_slices = 0;
+      }
+   }
+}
+
+/*****************************************************************************/
+/// \fn void flog_dump_start(void)
+/// @brief LOGD: the staged records go to flash, then flog_dump_poll()
+/// sends the log
+/*****************************************************************************/
+void flog_dump_start(void)
+{
+   flog_flush = 1;
+   flog_dump = 1;
+   flog_dump_i = 0;
+   flog_dump_s = 0;
+   flog_dump_pos = 0;
+   flog_dump_end = 0;
+}
+
+/*****************************************************************************/
+/// \fn void flog_dump_poll(void)
+/// @brief sends a few frames of the LOGD read back when the transmit buffer
+/// has room, called every monitor() pass.  The sectors go oldest first,
+/// each up to its last chunk, as TEL_TYPE_LOG frames; a frame with
+/// position TEL_LOG_END ends it.
+/*****************************************************************************/
+void flog_dump_poll(void)
+{
+   UCHAR rec[TEL_LOG_FRAME_MAX];
+   UCHAR f, s, n;
+
+   if(flog_dump == 1)
+   {
+      if(flog_flush || flog_stage_recs != 0 || flog_chunk_n != 0) return;
+      flog_dump = 2;
+   }
+   if(flog_dump != 2) return;
+
+   for(f=0; f<FLOG_DUMP_FRAMES; f++)
+   {
+      if(!flog_valid(flog_dump_s)) flog_dump_end = 0;  // erased meanwhile
+      while(flog_dump_pos >= flog_dump_end && flog_dump_i < FLOG_SECTORS)
+      {                                    // the next sector with records
+         s = (flog_newest == FLOG_NONE) ? flog_dump_i :
+             (flog_newest + 1 + flog_dump_i) % FLOG_SECTORS;
+         flog_dump_i++;
+         flog_dump_s = s;
+         flog_dump_pos = 0;
+         flog_dump_end = flog_valid(s) ? flog_used(s) : 0;
+      }
+      rec[TEL_OFS_TYPE] = TEL_TYPE_LOG;
+      if(flog_dump_pos >= flog_dump_end)
+      {                                    // all sent
+         memset(&rec[TEL_LOG_OFS_SEQ], 0, 4);
+         rec[TEL_LOG_OFS_POS] = TEL_LOG_END & 0xFF;
+         rec[TEL_LOG_OFS_POS + 1] = TEL_LOG_END >> 8;
+         if(tel_frame_put(rec, TEL_LOG_OFS_DATA)) flog_dump = 0;
+         return;
+      }
+      s = flog_dump_s;
+      n = (flog_dump_end - flog_dump_pos > TEL_LOG_DATA_MAX) ? TEL_LOG_DATA_MAX :
+          flog_dump_end - flog_dump_pos;
+      memcpy(&rec[TEL_LOG_OFS_SEQ], FLOG_MEM(s) + FLOG_OFS_SEQ, 4);
+      rec[TEL_LOG_OFS_POS] = flog_dump_pos;
+      rec[TEL_LOG_OFS_POS + 1] = flog_dump_pos >> 8;
+      memcpy(&rec[TEL_LOG_OFS_DATA], FLOG_MEM(s) + flog_dump_pos, n);
+      if(!tel_frame_put(rec, TEL_LOG_OFS_DATA + n)) return;
+      flog_dump_pos += n;
+   }
+}
+
+/*****************************************************************************/
+/// \fn const struct flog_stat *flog_stat_get(void)
+/// @return the logger settings and counts, for the LOG command
+/*****************************************************************************/
+const struct flog_stat *flog_stat_get(void)
+{
+   UCHAR s;
+   flog_stat.sectors = 0;
+   flog_stat.erasing = 0;
+   for(s=0;s<FLOG_SECTORS;s++)
+   {
+      if(flog_valid(s)) flog_stat.sectors++;
+      if((flog_erase_mask & (1 << s)) || s == flog_erasing) flog_stat.erasing++;
+   }
+   flog_stat.staged = flog_stage_recs;
+   return &flog_stat;
+}
@@ -0,0 +1,211 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file flow_engine.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      flow_engine.cpp                                      --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Integer flow computation, replacing the float expressions that were in
+   calculate_flow().  The KL25Z has no FPU, so every float or double there
+   was a library call.  Each update is:
+
+   I.   Fluid properties at the temperature, table lookups (flow_lut.cpp)
+   II.  Strouhal number at the last Reynolds number, table lookup, and a
+        running average of it (Q16, 2^FE_ST_SHIFT updates)
+   III. velocity = f*d/St                         two 32 bit divides
+        Re       = rho*velocity*PID/viscosity     in total, the
+        Flow     = 2.45*PID^2*velocity/12         rest is multiply/shift
+
+   The constants below fold the pipe geometry and the unit conversions of
+   the original formulas into integers (Q noted with each).  Every product
+   is bounded for frequencies up to the Nyquist rate, see the notes.
+   tools/check_flow_engine.cpp runs this against the float formulas.
+
+   The pipe and bluff body can be changed at run time (PIPE command),
+   flow_engine_pipe() works the constants out again for them.  The ranges
+   it takes keep the products in bounds.  The St average length is the
+   AVG command, flow_engine_avg().
+
+   Units are the ones used everywhere else: frequency and temperature
+   x100, viscosity x1,000,000, density kg/m^3, St x10,000, velocity
+   in/s x100, Flow GPM x100.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+/****************************************************************
+ * Bluff body width d = 0.5 in, pipe inner diameter PID = 2.900 in
+ * (PIDm = 0.07366 m)
+ ***************************************************************/
+#define FE_VEL_K       5000UL    /* 10000*d (x100 f, x10,000 St) */
+#define FE_RE_K_INT    18UL      /* 1,000,000*PIDm/3937 = 18.7097, the */
+#define FE_RE_K_FRAC   182UL     /*   integer part and the fraction Q8 */
+#define FE_FLOW_K_INT  1UL       /* 2.45*PID*PID/12 = 1.7170, the */
+#define FE_FLOW_K_FRAC 2937UL    /*   integer part and the fraction Q12 */
+#define FE_ST_SHIFT    4         /* St average time constant, 16 updates */
+#define FE_PID_MIN     500       /* pipe inner diameter range, 0.001 in */
+#define FE_PID_MAX     10000
+#define FE_D_MIN       100       /* bluff body width range, 0.001 in; */
+#define FE_D_MAX       800       /*   f*FE_VEL_K fits 32 bits to 5.3 kHz */
+#define FE_ST_SHIFT_MAX 7
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static struct flow_vars fe;         // results of the last update
+   static uint32_t fe_St_avg = 0;      // St average (x10,000, Q16), 0 = none
+   static struct flow_params fe_par = {2900, 500, FE_ST_SHIFT};
+   static uint32_t fe_vel_k = FE_VEL_K;        // the constants for fe_par
+   static uint32_t fe_re_k_int = FE_RE_K_INT;
+   static uint32_t fe_re_k_frac = FE_RE_K_FRAC;
+   static uint32_t fe_flow_k_int = FE_FLOW_K_INT;
+   static uint32_t fe_flow_k_frac = FE_FLOW_K_FRAC;
+
+/*****************************************************************************/
+/// \fn static uint32_t fe_mul_frac(uint32_t x, uint32_t frac, UCHAR q)
+/// @brief x*frac/2^q rounded, for frac < 2^q, without the 32 bit product:
+/// the whole multiples of 2^q in x are multiplied apart, exactly
+/*****************************************************************************/
+static uint32_t fe_mul_frac(uint32_t x, uint32_t frac, UCHAR q)
+{
+   uint32_t mask = (1UL << q) - 1;
+   return (x >> q)*frac + (((x & mask)*frac + (1UL << (q - 1))) >> q);
+}
+
+/*****************************************************************************/
+/// \fn UCHAR flow_engine_pipe(uint16_t pid, uint16_t d)
+/// @brief sets the pipe inner diameter and bluff body width, in 0.001 in,
+/// and works out the constants for them
+/// @return 1 if done, 0 if either is out of range
+/*****************************************************************************/
+UCHAR flow_engine_pipe(uint16_t pid, uint16_t d)
+{
+   uint32_t k;
+
+   if(pid < FE_PID_MIN || pid > FE_PID_MAX || d < FE_D_MIN || d > FE_D_MAX)
+      return 0;
+   fe_par.pid = pid;
+   fe_par.d = d;
+   fe_vel_k = 10UL*d;                                  // 10000*d in inches
+   //1,000,000*PID*0.0254/3937 in Q8 = PID(0.001 in)*65024/39370
+   k = ((uint32_t)pid*65024UL + 19685UL)/39370UL;
+   fe_re_k_int = k >> 8;
+   fe_re_k_frac = k & 0xFF;
+   //2.45*PID*PID/12 in Q12 = PID(0.001 in)^2/1000*12544/15000
+   k = (((uint32_t)pid*pid + 500UL)/1000UL*12544UL + 7500UL)/15000UL;
+   fe_flow_k_int = k >> 12;
+   fe_flow_k_frac = k & 0xFFF;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR flow_engine_avg(UCHAR shift)
+/// @brief sets the St running average to 2^shift updates, 0 for none
+/// @return 1 if done, 0 if shift is out of range
+/*****************************************************************************/
+UCHAR flow_engine_avg(UCHAR shift)
+{
+   if(shift > FE_ST_SHIFT_MAX) return 0;
+   fe_par.st_shift = shift;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn const struct flow_params *flow_engine_params(void)
+/// @return the pipe and average settings
+/*****************************************************************************/
+const struct flow_params *flow_engine_params(void)
+{
+   return &fe_par;
+}
+
+/*****************************************************************************/
+/// \fn void flow_engine_init(uint32_t Re)
+/// @brief starts over from a first guess of the Reynolds number
+/*****************************************************************************/
+void flow_engine_init(uint32_t Re)
+{
+   fe.viscosity = 0;
+   fe.density = 0;
+   fe.St = 0;
+   fe.St_const = 0;
+   fe.velocity = 0;
+   fe.Re = Re;
+   fe.Flow = 0;
+   fe.cycles_last = 0;
+   fe.cycles_max = 0;
+   fe_St_avg = 0;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t flow_engine_update(uint32_t freq, uint32_t temp)
+/// @brief one flow computation
+/// @param freq vortex frequency in Hz (x100)
+/// @param temp temperature in Celsius (x100)
+/// @return flow in GPM (x100)
+/*****************************************************************************/
+uint32_t flow_engine_update(uint32_t freq, uint32_t temp)
+{
+   uint32_t start = cycle_stamp();
+   uint32_t q;
+
+// I. Fluid properties
+   //viscosity = 24*10^(24780/(T(K x100) - 14000))
+   fe.viscosity = lut_viscosity(temp);               // (x1,000,000)
+   //rho_density = 1000*(1-((T+28894.14)/(508929.2*(T+6812.963)))*(T/100-3.9863)^2)
+   fe.density = lut_density(temp);                   // 1:1
+
+// II. Strouhal number
+   //St = 2684-10356/Re^0.5
+   fe.St = lut_strouhal(fe.Re);                      // (x10,000)
+   if(fe_St_avg == 0) fe_St_avg = fe.St << 16;
+   else fe_St_avg += (int32_t)((fe.St << 16) - fe_St_avg) >> fe_par.st_shift;
+   fe.St_const = (fe_St_avg + 0x8000) >> 16;
+
+// III. Velocity, Reynolds number and flow
+   //velocity = 10000*frequency*d_width/St_const; // (x100)
+   //freq*FE_VEL_K fits 32 bits up to 8.5 kHz, above the Nyquist rate
+   fe.velocity = (freq*fe_vel_k + (fe.St_const >> 1))/fe.St_const;
+
+   //Re = 1000000*(rho_density*(velocity/3937)*PIDm)/viscosity
+   //rho*velocity < 1000*2e6 at the Nyquist rate, the split constant
+   //keeps q*K below 32 bits for q < 3.7e7
+   q = (fe.density*fe.velocity + (fe.viscosity >> 1))/fe.viscosity;
+   fe.Re = q*fe_re_k_int + fe_mul_frac(q, fe_re_k_frac, 8);
+
+   //Flow = 2.45*PID*PID*velocity/12
+   fe.Flow = fe.velocity*fe_flow_k_int + fe_mul_frac(fe.velocity, fe_flow_k_frac, 12);
+
+   fe.cycles_last = cycles_since(start);
+   if(fe.cycles_last > fe.cycles_max) fe.cycles_max = fe.cycles_last;
+   return fe.Flow;
+}
+
+/*****************************************************************************/
+/// \fn const struct flow_vars *flow_engine_vars(void)
+/// @return the intermediate results and cycle counts of the last update
+/*****************************************************************************/
+const struct flow_vars *flow_engine_vars(void)
+{
+   return &fe;
+}
@@ -0,0 +1,105 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file flow_lut.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      flow_lut.cpp                                         --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Table lookups that replace the powf() fluid property models in
+   calculate_flow().  The tables in flow_tables.h are generated on the host
+   by tools/gen_flow_tables.cpp from the same float formulas, and
+   tools/check_flow_tables.cpp checks these lookups against them.
+   Every lookup is one table index computed with shifts and one linear
+   interpolation, no divides and no floating point.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+#include "flow_tables.h"
+
+/*****************************************************************************/
+/// \fn static uint32_t lut_temp(const uint16_t *tab, uint32_t temp)
+/// @brief interpolates a temperature keyed table
+/// @param temp temperature in Celsius (x100), clamped to the table range
+/// @return table value, Q4
+/*****************************************************************************/
+static uint32_t lut_temp(const uint16_t *tab, uint32_t temp)
+{
+   uint32_t idx = temp >> FT_TEMP_SHIFT;
+   int32_t frac = temp & ((1 << FT_TEMP_SHIFT) - 1);
+
+   if((int32_t)temp < 0) return tab[0];      // wrapped below 0 C
+   if(idx >= FT_TEMP_COUNT - 1) return tab[FT_TEMP_COUNT - 1];
+   return tab[idx] +
+          ((((int32_t)tab[idx+1] - (int32_t)tab[idx])*frac) >> FT_TEMP_SHIFT);
+}
+
+/*****************************************************************************/
+/// \fn uint32_t lut_viscosity(uint32_t temp)
+/// @return viscosity (x1,000,000) at temperature temp (Celsius x100)
+/*****************************************************************************/
+uint32_t lut_viscosity(uint32_t temp)
+{
+   return (lut_temp(visc_tab, temp) + (1 << (FT_Q-1))) >> FT_Q;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t lut_density(uint32_t temp)
+/// @return density (kg/m^3) at temperature temp (Celsius x100)
+/*****************************************************************************/
+uint32_t lut_density(uint32_t temp)
+{
+   return (lut_temp(rho_tab, temp) + (1 << (FT_Q-1))) >> FT_Q;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t lut_strouhal(uint32_t Re)
+/// @brief the table has 2^FT_RE_SUB linear segments per octave of Re, so the
+/// octave is found with a short shift search (the M0+ has no CLZ)
+/// @return Strouhal number (x10,000) at Reynolds number Re
+/*****************************************************************************/
+uint32_t lut_strouhal(uint32_t Re)
+{
+   uint32_t x = Re;
+   uint8_t oct = 0;              // floor(log2(Re))
+   uint32_t idx;
+   int32_t frac;
+   uint8_t sh;
+
+   if(Re < (1UL << FT_RE_OCT_MIN)) return (st_tab[0] + (1 << (FT_Q-1))) >> FT_Q;
+   if(Re >= (1UL << FT_RE_OCT_MAX))
+      return (st_tab[FT_RE_COUNT-1] + (1 << (FT_Q-1))) >> FT_Q;
+
+   if(x >= 1UL << 16) { x >>= 16; oct += 16; }
+   if(x >= 1UL << 8)  { x >>= 8;  oct += 8; }
+   if(x >= 1UL << 4)  { x >>= 4;  oct += 4; }
+   if(x >= 1UL << 2)  { x >>= 2;  oct += 2; }
+   if(x >= 1UL << 1)  { oct += 1; }
+
+   sh = oct - FT_RE_SUB;         // bits below the segment index
+   idx = ((uint32_t)(oct - FT_RE_OCT_MIN) << FT_RE_SUB) +
+         ((Re >> sh) & ((1 << FT_RE_SUB) - 1));
+   frac = (Re & ((1UL << sh) - 1)) >> (sh - 8);   // 8 bit weight
+   return ((uint32_t)(st_tab[idx] +
+          ((((int32_t)st_tab[idx+1] - (int32_t)st_tab[idx])*frac) >> 8)) +
+          (1 << (FT_Q-1))) >> FT_Q;
+}
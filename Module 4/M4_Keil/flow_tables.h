@@ -0,0 +1,66 @@
+/**----------------------------------------------------------------------------
+             \file flow_tables.h
+
+   Generated by tools/gen_flow_tables.cpp, do not edit.
+
+   Fluid property tables for flow_lut.cpp, all entries Q4.
+*/
+#ifndef FLOW_TABLES_H
+#define FLOW_TABLES_H
+
+#define FT_Q             4
+#define FT_TEMP_SHIFT    7
+#define FT_TEMP_COUNT    80
+#define FT_RE_OCT_MIN    13
+#define FT_RE_OCT_MAX    24
+#define FT_RE_SUB        3
+#define FT_RE_COUNT      89
+
+/* viscosity (x1,000,000) vs temperature (C x100) */
+const uint16_t visc_tab[80] =
+{
+   27886, 26771, 25721, 24730, 23795, 22911, 22075, 21284,
+   20535, 19824, 19150, 18510, 17902, 17324, 16774, 16250,
+   15751, 15275, 14820, 14387, 13973, 13577, 13198, 12835,
+   12488, 12156, 11837, 11531, 11238, 10956, 10686, 10426,
+   10176,  9935,  9704,  9481,  9266,  9060,  8860,  8668,
+    8482,  8303,  8130,  7963,  7802,  7646,  7495,  7349,
+    7207,  7071,  6938,  6810,  6685,  6565,  6448,  6335,
+    6225,  6118,  6014,  5914,  5816,  5721,  5629,  5539,
+    5451,  5367,  5284,  5204,  5125,  5049,  4975,  4903,
+    4832,  4764,  4697,  4631,  4568,  4506,  4445,  4386
+};
+
+/* density (kg/m^3) vs temperature (C x100) */
+const uint16_t rho_tab[80] =
+{
+   15998, 15999, 16000, 16000, 16000, 15999, 15998, 15997,
+   15995, 15993, 15991, 15988, 15985, 15982, 15978, 15974,
+   15970, 15966, 15961, 15956, 15951, 15945, 15939, 15934,
+   15927, 15921, 15914, 15907, 15900, 15893, 15886, 15878,
+   15870, 15862, 15854, 15845, 15837, 15828, 15819, 15810,
+   15800, 15791, 15781, 15771, 15761, 15751, 15741, 15730,
+   15719, 15709, 15698, 15686, 15675, 15664, 15652, 15640,
+   15628, 15616, 15604, 15592, 15579, 15567, 15554, 15541,
+   15528, 15515, 15502, 15488, 15475, 15461, 15447, 15433,
+   15419, 15405, 15390, 15376, 15361, 15346, 15331, 15316
+};
+
+/* Strouhal number (x10,000) vs Reynolds number */
+const uint16_t st_tab[89] =
+{
+   41113, 41218, 41307, 41383, 41449, 41508, 41560, 41607,
+   41650, 41724, 41786, 41840, 41887, 41929, 41965, 41999,
+   42029, 42081, 42125, 42163, 42197, 42226, 42252, 42276,
+   42297, 42334, 42365, 42392, 42416, 42436, 42455, 42471,
+   42486, 42513, 42535, 42554, 42570, 42585, 42598, 42610,
+   42620, 42639, 42655, 42668, 42680, 42690, 42699, 42708,
+   42715, 42728, 42739, 42749, 42757, 42764, 42771, 42777,
+   42782, 42791, 42799, 42806, 42812, 42817, 42822, 42826,
+   42830, 42836, 42842, 42846, 42851, 42854, 42858, 42860,
+   42863, 42868, 42872, 42875, 42878, 42881, 42883, 42885,
+   42887, 42890, 42893, 42895, 42897, 42899, 42901, 42902,
+   42904
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file fmt.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      fmt.cpp                                              --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Decimal text for the UART reports and the LCD, without a divide.
+
+   The M0+ has no divide instruction, every / or % is a library call of
+   some 50 to 100 cycles.  fmt_divu10() divides by 10 with shifts and adds
+   instead: n*0.8 is summed from shifted copies of n (0.8 = 0.110011001100..
+   in binary), divided by 8 for n/10 rounded down by at most 1, and the
+   remainder n - 10q corrects that.  About 20 instructions.
+
+   fmt_dec() writes a scaled integer, Flow x100 say, with the decimal point
+   in place: one fmt_divu10() per digit, no more than the value has.
+
+   The older path, hex2hexInt() into UART_hex_int_put(), takes 16 library
+   divisions per value whatever its size.  The B monitor command times
+   both on the live values.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+/*****************************************************************************/
+/// \fn uint32_t fmt_divu10(uint32_t n, UCHAR *rem)
+/// @brief n/10 by shifts and adds
+/// @param rem receives n%10
+/// @return n/10
+/*****************************************************************************/
+uint32_t fmt_divu10(uint32_t n, UCHAR *rem)
+{
+   uint32_t q, r;
+
+   q = (n >> 1) + (n >> 2);    // n*0.11b
+   q += q >> 4;                // n*0.110011b
+   q += q >> 8;
+   q += q >> 16;               // n*0.8, a little under
+   q >>= 3;                    // n/10, or one less
+   r = n - ((q << 3) + (q << 1));
+   if(r > 9)
+   {
+      q++;
+      r -= 10;
+   }
+   *rem = r;
+   return q;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR fmt_dec(char *dst, uint32_t x, UCHAR deci, UCHAR width)
+/// @brief writes x/10^deci in decimal with deci decimals, "1283.76" for
+/// 128376 with 2, and at least one digit before the point.  No terminator.
+/// @param width 0 for as many characters as it takes, at most FMT_DEC_MAX,
+/// else exactly width, right aligned after spaces.  A value too long for
+/// width is shown as width '*'s, and one with more than FMT_DECI_MAX
+/// decimals as '*'s too, one for width 0.
+/// @return characters written
+/*****************************************************************************/
+UCHAR fmt_dec(char *dst, uint32_t x, UCHAR deci, UCHAR width)
+{
+   char tmp[FMT_DEC_MAX];      // the text backwards, units first
+   UCHAR n = 0, least, i, d;
+
+   if(deci > FMT_DECI_MAX)
+   {
+      if(width == 0) width = 1;
+      for(i=0;i<width;i++) dst[i] = '*';
+      return width;
+   }
+   least = deci ? deci + 2 : 1;  // "0.00" for deci 2
+   do
+   {
+      x = fmt_divu10(x, &d);
+      tmp[n++] = '0' + d;
+      if(n == deci) tmp[n++] = '.';
+   } while(x != 0 || n < least);
+
+   if(width == 0) width = n;
+   else if(n > width)
+   {
+      for(i=0;i<width;i++) dst[i] = '*';
+      return width;
+   }
+   for(i=0;i<width-n;i++) dst[i] = ' ';
+   while(n > 0) dst[i++] = tmp[--n];
+   return width;
+}
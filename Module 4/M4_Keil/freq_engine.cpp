@@ -0,0 +1,135 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file freq_engine.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      freq_engine.cpp                                      --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Run time choice of the frequency estimator used by readFREQ().
+
+   Every estimator takes whole ADC blocks through the same three calls,
+   init, block and frequency (struct freq_engine in shared.h), and is
+   listed in freq_engines[].  The monitor 'F' command shows the list and
+   switches engines.  A new engine starts from the last published
+   frequency, so the switch does not upset the flow reading.
+
+   For A/B tests on live data a second engine can be run on the same
+   blocks (freq_engine_compare(), the monitor 'FA' command).  Its result
+   is only shown, the flow is computed from the engine in use.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static const struct freq_engine freq_engines[] =
+   {
+      {"zero cross", &zc_init, &zc_block, &zc_frequency},
+      {"tone track", &tt_init, &tt_block, &tt_frequency},
+      {"fft peak",   &fp_init, &fp_block, &fp_frequency},
+      {"amdf",       &am_init, &am_block, &am_frequency},
+   };
+#define FREQ_ENGINE_COUNT (sizeof(freq_engines)/sizeof(freq_engines[0]))
+
+   static UCHAR freq_engine_sel = 0;     // index into freq_engines[]
+   static UCHAR freq_engine_cmp = FREQ_ENGINE_NONE;  // run beside it
+
+/*****************************************************************************/
+/// \fn UCHAR freq_engine_select(UCHAR i)
+/// @brief starts engine i and hands it the following blocks
+/// @return 1 if selected, 0 if there is no engine i
+/*****************************************************************************/
+UCHAR freq_engine_select(UCHAR i)
+{
+   if(i >= FREQ_ENGINE_COUNT) return 0;
+   freq_engines[i].init();
+   freq_engine_sel = i;
+   if(freq_engine_cmp == i) freq_engine_cmp = FREQ_ENGINE_NONE;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR freq_engine_compare(UCHAR i)
+/// @brief starts engine i beside the one in use, on the same blocks.  An
+/// index past the last engine stops the comparison.
+/// @return 1 if comparing, 0 if stopped or i is the engine in use
+/*****************************************************************************/
+UCHAR freq_engine_compare(UCHAR i)
+{
+   freq_engine_cmp = FREQ_ENGINE_NONE;
+   if(i >= FREQ_ENGINE_COUNT || i == freq_engine_sel) return 0;
+   freq_engines[i].init();
+   freq_engine_cmp = i;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR freq_engine_compared(void)
+/// @return the index of the engine run beside, FREQ_ENGINE_NONE if none
+/*****************************************************************************/
+UCHAR freq_engine_compared(void)
+{
+   return freq_engine_cmp;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR freq_engine_current(void)
+/// @return the index of the engine in use
+/*****************************************************************************/
+UCHAR freq_engine_current(void)
+{
+   return freq_engine_sel;
+}
+
+/*****************************************************************************/
+/// \fn const struct freq_engine *freq_engine_get(UCHAR i)
+/// @return engine i, NULL past the last one
+/*****************************************************************************/
+const struct freq_engine *freq_engine_get(UCHAR i)
+{
+   if(i >= FREQ_ENGINE_COUNT) return NULL;
+   return &freq_engines[i];
+}
+
+/*****************************************************************************/
+/// \fn UCHAR freq_engine_block(const uint16_t *blk, uint16_t n)
+/// @brief hands a block of samples to the engine in use
+/// @return 1 if it published a new frequency, read it with
+/// freq_engine_frequency()
+/*****************************************************************************/
+UCHAR freq_engine_block(const uint16_t *blk, uint16_t n)
+{
+   if(freq_engine_cmp != FREQ_ENGINE_NONE)
+      freq_engines[freq_engine_cmp].block(blk, n);
+   return freq_engines[freq_engine_sel].block(blk, n);
+}
+
+/*****************************************************************************/
+/// \fn uint32_t freq_engine_frequency(void)
+/// @return the latest frequency of the engine in use, Hz (x100)
+/*****************************************************************************/
+uint32_t freq_engine_frequency(void)
+{
+   return freq_engines[freq_engine_sel].frequency();
+}
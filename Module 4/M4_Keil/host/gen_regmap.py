@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+   \file gen_regmap.py
+
+   Host simulator build step: turns the device header MKL25Z4.h into a
+   simulated register map.
+
+   - every peripheral base pointer, e.g. ((ADC_Type *)ADC0_BASE), becomes a
+     host object sim_ADC0 defined in the generated sim_regs.cpp
+   - registers with side effects (data registers, status flags) become
+     SimReg<> objects whose reads and writes call into sim.cpp
+   - DMA address registers are widened to uintptr_t so host pointers fit
+   - the core header is replaced by sim_core.h
+
+   Usage: gen_regmap.py <MKL25Z4.h> <out MKL25Z4.h> <out sim_regs.cpp>
+"""
+import re
+import sys
+
+# (register layout, field) -> hook id in sim_core.h
+HOOKS = {
+    ('ADC_Type', 'SC1'): 'SIM_ADC0_SC1',
+    ('ADC_Type', 'R'): 'SIM_ADC0_R',
+    ('UARTLP_Type', 'C2'): 'SIM_UART0_C2',
+    ('UARTLP_Type', 'S1'): 'SIM_UART0_S1',
+    ('UARTLP_Type', 'D'): 'SIM_UART0_D',
+    ('SPI_Type', 'S'): 'SIM_SPI_S',
+    ('SPI_Type', 'D'): 'SIM_SPI_D',
+    ('DMA_Type', 'DSR_BCR'): 'SIM_DMA_DSR_BCR',
+    ('PIT_Type', 'CVAL'): 'SIM_PIT_CVAL',
+    ('PIT_Type', 'TCTRL'): 'SIM_PIT_TCTRL',
+    ('PIT_Type', 'TFLG'): 'SIM_PIT_TFLG',
+    ('FTFA_Type', 'FSTAT'): 'SIM_FTFA_FSTAT',
+    ('FTFA_Type', 'FCNFG'): 'SIM_FTFA_FCNFG',
+    ('TPM_Type', 'SC'): 'SIM_TPM_SC',
+    ('TPM_Type', 'CNT'): 'SIM_TPM_CNT',
+    ('TPM_Type', 'MOD'): 'SIM_TPM_MOD',
+}
+
+# (register layout, field) -> replacement type
+WIDEN = {
+    ('DMA_Type', 'SAR'): 'uintptr_t',
+    ('DMA_Type', 'DAR'): 'uintptr_t',
+}
+
+FIELD = re.compile(r'^(\s*)(__IO|__I|__O)\s+(uint(?:8|16|32)_t)\s+(\w+)(\[\w+\])?;')
+BASE = re.compile(r'^#define\s+(\w+)\s+\(\((\w+_Type) \*\)\w+\)')
+
+
+def main():
+    src, out_h, out_c = sys.argv[1:4]
+    lines = open(src).read().split('\n')
+
+    # find the extent of every typedef struct ... } NAME_Type;
+    out = list(lines)
+    start = None
+    depth = 0
+    for i, line in enumerate(lines):
+        if start is None:
+            if line.startswith('typedef struct {'):
+                start, depth = i, 0
+            else:
+                continue
+        depth += line.count('{') - line.count('}')
+        if depth == 0:
+            m = re.match(r'^\}\s*(\w+_Type);', line)
+            name = m.group(1) if m else None
+            for j in range(start, i):
+                f = FIELD.match(out[j])
+                if not f or not name:
+                    continue
+                key = (name, f.group(4))
+                rest = out[j][f.end():]
+                arr = f.group(5) or ''
+                if key in HOOKS:
+                    out[j] = '%sSimReg<%s, %s> %s%s;%s' % (
+                        f.group(1), f.group(3), HOOKS[key], f.group(4), arr, rest)
+                elif key in WIDEN:
+                    out[j] = '%s%s %s %s%s;%s' % (
+                        f.group(1), f.group(2), WIDEN[key], f.group(4), arr, rest)
+            start = None
+
+    instances = []
+    for i, line in enumerate(out):
+        if line.startswith('#include "core_cm0plus.h"'):
+            out[i] = '#include "sim_core.h"                  /* simulated core */'
+        elif line.startswith('#include "system_MKL25Z4.h"'):
+            out[i] = ''
+        else:
+            m = BASE.match(line)
+            if m:
+                instances.append((m.group(1), m.group(2)))
+                out[i] = 'extern %s sim_%s;\n#define %s (&sim_%s)' % (
+                    m.group(2), m.group(1), m.group(1), m.group(1))
+
+    with open(out_h, 'w') as f:
+        f.write('/* Generated by host/gen_regmap.py from %s, do not edit. */\n'
+                % src.split('/')[-1])
+        f.write('\n'.join(out))
+    with open(out_c, 'w') as f:
+        f.write('/* Generated by host/gen_regmap.py, do not edit. */\n')
+        f.write('#include "MKL25Z4.h"\n\n')
+        for name, typ in instances:
+            f.write('%s sim_%s;\n' % (typ, name))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,125 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file mbed.h
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Simulator                                             --
+--                      mbed.h                                               --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target:  Linux host, g++
+--
+--
+   Functional Description:
+   The parts of the mbed SDK the firmware uses, for the host build.
+   Ticker callbacks run from the simulated timer interrupt in sim.cpp and
+   DigitalOut pins are reported to the simulator so LED activity can be
+   counted.  MbedCRC computes bit by bit, without the reflected forms.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#ifndef MBED_H
+#define MBED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "MKL25Z4.h"
+
+typedef enum
+{
+   PTB0, PTB1, PTB2, PTB9,
+   LED_RED, LED_GREEN, LED_BLUE,
+   SIM_PIN_COUNT,
+   NC = -1
+} PinName;
+
+extern "C" void sim_ticker_attach(void *owner, void (*fn)(void), uint32_t period_us);
+extern "C" void sim_ticker_detach(void *owner);
+extern "C" void sim_pin_write(PinName pin, int value);
+
+/*****************************************************************************/
+/// \class Ticker
+/// @brief periodic callback from the simulated timer interrupt
+/*****************************************************************************/
+class Ticker
+{
+public:
+   ~Ticker() { detach(); }
+   void attach(void (*fn)(void), float t) { attach_us(fn, (uint32_t)(t*1000000.0f + 0.5f)); }
+   void attach_us(void (*fn)(void), uint32_t t) { sim_ticker_attach(this, fn, t); }
+   void detach(void) { sim_ticker_detach(this); }
+};
+
+/*****************************************************************************/
+/// \class DigitalOut
+/// @brief output pin, writes are reported to the simulator
+/*****************************************************************************/
+class DigitalOut
+{
+public:
+   DigitalOut(PinName pin, int value = 0) : _pin(pin), _value(value) { }
+   void write(int value) { _value = value; sim_pin_write(_pin, value); }
+   int read(void) { return _value; }
+   DigitalOut &operator=(int value) { write(value); return *this; }
+   operator int() { return read(); }
+
+private:
+   PinName _pin;
+   int _value;
+};
+
+/*****************************************************************************/
+/// \class MbedCRC
+/// @brief CRC of up to 32 bits, most significant bit first
+/*****************************************************************************/
+enum { POLY_16BIT_CCITT = 0x1021 };
+
+template <uint32_t polynomial, uint8_t width>
+class MbedCRC
+{
+public:
+   MbedCRC(uint32_t initial_xor, uint32_t final_xor, bool reflect_data, bool reflect_remainder)
+      : _initial(initial_xor), _final(final_xor) { }
+   int32_t compute(void *buffer, uint64_t size, uint32_t *crc)
+   {
+      compute_partial_start(crc);
+      compute_partial(buffer, size, crc);
+      return compute_partial_stop(crc);
+   }
+   int32_t compute_partial_start(uint32_t *crc) { *crc = _initial; return 0; }
+   int32_t compute_partial(void *buffer, uint64_t size, uint32_t *crc)
+   {
+      const uint8_t *p = (const uint8_t *)buffer;
+      const uint32_t top = 1UL << (width - 1);
+      while(size-- != 0)
+      {
+         *crc ^= (uint32_t)*p++ << (width - 8);
+         for(int b = 0; b < 8; b++)
+            *crc = (*crc & top) ? (*crc << 1) ^ polynomial : *crc << 1;
+      }
+      return 0;
+   }
+   int32_t compute_partial_stop(uint32_t *crc)
+   {
+      *crc = (*crc ^ _final) & (uint32_t)((1ULL << width) - 1);
+      return 0;
+   }
+
+private:
+   uint32_t _initial, _final;
+};
+
+#endif
@@ -0,0 +1,1496 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file sim.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Simulator                                             --
+--                      sim.cpp                                              --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target:  Linux host, g++
+--
+--
+   Functional Description:
+   Runs the Module 4 firmware on a Linux host against a simulated KL25Z.
+
+   I.   Time and interrupts
+        Virtual time follows the host monotonic clock (optionally scaled).
+        SIGALRM plays the part of the hardware: every virtual tick the
+        handler runs the PIT, the mbed Tickers, the TPM1 triggered ADC, the
+        UART receiver, and then every pending interrupt handler of the firmware,
+        so firmware ISRs run asynchronously to the super loop just like on
+        the board.  __disable_irq() blocks the signal.
+   II.  Peripherals
+        ADC0     flow channel fed from a waveform file or a synthesized
+                 vortex signal, housekeeping channels return fixed values
+        DMA      request driven transfers, DONE interrupt
+        UART0    9600 baud timing, TX to stdout, a file or a pty, RX from
+                 stdin or the pty, overrun when the firmware reads too late
+        SPI0     byte timing from the baud rate registers, transmit DMA
+                 request, bytes logged
+        PIT      both channels, bus clock reload from LDVAL, CVAL counts
+                 down, TIF interrupt.  An expiry is serviced at the next
+                 virtual tick, so a latency the firmware measures from
+                 CVAL includes up to SIM_TICK_NS of simulator delay.  An
+                 expiry also triggers the DMA channel of the same number
+                 if its DMAMUX TRIG bit is set (periodic trigger)
+        TPM0     counts at the TPM clock and prescale, MOD buffered to the
+                 overflow while counting, TOF, CMOD stop holds the count;
+                 every overflow is a pulse of the pulse output, counted
+                 against the Flow * K the simulator integrates itself
+        DAC0     DAT0 is the output once DACEN is set; each change can be
+                 logged with its time, and the current into the 4-20 mA
+                 stage is in the summary
+        FTFA     program longword and erase sector on a 128 KB flash
+                 image, with their typical times, CCIF, errors, and erase
+                 suspend and resume.  The image can be kept in a file
+                 from run to run, a power cycle for the flash log
+   III. Metrics
+        The firmware is linked with --wrap so the simulator sees every pass
+        of the super loop and every ADC block hand-off.  A key=value
+        summary, including the scheduler task table, goes to stderr when
+        the run ends (-d or ^C).
+
+   Run m4sim -h for the options.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/time.h>
+#include <vector>
+#include "mbed.h"
+#include "shared.h"
+#include <termios.h>                     // after MKL25Z4.h, CR0 and CR1 clash
+
+#define SIM_TICK_NS          100000ULL   /* virtual 100 usec. tick */
+#define SIM_CORE_HZ          48000000UL
+#define SIM_BUS_HZ           24000000UL
+#define SIM_TPM_HZ           48000000UL  /* MCGPLLCLK/2 */
+#define SIM_MAX_TICKERS      4
+#define SIM_MAX_CATCHUP      1000        /* events per signal before resync */
+#define SIM_DMAMUX_ADC0      40
+#define SIM_DMAMUX_SPI0_TX   17
+#define SIM_ADC_TRGSEL_TPM1  9
+#define SIM_ADC_TEMP25       14219       /* 716 mV at 3.3 V, 16 bit */
+#define SIM_ADC_BANDGAP      19859       /* 1.0 V */
+#define SIM_FLASH_SIZE       0x20000
+#define SIM_FLASH_SECTOR     1024
+#define SIM_FLASH_PGM_NS     65000ULL    /* program longword, typical */
+#define SIM_FLASH_ERS_NS     14000000ULL /* erase sector, typical */
+#define SIM_FLASH_SUSP_NS    5000ULL     /* ERSSUSP to CCIF */
+
+int fw_main(void);                       // main.cpp built with -Dmain=fw_main
+
+/*******************/
+/*  Configurations */
+/*******************/
+static struct
+{
+   double scale;             // virtual seconds per host second
+   double duration;          // seconds of virtual time, 0 runs until ^C
+   uint32_t baud;
+   const char *wave_file;    // one ADC sample per line
+   double freq;              // synthesized vortex frequency, Hz
+   double step_freq;         // frequency after the step, 0 for no step
+   double step_at;           // time of the step, s
+   double amplitude;         // ADC counts
+   double noise;             // ADC counts, uniform
+   bool pty;
+   const char *uart_out;
+   const char *spi_log;
+   const char *flash_file;   // flash image, loaded and saved
+   const char *dac_log;
+} cfg = { 1.0, 0.0, 9600, NULL, 400.0, 0.0, 0.0, 16000.0, 0.0,
+          false, NULL, NULL, NULL, NULL };
+
+/**********************/
+/*   Definitions     */
+/**********************/
+extern "C" {
+   uint32_t SystemCoreClock = SIM_CORE_HZ;
+   uint8_t sim_flash[SIM_FLASH_SIZE];
+   SysTick_Type sim_SysTick;
+   SCB_Type sim_SCB;
+
+   // firmware interrupt handlers, unused ones stay NULL
+   void DMA0_IRQHandler(void) __attribute__((weak));
+   void DMA1_IRQHandler(void) __attribute__((weak));
+   void DMA2_IRQHandler(void) __attribute__((weak));
+   void DMA3_IRQHandler(void) __attribute__((weak));
+   void SPI0_IRQHandler(void) __attribute__((weak));
+   void UART0_IRQHandler(void) __attribute__((weak));
+   void ADC0_IRQHandler(void) __attribute__((weak));
+   void TPM0_IRQHandler(void) __attribute__((weak));
+   void TPM1_IRQHandler(void) __attribute__((weak));
+   void TPM2_IRQHandler(void) __attribute__((weak));
+   void PIT_IRQHandler(void) __attribute__((weak));
+   void DAC0_IRQHandler(void) __attribute__((weak));
+}
+
+static void (*sim_vector[32])(void);
+
+static uint64_t sim_t0_ns;                 // host clock at start
+static volatile sig_atomic_t sim_depth;    // register hooks in progress
+static volatile sig_atomic_t sim_ctx;      // interrupt context nesting
+static volatile sig_atomic_t sim_primask;  // __disable_irq() in effect
+static volatile uint32_t sim_ipsr = 0;     // exception number of the handler
+static volatile sig_atomic_t sim_deferred; // tick arrived while busy
+static uint32_t sim_nvic_enabled;
+static uint32_t sim_nvic_pending;
+static sigset_t sim_alarm_set;
+
+static struct
+{
+   void *owner;
+   void (*fn)(void);
+   uint64_t period_ns;
+   uint64_t next_ns;
+} sim_ticker[SIM_MAX_TICKERS];
+
+static uint64_t adc_next_ns;               // next TPM1 overflow
+static std::vector<uint16_t> adc_wave;
+static size_t adc_wave_idx;
+static double adc_phase;
+
+static int uart_in_fd = -1;
+static int uart_out_fd = 1;
+static uint64_t uart_tx_done_ns;           // shift register empty
+static uint64_t uart_rx_next_ns;
+static uint8_t uart_rx_data;
+static bool uart_rdrf, uart_or;
+static bool uart_tty_raw;
+static struct termios uart_tty_saved;
+
+static uint64_t pit_next_ns[2];            // next PIT expiry, 0 when stopped
+
+static struct
+{
+   bool busy;                              // CCIF clear
+   bool suspending, suspended;             // an erase, ERSSUSP
+   uint8_t cmd;
+   uint32_t addr;
+   uint8_t data[4];
+   uint64_t done_ns;
+   uint64_t left_ns;                       // of a suspended erase
+} ftfa;
+
+static uint64_t spi_done_ns;               // last byte shifted out
+static bool spi_rx_pending;
+static FILE *spi_log;
+
+static struct
+{
+   bool run;                               // CMOD not 0
+   uint64_t base_clk;                      // TPM clocks counted up to
+   uint32_t cnt;                           //   which CNT was this
+   uint32_t mod_next;                      // MOD written while counting
+   bool pending;
+} tpm0;
+
+static uint16_t dac_code;                  // on the output
+static FILE *dac_log;
+
+static struct
+{
+   uint64_t ticks, ticks_late;
+   uint64_t loops;
+   uint64_t adc_samples, adc_trig_lost;
+   uint64_t blocks_done, blocks_used;
+   uint64_t lat_min_ns, lat_max_ns, lat_sum_ns;
+   uint64_t uart_tx, uart_rx, uart_rx_lost, uart_tx_overwrite;
+   uint64_t spi_tx, spi_lost;
+   uint64_t led_toggles[SIM_PIN_COUNT];
+   uint64_t step_latency_ns;
+   bool step_seen;
+   uint64_t sleep_ns;
+   uint64_t flash_programs, flash_erases, flash_suspends, flash_errors;
+   uint64_t dac_changes;
+   uint16_t dac_step_max;
+   uint64_t pulses;
+   double pulses_due;                      // Flow * K, integrated
+   uint64_t pulses_due_ns;
+} sim_stat;
+
+static struct { uintptr_t end; uint64_t t; } dma_done_log[4];
+static uint64_t dma_bcr_ns[4];             // when BCR was last written
+static const uint16_t *held_block;
+static uint64_t held_done_ns;
+static int pin_state[SIM_PIN_COUNT];
+
+static uint64_t sim_host_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+/*****************************************************************************/
+/// \fn static uint64_t sim_now_ns(void)
+/// @return virtual time since start, ns
+/*****************************************************************************/
+static uint64_t sim_now_ns(void)
+{
+   return (uint64_t)((double)(sim_host_ns() - sim_t0_ns)*cfg.scale);
+}
+
+static void sim_run(void);
+static void save_flash(void);
+
+/*****************************************************************************/
+/// \fn static void sim_run_main(void)
+/// @brief services due events and interrupts from the main context, as the
+/// NVIC would as soon as the firmware unmasks or raises an interrupt
+/*****************************************************************************/
+static void sim_run_main(void)
+{
+   sigset_t old;
+   sigprocmask(SIG_BLOCK, &sim_alarm_set, &old);
+   sim_ctx++;
+   sim_run();
+   sim_ctx--;
+   sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
+/************************************************************************/
+/*             UART0                                                    */
+/************************************************************************/
+static uint64_t uart_byte_ns(void)
+{
+   return 10ULL*1000000000ULL/cfg.baud;    // start, 8 data, stop
+}
+
+static uint8_t uart_s1(uint64_t now)
+{
+   uint8_t s1 = 0;
+   if(now + uart_byte_ns() >= uart_tx_done_ns) s1 |= UARTLP_S1_TDRE_MASK;
+   if(now >= uart_tx_done_ns) s1 |= UARTLP_S1_TC_MASK;
+   if(uart_rdrf) s1 |= UARTLP_S1_RDRF_MASK;
+   if(uart_or) s1 |= UARTLP_S1_OR_MASK;
+   return s1;
+}
+
+static void uart_tx(uint8_t c, uint64_t now)
+{
+   if(!(uart_s1(now) & UARTLP_S1_TDRE_MASK)) sim_stat.uart_tx_overwrite++;
+   uart_tx_done_ns = ((now > uart_tx_done_ns) ? now : uart_tx_done_ns) +
+                     uart_byte_ns();
+   sim_stat.uart_tx++;
+   if(uart_out_fd >= 0 && write(uart_out_fd, &c, 1) < 0) { }
+}
+
+/*****************************************************************************/
+/// \fn static void uart_rx_poll(uint64_t now)
+/// @brief receives at most one byte per character time, a byte arriving
+/// while RDRF is still set is lost and sets OR, like the hardware
+/*****************************************************************************/
+static void uart_rx_poll(uint64_t now)
+{
+   uint8_t c;
+   uart_rx_next_ns = now + uart_byte_ns();
+   if(uart_in_fd < 0 || read(uart_in_fd, &c, 1) != 1) return;
+   if(c == '\n' && !cfg.pty) c = '\r';     // terminals send CR
+   sim_stat.uart_rx++;
+   if(uart_rdrf)
+   {
+      uart_or = true;
+      sim_stat.uart_rx_lost++;
+      return;
+   }
+   uart_rx_data = c;
+   uart_rdrf = true;
+}
+
+/************************************************************************/
+/*             SPI0                                                     */
+/************************************************************************/
+static uint64_t spi_byte_ns(void)
+{
+   uint32_t sppr = ((SPI0->BR & SPI_BR_SPPR_MASK) >> SPI_BR_SPPR_SHIFT) + 1;
+   uint32_t spr = 2U << (SPI0->BR & SPI_BR_SPR_MASK);
+   return 8ULL*1000000000ULL*sppr*spr/SIM_BUS_HZ;
+}
+
+static uint8_t spi_s(uint64_t now)
+{
+   uint8_t s = 0;
+   if(now + spi_byte_ns() >= spi_done_ns) s |= SPI_S_SPTEF_MASK;
+   if(spi_rx_pending && now >= spi_done_ns) s |= SPI_S_SPRF_MASK;
+   return s;
+}
+
+static void spi_tx(uint8_t c, uint64_t now)
+{
+   if(!(spi_s(now) & SPI_S_SPTEF_MASK))
+   {                           // the hardware ignores writes while full
+      sim_stat.spi_lost++;
+      return;
+   }
+   spi_done_ns = ((now > spi_done_ns) ? now : spi_done_ns) + spi_byte_ns();
+   spi_rx_pending = true;
+   sim_stat.spi_tx++;
+   if(spi_log) fprintf(spi_log, "%.6f %02X\n", now*1e-9, c);
+}
+
+/************************************************************************/
+/*             PIT                                                      */
+/************************************************************************/
+static uint64_t pit_period_ns(int ch)
+{
+   return (uint64_t)(PIT->CHANNEL[ch].LDVAL + 1)*1000000000ULL/SIM_BUS_HZ;
+}
+
+static bool pit_running(int ch)
+{
+   return !(PIT->MCR & PIT_MCR_MDIS_MASK) &&
+          (PIT->CHANNEL[ch].TCTRL.raw & PIT_TCTRL_TEN_MASK) && pit_next_ns[ch];
+}
+
+/*****************************************************************************/
+/// \fn static uint32_t pit_cval(int ch, uint64_t now)
+/// @return the count down to the next expiry, in bus clocks
+/*****************************************************************************/
+static uint32_t pit_cval(int ch, uint64_t now)
+{
+   uint64_t per = pit_period_ns(ch), left;
+   if(!pit_running(ch)) return 0;
+   if(now < pit_next_ns[ch]) left = pit_next_ns[ch] - now;
+   else left = per - (now - pit_next_ns[ch]) % per;  // not serviced yet
+   left = left*SIM_BUS_HZ/1000000000ULL;
+   return left > PIT->CHANNEL[ch].LDVAL ? PIT->CHANNEL[ch].LDVAL : (uint32_t)left;
+}
+
+static void dma_transfer(uint8_t ch, uint64_t now);
+
+/*****************************************************************************/
+/// \fn static void pit_expire(int ch, uint64_t t)
+/// @brief the channel counted down to 0 at t: sets TIF and reloads
+/*****************************************************************************/
+static void pit_expire(int ch, uint64_t t)
+{
+   PIT->CHANNEL[ch].TFLG.raw |= PIT_TFLG_TIF_MASK;
+   pit_next_ns[ch] = t + pit_period_ns(ch);
+   if(PIT->CHANNEL[ch].TCTRL.raw & PIT_TCTRL_TIE_MASK) sim_stat.ticks++;
+   if((DMAMUX0->CHCFG[ch] & (DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_TRIG_MASK)) ==
+      (DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_TRIG_MASK))
+      dma_transfer(ch, t);
+}
+
+/************************************************************************/
+/*             FTFA                                                     */
+/************************************************************************/
+/*****************************************************************************/
+/// \fn static void ftfa_poll(uint64_t now)
+/// @brief finishes the command under way if its time is up: the flash
+/// changes, or the erase stops suspended
+/*****************************************************************************/
+static void ftfa_poll(uint64_t now)
+{
+   int i;
+   if(!ftfa.busy || now < ftfa.done_ns) return;
+   ftfa.busy = false;
+   FTFA->FSTAT.raw |= FTFA_FSTAT_CCIF_MASK;
+   if(ftfa.suspending)
+   {
+      ftfa.suspending = false;
+      ftfa.suspended = true;
+      sim_stat.flash_suspends++;
+      return;
+   }
+   FTFA->FCNFG.raw &= ~FTFA_FCNFG_ERSSUSP_MASK;
+   if(ftfa.cmd == 0x06)
+   {                            // programming only clears bits
+      for(i=0;i<4;i++) sim_flash[ftfa.addr + i] &= ftfa.data[i];
+      sim_stat.flash_programs++;
+   }
+   else
+   {
+      memset(&sim_flash[ftfa.addr], 0xFF, SIM_FLASH_SECTOR);
+      sim_stat.flash_erases++;
+   }
+}
+
+/*****************************************************************************/
+/// \fn static void ftfa_launch(uint64_t now)
+/// @brief CCIF written with 1: starts the command in FCCOB, or resumes the
+/// suspended erase of the same sector.  Anything else ends a suspended
+/// erase, the sector is left as it was.
+/*****************************************************************************/
+static void ftfa_launch(uint64_t now)
+{
+   uint8_t cmd = FTFA->FCCOB0;
+   uint32_t addr = (FTFA->FCCOB1 << 16) | (FTFA->FCCOB2 << 8) | FTFA->FCCOB3;
+   bool resume = ftfa.suspended && cmd == 0x09 && addr == ftfa.addr;
+
+   ftfa.suspended = false;
+   if((cmd == 0x06 && (addr & 3) == 0 && addr < SIM_FLASH_SIZE) ||
+      (cmd == 0x09 && (addr % SIM_FLASH_SECTOR) == 0 && addr < SIM_FLASH_SIZE))
+   {
+      ftfa.cmd = cmd;
+      ftfa.addr = addr;
+      ftfa.data[0] = FTFA->FCCOB7;  // byte 0, the lowest address
+      ftfa.data[1] = FTFA->FCCOB6;
+      ftfa.data[2] = FTFA->FCCOB5;
+      ftfa.data[3] = FTFA->FCCOB4;
+      ftfa.busy = true;
+      ftfa.done_ns = now + (resume ? ftfa.left_ns :
+                            cmd == 0x06 ? SIM_FLASH_PGM_NS : SIM_FLASH_ERS_NS);
+      FTFA->FSTAT.raw &= ~FTFA_FSTAT_CCIF_MASK;
+   }
+   else
+   {
+      FTFA->FSTAT.raw |= FTFA_FSTAT_ACCERR_MASK;
+      sim_stat.flash_errors++;
+   }
+}
+
+/************************************************************************/
+/*             ADC0 and DMA                                             */
+/************************************************************************/
+static uint16_t adc_wave_next(uint64_t now)
+{
+   double v, f, fs;
+   if(!adc_wave.empty())
+   {
+      v = adc_wave[adc_wave_idx++];
+      if(adc_wave_idx >= adc_wave.size()) adc_wave_idx = 0;
+      return (uint16_t)v;
+   }
+   f = (cfg.step_freq > 0.0 && now >= cfg.step_at*1e9) ? cfg.step_freq : cfg.freq;
+   fs = (double)SIM_TPM_HZ/((TPM1->MOD + 1)*(1U << (TPM1->SC & TPM_SC_PS_MASK)));
+   adc_phase += 2.0*M_PI*f/fs;
+   if(adc_phase > 2.0*M_PI) adc_phase -= 2.0*M_PI;
+   v = 32768.0 + cfg.amplitude*sin(adc_phase) +
+       cfg.noise*(2.0*rand()/(double)RAND_MAX - 1.0);
+   if(v < 0.0) v = 0.0;
+   if(v > 65535.0) v = 65535.0;
+   return (uint16_t)v;
+}
+
+static uint16_t adc_convert(uint8_t ch, uint64_t now)
+{
+   switch(ch)
+   {
+      case 8:  return adc_wave_next(now);       // PTB0, flow sensor
+      case 26: return SIM_ADC_TEMP25;
+      case 27: return SIM_ADC_BANDGAP;
+      case 29: return 0xFFFF;                   // VREFH
+      default: return 0;                        // VREFL, unconnected
+   }
+}
+
+/************************************************************************/
+/*             TPM0                                                     */
+/************************************************************************/
+static uint64_t tpm_clocks(uint64_t now)
+{
+   return now*(SIM_TPM_HZ/1000000)/1000;
+}
+
+/*****************************************************************************/
+/// \fn static void tpm0_poll(uint64_t now)
+/// @brief counts TPM0 up to now: overflows set TOF, take a buffered MOD
+/// and are counted as pulses
+/*****************************************************************************/
+static void tpm0_poll(uint64_t now)
+{
+   uint32_t ps = TPM0->SC.raw & TPM_SC_PS_MASK;
+   uint64_t n, left, per;
+
+   if(!tpm0.run) return;
+   n = (tpm_clocks(now) - tpm0.base_clk) >> ps;
+   tpm0.base_clk += n << ps;
+   while(n > 0)
+   {
+      if(tpm0.cnt > TPM0->MOD.raw)
+      {                                 // MOD went under the count, wraps
+         left = 0x10000 - tpm0.cnt;
+         if(n < left) { tpm0.cnt += n; break; }
+         n -= left;
+         tpm0.cnt = 0;
+         continue;
+      }
+      left = TPM0->MOD.raw - tpm0.cnt + 1;
+      if(n < left) { tpm0.cnt += n; break; }
+      n -= left;
+      tpm0.cnt = 0;
+      TPM0->SC.raw |= TPM_SC_TOF_MASK;
+      sim_stat.pulses++;
+      if(tpm0.pending)
+      {
+         TPM0->MOD.raw = tpm0.mod_next;
+         tpm0.pending = false;
+      }
+      per = TPM0->MOD.raw + 1;           // whole periods at once
+      sim_stat.pulses += n/per;
+      n %= per;
+   }
+}
+
+/*****************************************************************************/
+/// \fn static void dac_poll(uint64_t now)
+/// @brief notes a new code on DAC0, from the DMA or the CPU
+/*****************************************************************************/
+static void dac_poll(uint64_t now)
+{
+   uint16_t code, step;
+   if(!(DAC0->C0 & DAC_C0_DACEN_MASK)) return;
+   code = DAC0->DAT[0].DATL | ((DAC0->DAT[0].DATH & 0x0F) << 8);
+   if(code == dac_code) return;
+   step = code > dac_code ? code - dac_code : dac_code - code;
+   if(sim_stat.dac_changes && step > sim_stat.dac_step_max)
+      sim_stat.dac_step_max = step;              // not the first code
+   sim_stat.dac_changes++;
+   dac_code = code;
+   if(dac_log)
+      fprintf(dac_log, "%.6f %u %.3f\n", now*1e-9, code,
+              (double)code*AOUT_FULL_UA/4095/1000);
+}
+
+static uint32_t bus_read(uintptr_t addr, int size)
+{
+   uint32_t v = 0;
+   if(addr == (uintptr_t)&ADC0->R[0]) return ADC0->R[0];
+   if(addr == (uintptr_t)&SPI0->D) return SPI0->D;
+   memcpy(&v, (void *)addr, size);
+   return v;
+}
+
+static void bus_write(uintptr_t addr, uint32_t v, int size, uint64_t now)
+{
+   if(addr == (uintptr_t)&SPI0->D) { spi_tx((uint8_t)v, now); return; }
+   memcpy((void *)addr, &v, size);
+   if(addr == (uintptr_t)&DAC0->DAT[0]) dac_poll(now);
+}
+
+static int dma_size(uint32_t field)
+{
+   return (field == 1) ? 1 : (field == 2) ? 2 : 4;
+}
+
+/*****************************************************************************/
+/// \fn static void dma_transfer(uint8_t ch, uint64_t now)
+/// @brief a request reached channel ch: one transfer (cycle steal), or the
+/// whole block, if the channel takes requests
+/*****************************************************************************/
+static void dma_transfer(uint8_t ch, uint64_t now)
+{
+   uint32_t dcr = DMA0->DMA[ch].DCR;
+   uint32_t bcr;
+   int ss, ds;
+
+   if(!(dcr & DMA_DCR_ERQ_MASK)) return;
+   ss = dma_size((dcr & DMA_DCR_SSIZE_MASK) >> DMA_DCR_SSIZE_SHIFT);
+   ds = dma_size((dcr & DMA_DCR_DSIZE_MASK) >> DMA_DCR_DSIZE_SHIFT);
+   do
+   {
+      bcr = DMA0->DMA[ch].DSR_BCR.raw & DMA_DSR_BCR_BCR_MASK;
+      if(bcr == 0) break;
+      bus_write(DMA0->DMA[ch].DAR, bus_read(DMA0->DMA[ch].SAR, ss), ds, now);
+      if(dcr & DMA_DCR_SINC_MASK) DMA0->DMA[ch].SAR += ss;
+      if(dcr & DMA_DCR_DINC_MASK) DMA0->DMA[ch].DAR += ds;
+      bcr -= (ds > ss) ? ds : ss;
+      DMA0->DMA[ch].DSR_BCR.raw =
+         (DMA0->DMA[ch].DSR_BCR.raw & ~DMA_DSR_BCR_BCR_MASK) | bcr;
+   } while(!(dcr & DMA_DCR_CS_MASK));
+
+   if(bcr == 0)
+   {
+      DMA0->DMA[ch].DSR_BCR.raw |= DMA_DSR_BCR_DONE_MASK;
+      if(dcr & DMA_DCR_D_REQ_MASK) DMA0->DMA[ch].DCR &= ~DMA_DCR_ERQ_MASK;
+      if((DMAMUX0->CHCFG[ch] & DMAMUX_CHCFG_SOURCE_MASK) == SIM_DMAMUX_ADC0)
+      {                     // remember when each sample block completed
+         dma_done_log[sim_stat.blocks_done & 3].end = DMA0->DMA[ch].DAR;
+         dma_done_log[sim_stat.blocks_done & 3].t = now;
+         sim_stat.blocks_done++;
+      }
+   }
+}
+
+/*****************************************************************************/
+/// \fn static void dma_request(uint8_t source, uint64_t now)
+/// @brief a peripheral raised a DMA request, it goes to every channel the
+/// DMAMUX routes it to
+/*****************************************************************************/
+static void dma_request(uint8_t source, uint64_t now)
+{
+   uint8_t ch;
+   for(ch=0;ch<4;ch++)
+      if((DMAMUX0->CHCFG[ch] & DMAMUX_CHCFG_ENBL_MASK) &&
+         (DMAMUX0->CHCFG[ch] & DMAMUX_CHCFG_SOURCE_MASK) == source)
+         dma_transfer(ch, now);
+}
+
+/*****************************************************************************/
+/// \fn static int dma_armed(uint8_t source)
+/// @return the channel that would take a request from source, -1 if none
+/*****************************************************************************/
+static int dma_armed(uint8_t source)
+{
+   int ch;
+   for(ch=0;ch<4;ch++)
+      if((DMAMUX0->CHCFG[ch] & DMAMUX_CHCFG_ENBL_MASK) &&
+         (DMAMUX0->CHCFG[ch] & DMAMUX_CHCFG_SOURCE_MASK) == source &&
+         (DMA0->DMA[ch].DCR & DMA_DCR_ERQ_MASK) &&
+         (DMA0->DMA[ch].DSR_BCR.raw & DMA_DSR_BCR_BCR_MASK))
+         return ch;
+   return -1;
+}
+
+/*****************************************************************************/
+/// \fn static uint64_t spi_dma_next_ns(void)
+/// @return when SPTEF requests the transmit DMA next, not before the
+/// channel was armed, 0 if no request will be taken
+/*****************************************************************************/
+static uint64_t spi_dma_next_ns(void)
+{
+   uint64_t byte, t;
+   int ch = dma_armed(SIM_DMAMUX_SPI0_TX);
+   if(!(SPI0->C1 & SPI_C1_SPE_MASK) || !(SPI0->C2 & SPI_C2_TXDMAE_MASK) ||
+      ch < 0)
+      return 0;
+   byte = spi_byte_ns();
+   t = (spi_done_ns > byte) ? spi_done_ns - byte : 0;
+   return (t > dma_bcr_ns[ch]) ? t : dma_bcr_ns[ch];
+}
+
+/*****************************************************************************/
+/// \fn static void adc_start(uint64_t now)
+/// @brief one conversion of the channel in SC1[0], then COCO and the DMA
+/// request if enabled
+/*****************************************************************************/
+static void adc_start(uint64_t now)
+{
+   uint8_t ch = ADC0->SC1[0].raw & ADC_SC1_ADCH_MASK;
+   if(ch == 31) return;                          // module disabled
+   ADC0->R[0].raw = adc_convert(ch, now);
+   ADC0->SC1[0].raw |= ADC_SC1_COCO_MASK;
+   if(ch == 8) sim_stat.adc_samples++;
+   if(ADC0->SC2 & ADC_SC2_DMAEN_MASK) dma_request(SIM_DMAMUX_ADC0, now);
+}
+
+static uint64_t adc_trigger_period_ns(void)
+{
+   if(!(TPM1->SC & TPM_SC_CMOD_MASK)) return 0;
+   return (uint64_t)(TPM1->MOD + 1)*(1U << (TPM1->SC & TPM_SC_PS_MASK))*
+          1000000000ULL/SIM_TPM_HZ;
+}
+
+/*****************************************************************************/
+/// \fn static void adc_trigger(uint64_t now)
+/// @brief TPM1 overflow, starts a conversion if the ADC is set up for the
+/// hardware trigger.  A trigger while a software conversion owns the ADC is
+/// lost, as on the board.
+/*****************************************************************************/
+static void adc_trigger(uint64_t now)
+{
+   if(!(SIM->SOPT7 & SIM_SOPT7_ADC0ALTTRGEN_MASK) ||
+      (SIM->SOPT7 & SIM_SOPT7_ADC0TRGSEL_MASK) != SIM_ADC_TRGSEL_TPM1)
+      return;
+   if(!(ADC0->SC2 & ADC_SC2_ADTRG_MASK))
+   {
+      sim_stat.adc_trig_lost++;
+      return;
+   }
+   adc_start(now);
+}
+
+/************************************************************************/
+/*             Interrupts                                               */
+/************************************************************************/
+static bool irq_asserted(int irq)
+{
+   uint64_t now;
+   uint8_t c2, s1;
+
+   if(irq <= DMA3_IRQn)
+      return (DMA0->DMA[irq].DSR_BCR.raw & DMA_DSR_BCR_DONE_MASK) &&
+             (DMA0->DMA[irq].DCR & DMA_DCR_EINT_MASK);
+   if(irq == ADC0_IRQn)
+      return (ADC0->SC1[0].raw & (ADC_SC1_COCO_MASK | ADC_SC1_AIEN_MASK)) ==
+             (ADC_SC1_COCO_MASK | ADC_SC1_AIEN_MASK);
+   if(irq == UART0_IRQn)
+   {
+      now = sim_now_ns();
+      c2 = UART0->C2.raw;
+      s1 = uart_s1(now);
+      return ((c2 & UARTLP_C2_TIE_MASK) && (s1 & UARTLP_S1_TDRE_MASK)) ||
+             ((c2 & UARTLP_C2_TCIE_MASK) && (s1 & UARTLP_S1_TC_MASK)) ||
+             ((c2 & UARTLP_C2_RIE_MASK) && (s1 & UARTLP_S1_RDRF_MASK)) ||
+             ((UART0->C3 & UARTLP_C3_ORIE_MASK) && (s1 & UARTLP_S1_OR_MASK));
+   }
+   if(irq == PIT_IRQn)
+      return ((PIT->CHANNEL[0].TFLG.raw & PIT_TFLG_TIF_MASK) &&
+              (PIT->CHANNEL[0].TCTRL.raw & PIT_TCTRL_TIE_MASK)) ||
+             ((PIT->CHANNEL[1].TFLG.raw & PIT_TFLG_TIF_MASK) &&
+              (PIT->CHANNEL[1].TCTRL.raw & PIT_TCTRL_TIE_MASK));
+   return (sim_nvic_pending >> irq) & 1;
+}
+
+static int irq_next(void)
+{
+   uint32_t en = sim_nvic_enabled;
+   int irq;
+   for(irq=0; en; irq++, en >>= 1)
+      if((en & 1) && sim_vector[irq] && irq_asserted(irq)) return irq;
+   return -1;
+}
+
+/*****************************************************************************/
+/// \fn static void irq_service(void)
+/// @brief runs the handler of every asserted, enabled interrupt, lowest
+/// number first, until none is left
+/*****************************************************************************/
+static void irq_service(void)
+{
+   int irq, guard;
+   for(guard=0; guard<SIM_MAX_CATCHUP; guard++)
+   {
+      irq = irq_next();
+      if(irq < 0) return;
+      sim_nvic_pending &= ~(1U << irq);
+      sim_ipsr = irq + 16;
+      sim_vector[irq]();
+      sim_ipsr = 0;
+   }
+}
+
+/************************************************************************/
+/*             Metrics                                                  */
+/************************************************************************/
+static void sim_finish(int code)
+{
+   double t = sim_now_ns()*1e-9;
+   uint64_t used = sim_stat.blocks_used ? sim_stat.blocks_used : 1;
+   char buf[4096];
+   const struct sched_task *task;
+   int n = 0;
+   UCHAR i;
+
+   if(uart_tty_raw) tcsetattr(0, TCSANOW, &uart_tty_saved);
+   if(spi_log) fflush(spi_log);
+   if(dac_log) fflush(dac_log);
+   if(cfg.flash_file) save_flash();
+   n += snprintf(buf+n, sizeof(buf)-n,
+      "\nsim_time_s=%.3f\n"
+      "loops=%llu\nloop_rate_hz=%.0f\n"
+      "ticks=%llu\nticks_late=%llu\n"
+      "adc_samples=%llu\nadc_trig_lost=%llu\nadc_overrun=%u\n"
+      "blocks_done=%llu\nblocks_used=%llu\n",
+      t, (unsigned long long)sim_stat.loops, t > 0 ? sim_stat.loops/t : 0.0,
+      (unsigned long long)sim_stat.ticks, (unsigned long long)sim_stat.ticks_late,
+      (unsigned long long)sim_stat.adc_samples, (unsigned long long)sim_stat.adc_trig_lost,
+      (unsigned)adc_overrun,
+      (unsigned long long)sim_stat.blocks_done, (unsigned long long)sim_stat.blocks_used);
+   n += snprintf(buf+n, sizeof(buf)-n,
+      "block_latency_us_min=%.1f\nblock_latency_us_avg=%.1f\n"
+      "block_latency_us_max=%.1f\n",
+      sim_stat.blocks_used ? sim_stat.lat_min_ns*1e-3 : 0.0,
+      sim_stat.lat_sum_ns*1e-3/used, sim_stat.lat_max_ns*1e-3);
+   n += snprintf(buf+n, sizeof(buf)-n,
+      "uart_tx=%llu\nuart_tx_overwrite=%llu\nuart_rx=%llu\nuart_rx_lost=%llu\n"
+      "spi_tx=%llu\nspi_lost=%llu\nled_red_toggles=%llu\n"
+      "frequency=%u\ntemperature=%u\nflow=%u\n",
+      (unsigned long long)sim_stat.uart_tx, (unsigned long long)sim_stat.uart_tx_overwrite,
+      (unsigned long long)sim_stat.uart_rx, (unsigned long long)sim_stat.uart_rx_lost,
+      (unsigned long long)sim_stat.spi_tx, (unsigned long long)sim_stat.spi_lost,
+      (unsigned long long)sim_stat.led_toggles[LED_RED],
+      frequency, temperature, Flow);
+   if(cfg.step_freq > 0.0)
+   {
+      if(sim_stat.step_seen)
+         n += snprintf(buf+n, sizeof(buf)-n, "step_latency_ms=%.1f\n",
+                       sim_stat.step_latency_ns*1e-6);
+      else
+         n += snprintf(buf+n, sizeof(buf)-n, "step_latency_ms=none\n");
+   }
+   n += snprintf(buf+n, sizeof(buf)-n, "sleep_pct=%.1f\n",
+                 t > 0 ? 100.0*sim_stat.sleep_ns*1e-9/t : 0.0);
+   n += snprintf(buf+n, sizeof(buf)-n,
+      "flash_programs=%llu\nflash_erases=%llu\nflash_suspends=%llu\n"
+      "flash_errors=%llu\n",
+      (unsigned long long)sim_stat.flash_programs,
+      (unsigned long long)sim_stat.flash_erases,
+      (unsigned long long)sim_stat.flash_suspends,
+      (unsigned long long)sim_stat.flash_errors);
+   n += snprintf(buf+n, sizeof(buf)-n,
+      "dac_changes=%llu\ndac_step_max=%u\naout_ma=%.3f\n",
+      (unsigned long long)sim_stat.dac_changes, sim_stat.dac_step_max,
+      (double)dac_code*AOUT_FULL_UA/4095/1000);
+   n += snprintf(buf+n, sizeof(buf)-n,
+      "pulses=%llu\npulses_owed=%u\npulses_due=%.1f\n",
+      (unsigned long long)sim_stat.pulses, pulse_stat_get()->owed,
+      sim_stat.pulses_due);
+   for(i=0; (task = sched_task_get(i)) != NULL && n < (int)sizeof(buf)-128; i++)
+      n += snprintf(buf+n, sizeof(buf)-n,
+         "task_%s_runs=%u\ntask_%s_overruns=%u\n"
+         "task_%s_cycles_avg=%u\ntask_%s_cycles_max=%u\n",
+         task->name, task->runs, task->name, task->overruns,
+         task->name, task->cycles_avg, task->name, task->cycles_max);
+   if(write(2, buf, n) < 0) { }
+   _exit(code);
+}
+
+static void sim_check(uint64_t now)
+{
+   uint32_t target;
+   dac_poll(now);                // codes the CPU wrote
+   tpm0_poll(now);
+   if(now > sim_stat.pulses_due_ns)
+   {                             // the pulses the Flow on show is worth
+      sim_stat.pulses_due += (double)Flow*pulse_stat_get()->k/6e6*
+                             (now - sim_stat.pulses_due_ns)*1e-9;
+      sim_stat.pulses_due_ns = now;
+   }
+   if(cfg.step_freq > 0.0 && !sim_stat.step_seen && now >= cfg.step_at*1e9)
+   {                          // frequency settled within 1% of the new value
+      target = (uint32_t)(cfg.step_freq*100.0);
+      if(frequency + target/100 >= target && frequency <= target + target/100)
+      {
+         sim_stat.step_seen = true;
+         sim_stat.step_latency_ns = now - (uint64_t)(cfg.step_at*1e9);
+      }
+   }
+   if(cfg.duration > 0.0 && now >= cfg.duration*1e9) sim_finish(0);
+}
+
+/*****************************************************************************/
+/// \fn static void sim_run(void)
+/// @brief advances the simulated hardware to the current virtual time, in
+/// event order, and services the interrupts each event raises
+/*****************************************************************************/
+static void sim_run(void)
+{
+   uint64_t now = sim_now_ns();
+   uint64_t t, per, spi_t;
+   int i, n, which;
+
+   sim_deferred = 0;
+   per = adc_trigger_period_ns();
+   if(per == 0) adc_next_ns = 0;
+   else if(adc_next_ns == 0) adc_next_ns = now + per;
+
+   for(n=0; n<SIM_MAX_CATCHUP; n++)
+   {
+      t = uart_rx_next_ns;
+      which = -1;
+      for(i=0;i<SIM_MAX_TICKERS;i++)
+         if(sim_ticker[i].fn && sim_ticker[i].next_ns < t)
+         { t = sim_ticker[i].next_ns; which = i; }
+      if(adc_next_ns && adc_next_ns < t) { t = adc_next_ns; which = -2; }
+      spi_t = spi_dma_next_ns();
+      if(spi_t && spi_t < t) { t = spi_t; which = -3; }
+      for(i=0;i<2;i++)
+         if(pit_running(i) && pit_next_ns[i] < t) { t = pit_next_ns[i]; which = -4 - i; }
+      if(t > now) break;
+
+      if(which >= 0)
+      {
+         sim_ticker[which].next_ns += sim_ticker[which].period_ns;
+         sim_stat.ticks++;
+         sim_ticker[which].fn();
+      }
+      else if(which == -2)
+      {
+         adc_next_ns += per;
+         adc_trigger(t);
+      }
+      else if(which == -3) dma_request(SIM_DMAMUX_SPI0_TX, t);
+      else if(which <= -4) pit_expire(-4 - which, t);
+      else uart_rx_poll(now);
+      irq_service();
+   }
+   if(n == SIM_MAX_CATCHUP)
+   {                           // host fell behind, drop the backlog
+      sim_stat.ticks_late++;
+      for(i=0;i<SIM_MAX_TICKERS;i++)
+         if(sim_ticker[i].fn) sim_ticker[i].next_ns = now + sim_ticker[i].period_ns;
+      if(adc_next_ns) adc_next_ns = now + per;
+      for(i=0;i<2;i++)
+         if(pit_next_ns[i]) pit_next_ns[i] = now + pit_period_ns(i);
+   }
+   irq_service();
+   sim_check(now);
+}
+
+static void sim_alarm(int sig)
+{
+   int saved = errno;
+   (void)sig;
+   if(sim_depth || sim_primask || sim_ctx) sim_deferred = 1;
+   else
+   {
+      sim_ctx++;
+      sim_run();
+      sim_ctx--;
+   }
+   errno = saved;
+}
+
+static void sim_stop(int sig)
+{
+   (void)sig;
+   sim_finish(0);
+}
+
+/************************************************************************/
+/*             Register hooks                                           */
+/************************************************************************/
+static void sim_enter(void)
+{
+   sim_depth++;
+}
+
+static void sim_leave(void)
+{
+   sim_depth--;
+   if(sim_depth == 0 && sim_ctx == 0 && !sim_primask &&
+      (sim_deferred || irq_next() >= 0))
+      sim_run_main();
+}
+
+extern "C" uint32_t sim_reg_read(int id, const volatile void *reg)
+{
+   uint32_t v = 0;
+   uint64_t now = sim_now_ns();
+   sim_enter();
+   switch(id)
+   {
+      case SIM_ADC0_SC1:
+         v = ((const volatile SimReg<uint32_t, SIM_ADC0_SC1> *)reg)->raw;
+         break;
+      case SIM_ADC0_R:              // reading the result clears COCO
+         v = ((const volatile SimReg<uint32_t, SIM_ADC0_R> *)reg)->raw;
+         if(reg == &ADC0->R[0]) ADC0->SC1[0].raw &= ~ADC_SC1_COCO_MASK;
+         else ADC0->SC1[1].raw &= ~ADC_SC1_COCO_MASK;
+         break;
+      case SIM_UART0_C2:
+         v = UART0->C2.raw;
+         break;
+      case SIM_UART0_S1:
+         v = uart_s1(now);
+         break;
+      case SIM_UART0_D:             // reading the data clears RDRF
+         v = uart_rx_data;
+         uart_rdrf = false;
+         break;
+      case SIM_SPI_S:
+         v = spi_s(now);
+         break;
+      case SIM_SPI_D:
+         v = 0xFF;
+         if(spi_s(now) & SPI_S_SPRF_MASK) spi_rx_pending = false;
+         break;
+      case SIM_DMA_DSR_BCR:
+         v = ((const volatile SimReg<uint32_t, SIM_DMA_DSR_BCR> *)reg)->raw;
+         break;
+      case SIM_PIT_CVAL:
+         v = pit_cval(reg == &PIT->CHANNEL[0].CVAL ? 0 : 1, now);
+         break;
+      case SIM_PIT_TCTRL:
+         v = ((const volatile SimReg<uint32_t, SIM_PIT_TCTRL> *)reg)->raw;
+         break;
+      case SIM_PIT_TFLG:
+         v = ((const volatile SimReg<uint32_t, SIM_PIT_TFLG> *)reg)->raw;
+         break;
+      case SIM_FTFA_FSTAT:
+         ftfa_poll(now);
+         v = FTFA->FSTAT.raw;
+         break;
+      case SIM_FTFA_FCNFG:
+         ftfa_poll(now);
+         v = FTFA->FCNFG.raw;
+         break;
+      case SIM_TPM_SC:
+         if(reg == &TPM0->SC) tpm0_poll(now);
+         v = ((const volatile SimReg<uint32_t, SIM_TPM_SC> *)reg)->raw;
+         break;
+      case SIM_TPM_CNT:
+         if(reg == &TPM0->CNT)
+         {
+            tpm0_poll(now);
+            v = tpm0.cnt;
+         }
+         else v = ((const volatile SimReg<uint32_t, SIM_TPM_CNT> *)reg)->raw;
+         break;
+      case SIM_TPM_MOD:
+         v = ((const volatile SimReg<uint32_t, SIM_TPM_MOD> *)reg)->raw;
+         break;
+      case SIM_SYSTICK_VAL:
+      {
+         uint32_t reload = (SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1;
+         if(!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk)) v = SysTick->VAL.raw;
+         else v = reload - 1 - (uint32_t)((now*(SystemCoreClock/1000000)/1000 -
+                  SysTick->VAL.raw) % reload);
+         break;
+      }
+   }
+   sim_leave();
+   return v;
+}
+
+extern "C" void sim_reg_write(int id, volatile void *reg, uint32_t value)
+{
+   uint64_t now = sim_now_ns();
+   sim_enter();
+   switch(id)
+   {
+      case SIM_ADC0_SC1:
+      {
+         volatile SimReg<uint32_t, SIM_ADC0_SC1> *r =
+            (volatile SimReg<uint32_t, SIM_ADC0_SC1> *)reg;
+         r->raw = value & ~ADC_SC1_COCO_MASK;   // a write aborts and restarts
+         if(r == &ADC0->SC1[0] && !(ADC0->SC2 & ADC_SC2_ADTRG_MASK))
+            adc_start(now);                      // software trigger
+         break;
+      }
+      case SIM_ADC0_R:
+         break;                                  // read only
+      case SIM_UART0_C2:
+         UART0->C2.raw = (uint8_t)value;
+         break;
+      case SIM_UART0_S1:
+         if(value & UARTLP_S1_OR_MASK) uart_or = false;   // w1c
+         break;
+      case SIM_UART0_D:
+         uart_tx((uint8_t)value, now);
+         break;
+      case SIM_SPI_S:
+         break;                                  // read only
+      case SIM_SPI_D:
+         spi_tx((uint8_t)value, now);
+         break;
+      case SIM_DMA_DSR_BCR:
+      {                               // DONE is w1c and clears all status
+         volatile SimReg<uint32_t, SIM_DMA_DSR_BCR> *r =
+            (volatile SimReg<uint32_t, SIM_DMA_DSR_BCR> *)reg;
+         uint32_t dsr = r->raw & ~DMA_DSR_BCR_BCR_MASK;
+         if(value & DMA_DSR_BCR_DONE_MASK) dsr = 0;
+         r->raw = dsr | (value & DMA_DSR_BCR_BCR_MASK);
+         dma_bcr_ns[((uintptr_t)r - (uintptr_t)&DMA0->DMA[0].DSR_BCR)/
+                    sizeof(DMA0->DMA[0])] = now;
+         break;
+      }
+      case SIM_PIT_CVAL:
+         break;                                  // read only
+      case SIM_PIT_TCTRL:
+      {                               // enabling loads LDVAL and starts
+         volatile SimReg<uint32_t, SIM_PIT_TCTRL> *r =
+            (volatile SimReg<uint32_t, SIM_PIT_TCTRL> *)reg;
+         int ch = (r == &PIT->CHANNEL[0].TCTRL) ? 0 : 1;
+         if(!(value & PIT_TCTRL_TEN_MASK)) pit_next_ns[ch] = 0;
+         else if(!(r->raw & PIT_TCTRL_TEN_MASK))
+            pit_next_ns[ch] = now + pit_period_ns(ch);
+         r->raw = value;
+         break;
+      }
+      case SIM_PIT_TFLG:              // TIF is w1c
+         ((volatile SimReg<uint32_t, SIM_PIT_TFLG> *)reg)->raw &= ~(value & PIT_TFLG_TIF_MASK);
+         break;
+      case SIM_FTFA_FSTAT:            // errors are w1c, CCIF launches
+         ftfa_poll(now);
+         FTFA->FSTAT.raw &= ~(value & (FTFA_FSTAT_ACCERR_MASK | FTFA_FSTAT_FPVIOL_MASK));
+         if((value & FTFA_FSTAT_CCIF_MASK) && !ftfa.busy) ftfa_launch(now);
+         break;
+      case SIM_FTFA_FCNFG:            // ERSSUSP stops an erase soon after
+         ftfa_poll(now);
+         if((value & FTFA_FCNFG_ERSSUSP_MASK) && ftfa.busy && ftfa.cmd == 0x09 &&
+            !ftfa.suspending && ftfa.done_ns > now + SIM_FLASH_SUSP_NS)
+         {
+            ftfa.suspending = true;
+            ftfa.left_ns = ftfa.done_ns - now;
+            ftfa.done_ns = now + SIM_FLASH_SUSP_NS;
+         }
+         FTFA->FCNFG.raw = (uint8_t)value;
+         break;
+      case SIM_TPM_SC:                // TOF is w1c, CMOD starts and stops
+      {
+         volatile SimReg<uint32_t, SIM_TPM_SC> *r =
+            (volatile SimReg<uint32_t, SIM_TPM_SC> *)reg;
+         uint32_t tof = r->raw & TPM_SC_TOF_MASK & ~value;
+         if(r == &TPM0->SC)
+         {
+            tpm0_poll(now);
+            tof = r->raw & TPM_SC_TOF_MASK & ~value;
+            if(!tpm0.run && (value & TPM_SC_CMOD_MASK))
+               tpm0.base_clk = tpm_clocks(now);
+            tpm0.run = (value & TPM_SC_CMOD_MASK) != 0;
+         }
+         r->raw = (value & ~TPM_SC_TOF_MASK) | tof;
+         break;
+      }
+      case SIM_TPM_CNT:               // any write clears the counter
+         if(reg == &TPM0->CNT)
+         {
+            tpm0_poll(now);
+            tpm0.cnt = 0;
+            tpm0.base_clk = tpm_clocks(now);
+         }
+         ((volatile SimReg<uint32_t, SIM_TPM_CNT> *)reg)->raw = 0;
+         break;
+      case SIM_TPM_MOD:               // taken at the overflow while counting
+         if(reg == &TPM0->MOD && tpm0.run)
+         {
+            tpm0_poll(now);
+            tpm0.mod_next = value & 0xFFFF;
+            tpm0.pending = true;
+         }
+         else
+         {
+            if(reg == &TPM0->MOD) tpm0.pending = false;
+            ((volatile SimReg<uint32_t, SIM_TPM_MOD> *)reg)->raw = value & 0xFFFF;
+         }
+         break;
+      case SIM_SYSTICK_VAL:           // any write clears the counter
+         SysTick->VAL.raw = (uint32_t)(now*(SystemCoreClock/1000000)/1000);
+         break;
+   }
+   sim_leave();
+}
+
+/************************************************************************/
+/*             Core                                                     */
+/************************************************************************/
+extern "C" void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+   if(IRQn < 0) return;
+   sim_enter();
+   sim_nvic_enabled |= 1U << IRQn;
+   sim_leave();
+}
+
+extern "C" void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+   if(IRQn >= 0) sim_nvic_enabled &= ~(1U << IRQn);
+}
+
+extern "C" void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+   if(IRQn < 0) return;
+   sim_enter();
+   sim_nvic_pending |= 1U << IRQn;
+   sim_leave();
+}
+
+extern "C" void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+   if(IRQn >= 0) sim_nvic_pending &= ~(1U << IRQn);
+}
+
+extern "C" void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+   (void)IRQn;                 // handlers run lowest number first
+   (void)priority;
+}
+
+extern "C" void __disable_irq(void)
+{
+   if(sim_ctx == 0) sigprocmask(SIG_BLOCK, &sim_alarm_set, NULL);
+   sim_primask = 1;
+}
+
+extern "C" void __enable_irq(void)
+{
+   sim_primask = 0;
+   if(sim_ctx) return;
+   sigprocmask(SIG_UNBLOCK, &sim_alarm_set, NULL);
+   if(sim_deferred || irq_next() >= 0) sim_run_main();
+}
+
+/*****************************************************************************/
+/// \fn uint32_t __get_IPSR(void)
+/// @return the exception number of the handler running, 0 in the loop
+/*****************************************************************************/
+extern "C" uint32_t __get_IPSR(void)
+{
+   return sim_ipsr;
+}
+
+/*****************************************************************************/
+/// \fn void __WFI(void)
+/// @brief sleeps until the next interrupt, time asleep is reported as
+/// sleep_pct.  Like the core, an interrupt masked by __disable_irq() still
+/// wakes it up and runs once the mask is lifted.
+/*****************************************************************************/
+extern "C" void __WFI(void)
+{
+   sigset_t old, wait;
+   uint64_t t;
+   if(sim_ctx) return;
+   sigprocmask(SIG_BLOCK, &sim_alarm_set, &old);
+   if(!sim_deferred && irq_next() < 0)
+   {
+      t = sim_now_ns();
+      wait = old;
+      sigdelset(&wait, SIGALRM);
+      sigsuspend(&wait);
+      sim_stat.sleep_ns += sim_now_ns() - t;
+   }
+   sigprocmask(SIG_SETMASK, &old, NULL);
+   if(!sim_primask && sim_deferred) sim_run_main();
+}
+
+/************************************************************************/
+/*             mbed shim                                                */
+/************************************************************************/
+extern "C" void sim_ticker_attach(void *owner, void (*fn)(void), uint32_t period_us)
+{
+   sigset_t old;
+   int i, slot = -1;
+   sigprocmask(SIG_BLOCK, &sim_alarm_set, &old);
+   for(i=0;i<SIM_MAX_TICKERS;i++)
+   {
+      if(sim_ticker[i].owner == owner) { slot = i; break; }
+      if(slot < 0 && !sim_ticker[i].fn) slot = i;
+   }
+   if(slot >= 0)
+   {
+      sim_ticker[slot].owner = owner;
+      sim_ticker[slot].fn = fn;
+      sim_ticker[slot].period_ns = (uint64_t)(period_us ? period_us : 1)*1000ULL;
+      sim_ticker[slot].next_ns = sim_now_ns() + sim_ticker[slot].period_ns;
+   }
+   sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
+extern "C" void sim_ticker_detach(void *owner)
+{
+   sigset_t old;
+   int i;
+   sigprocmask(SIG_BLOCK, &sim_alarm_set, &old);
+   for(i=0;i<SIM_MAX_TICKERS;i++)
+      if(sim_ticker[i].owner == owner) memset(&sim_ticker[i], 0, sizeof(sim_ticker[i]));
+   sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
+extern "C" void sim_pin_write(PinName pin, int value)
+{
+   if(pin < 0 || pin >= SIM_PIN_COUNT) return;
+   if(pin_state[pin] != !!value) sim_stat.led_toggles[pin]++;
+   pin_state[pin] = !!value;
+}
+
+/************************************************************************/
+/*             Firmware hooks (-Wl,--wrap)                              */
+/************************************************************************/
+extern "C" {
+void __real_sched_dispatch(void);
+const uint16_t *__real_adc_block_get(void);
+void __real_adc_block_release(void);
+
+void __wrap_sched_dispatch(void)
+{
+   sim_stat.loops++;           // sched_dispatch() runs once per super loop pass
+   __real_sched_dispatch();
+}
+
+const uint16_t *__wrap_adc_block_get(void)
+{
+   const uint16_t *p = __real_adc_block_get();
+   int i;
+   if(p && p != held_block)
+   {
+      held_block = p;
+      held_done_ns = 0;
+      for(i=0;i<4;i++)
+         if(dma_done_log[i].end == (uintptr_t)(p + ADC_BLOCK_SIZE) &&
+            dma_done_log[i].t > held_done_ns)
+            held_done_ns = dma_done_log[i].t;
+   }
+   return p;
+}
+
+void __wrap_adc_block_release(void)
+{
+   uint64_t lat;
+   if(held_block && held_done_ns)
+   {                           // block complete to block processed
+      lat = sim_now_ns() - held_done_ns;
+      if(!sim_stat.blocks_used || lat < sim_stat.lat_min_ns) sim_stat.lat_min_ns = lat;
+      if(lat > sim_stat.lat_max_ns) sim_stat.lat_max_ns = lat;
+      sim_stat.lat_sum_ns += lat;
+      sim_stat.blocks_used++;
+   }
+   held_block = NULL;
+   __real_adc_block_release();
+}
+}
+
+/************************************************************************/
+/*             Setup                                                    */
+/************************************************************************/
+static void usage(void)
+{
+   fprintf(stderr,
+      "usage: m4sim [options]\n"
+      "  -d sec      stop after sec of virtual time and print the summary\n"
+      "  -s scale    virtual seconds per host second (default 1)\n"
+      "  -w file     flow sensor waveform, one ADC sample per line\n"
+      "  -f hz       synthesized vortex frequency (default 400)\n"
+      "  -F hz@sec   step the synthesized frequency at time sec\n"
+      "  -a counts   synthesized amplitude (default 16000)\n"
+      "  -n counts   uniform noise added to the synthesized signal\n"
+      "  -b baud     UART0 baud rate (default 9600)\n"
+      "  -p          UART0 on a pseudo terminal instead of stdin/stdout\n"
+      "  -o file     UART0 output to file (/dev/null for benchmarks)\n"
+      "  -l file     log SPI0 bytes to file\n"
+      "  -m file     flash image, read at start if there, written at the end\n"
+      "  -c file     log DAC0 changes to file: time_s code loop_mA\n");
+   exit(2);
+}
+
+static void load_wave(const char *name)
+{
+   char line[64];
+   FILE *f = fopen(name, "r");
+   if(!f) { perror(name); exit(1); }
+   while(fgets(line, sizeof(line), f))
+      if(line[0] != '#' && line[0] != '\n')
+         adc_wave.push_back((uint16_t)strtoul(line, NULL, 0));
+   fclose(f);
+   if(adc_wave.empty()) { fprintf(stderr, "%s: no samples\n", name); exit(1); }
+}
+
+static void load_flash(void)
+{
+   FILE *f = fopen(cfg.flash_file, "rb");
+   memset(sim_flash, 0xFF, sizeof(sim_flash));    // erased
+   if(!f) return;
+   if(fread(sim_flash, 1, sizeof(sim_flash), f) != sizeof(sim_flash))
+      fprintf(stderr, "%s: short flash image\n", cfg.flash_file);
+   fclose(f);
+}
+
+static void save_flash(void)
+{
+   int fd = open(cfg.flash_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if(fd < 0 || write(fd, sim_flash, sizeof(sim_flash)) != (ssize_t)sizeof(sim_flash))
+      perror(cfg.flash_file);
+   if(fd >= 0) close(fd);
+}
+
+static void open_uart(void)
+{
+   struct termios raw;
+   if(cfg.pty)
+   {
+      int fd = posix_openpt(O_RDWR | O_NOCTTY);
+      if(fd < 0 || grantpt(fd) || unlockpt(fd)) { perror("pty"); exit(1); }
+      fprintf(stderr, "UART0 on %s\n", ptsname(fd));
+      uart_in_fd = uart_out_fd = fd;
+   }
+   else
+   {
+      uart_in_fd = 0;
+      if(isatty(0) && tcgetattr(0, &uart_tty_saved) == 0)
+      {                        // one key at a time, the firmware echoes
+         raw = uart_tty_saved;
+         raw.c_lflag &= ~(ICANON | ECHO);
+         tcsetattr(0, TCSANOW, &raw);
+         uart_tty_raw = true;
+      }
+   }
+   fcntl(uart_in_fd, F_SETFL, fcntl(uart_in_fd, F_GETFL) | O_NONBLOCK);
+   if(cfg.uart_out)
+   {
+      uart_out_fd = open(cfg.uart_out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if(uart_out_fd < 0) { perror(cfg.uart_out); exit(1); }
+   }
+}
+
+int main(int argc, char **argv)
+{
+   struct sigaction sa;
+   struct itimerval it;
+   uint64_t tick_ns;
+   int opt;
+
+   while((opt = getopt(argc, argv, "d:s:w:f:F:a:n:b:po:l:m:c:h")) != -1)
+   {
+      switch(opt)
+      {
+         case 'd': cfg.duration = atof(optarg); break;
+         case 's': cfg.scale = atof(optarg); break;
+         case 'w': cfg.wave_file = optarg; break;
+         case 'f': cfg.freq = atof(optarg); break;
+         case 'F':
+            if(sscanf(optarg, "%lf@%lf", &cfg.step_freq, &cfg.step_at) != 2) usage();
+            break;
+         case 'a': cfg.amplitude = atof(optarg); break;
+         case 'n': cfg.noise = atof(optarg); break;
+         case 'b': cfg.baud = strtoul(optarg, NULL, 0); break;
+         case 'p': cfg.pty = true; break;
+         case 'o': cfg.uart_out = optarg; break;
+         case 'l': cfg.spi_log = optarg; break;
+         case 'm': cfg.flash_file = optarg; break;
+         case 'c': cfg.dac_log = optarg; break;
+         default: usage();
+      }
+   }
+   if(cfg.scale <= 0.0 || cfg.baud == 0) usage();
+   if(cfg.wave_file) load_wave(cfg.wave_file);
+   if(cfg.flash_file) load_flash();
+   else memset(sim_flash, 0xFF, sizeof(sim_flash));
+   if(cfg.spi_log && !(spi_log = fopen(cfg.spi_log, "w"))) { perror(cfg.spi_log); exit(1); }
+   if(cfg.dac_log && !(dac_log = fopen(cfg.dac_log, "w"))) { perror(cfg.dac_log); exit(1); }
+   open_uart();
+
+   sim_vector[DMA0_IRQn] = DMA0_IRQHandler;
+   sim_vector[DMA1_IRQn] = DMA1_IRQHandler;
+   sim_vector[DMA2_IRQn] = DMA2_IRQHandler;
+   sim_vector[DMA3_IRQn] = DMA3_IRQHandler;
+   sim_vector[SPI0_IRQn] = SPI0_IRQHandler;
+   sim_vector[UART0_IRQn] = UART0_IRQHandler;
+   sim_vector[ADC0_IRQn] = ADC0_IRQHandler;
+   sim_vector[TPM0_IRQn] = TPM0_IRQHandler;
+   sim_vector[TPM1_IRQn] = TPM1_IRQHandler;
+   sim_vector[TPM2_IRQn] = TPM2_IRQHandler;
+   sim_vector[PIT_IRQn] = PIT_IRQHandler;
+   sim_vector[DAC0_IRQn] = DAC0_IRQHandler;
+
+   ADC0->SC1[0].raw = ADC0->SC1[1].raw = 0x1F;   // reset values
+   SPI0->BR = 0;
+   UART0->S1.raw = UARTLP_S1_TDRE_MASK | UARTLP_S1_TC_MASK;
+   PIT->MCR = PIT_MCR_MDIS_MASK;
+   SIM->CLKDIV1 = SIM_CLKDIV1_OUTDIV1(1) | SIM_CLKDIV1_OUTDIV4(1);  // SystemInit
+   FTFA->FSTAT.raw = FTFA_FSTAT_CCIF_MASK;
+
+   sigemptyset(&sim_alarm_set);
+   sigaddset(&sim_alarm_set, SIGALRM);
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = sim_alarm;
+   sa.sa_flags = SA_RESTART;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGALRM, &sa, NULL);
+   sa.sa_handler = sim_stop;
+   sigaction(SIGINT, &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+
+   sim_t0_ns = sim_host_ns();
+   tick_ns = (uint64_t)(SIM_TICK_NS/cfg.scale);
+   it.it_interval.tv_sec = tick_ns/1000000000ULL;
+   it.it_interval.tv_usec = (tick_ns%1000000000ULL)/1000;
+   if(it.it_interval.tv_sec == 0 && it.it_interval.tv_usec == 0)
+      it.it_interval.tv_usec = 1;
+   it.it_value = it.it_interval;
+   setitimer(ITIMER_REAL, &it, NULL);
+
+   return fw_main();
+}
@@ -0,0 +1,150 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file sim_core.h
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Simulator                                             --
+--                      sim_core.h                                           --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target:  Linux host, g++
+--
+--
+   Functional Description:
+   Stands in for core_cm0plus.h when the firmware is built for the host.
+   The generated MKL25Z4.h includes this file instead of the CMSIS core.
+
+   Registers with side effects are declared as SimReg<> in the generated
+   register map.  Reading or writing one calls sim_reg_read() or
+   sim_reg_write() in sim.cpp with the register id below, so the simulator
+   can model status flags, data registers and interrupt requests.  All
+   other registers are plain memory.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#ifndef SIM_CORE_H
+#define SIM_CORE_H
+
+#include <stdint.h>
+
+#define __I     volatile        /* read only, writable by the simulator */
+#define __O     volatile
+#define __IO    volatile
+
+/* registers with side effects */
+enum sim_reg_id
+{
+   SIM_ADC0_SC1,
+   SIM_ADC0_R,
+   SIM_UART0_C2,
+   SIM_UART0_S1,
+   SIM_UART0_D,
+   SIM_SPI_S,
+   SIM_SPI_D,
+   SIM_DMA_DSR_BCR,
+   SIM_PIT_CVAL,
+   SIM_PIT_TCTRL,
+   SIM_PIT_TFLG,
+   SIM_SYSTICK_VAL,
+   SIM_FTFA_FSTAT,
+   SIM_FTFA_FCNFG,
+   SIM_TPM_SC,
+   SIM_TPM_CNT,
+   SIM_TPM_MOD
+};
+
+#ifndef __cplusplus
+#error "the simulated register map needs C++"
+#endif
+
+extern "C" {
+
+extern uint32_t SystemCoreClock;
+
+extern uint8_t sim_flash[];   /* program flash, FTFA commands change it */
+#define FLASH_MEM ((uintptr_t)sim_flash)
+
+uint32_t sim_reg_read(int id, const volatile void *reg);
+void sim_reg_write(int id, volatile void *reg, uint32_t value);
+
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+
+void __enable_irq(void);
+void __disable_irq(void);
+void __WFI(void);
+uint32_t __get_IPSR(void);
+static inline void __NOP(void) { }
+static inline void __DSB(void) { }
+static inline void __ISB(void) { }
+
+}
+
+/*****************************************************************************/
+/// \class SimReg
+/// @brief register with side effects, raw holds the value the hardware
+/// would show and is only touched directly by sim.cpp
+/*****************************************************************************/
+template <typename T, int ID> struct SimReg
+{
+   volatile T raw;
+
+   operator T() const { return (T)sim_reg_read(ID, this); }
+   SimReg &operator=(T v) { sim_reg_write(ID, this, v); return *this; }
+   SimReg &operator|=(uint32_t v) { return *this = (T)(T(*this) | v); }
+   SimReg &operator&=(uint32_t v) { return *this = (T)(T(*this) & v); }
+   SimReg &operator^=(uint32_t v) { return *this = (T)(T(*this) ^ v); }
+   SimReg &operator+=(uint32_t v) { return *this = (T)(T(*this) + v); }
+   SimReg &operator-=(uint32_t v) { return *this = (T)(T(*this) - v); }
+};
+
+/* SysTick, the current value runs from the simulated core clock */
+typedef struct
+{
+   __IO uint32_t CTRL;
+   __IO uint32_t LOAD;
+   SimReg<uint32_t, SIM_SYSTICK_VAL> VAL;
+   __I  uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << 16)
+#define SysTick_CTRL_CLKSOURCE_Msk  (1UL << 2)
+#define SysTick_CTRL_TICKINT_Msk    (1UL << 1)
+#define SysTick_CTRL_ENABLE_Msk     (1UL << 0)
+#define SysTick_LOAD_RELOAD_Msk     (0xFFFFFFUL)
+#define SysTick_VAL_CURRENT_Msk     (0xFFFFFFUL)
+
+/* System Control Block, only what the firmware touches */
+typedef struct
+{
+   __I  uint32_t CPUID;
+   __IO uint32_t ICSR;
+   __IO uint32_t VTOR;
+   __IO uint32_t AIRCR;
+   __IO uint32_t SCR;
+   __IO uint32_t CCR;
+} SCB_Type;
+
+#define SCB_SCR_SEVONPEND_Msk       (1UL << 4)
+#define SCB_SCR_SLEEPDEEP_Msk       (1UL << 2)
+#define SCB_SCR_SLEEPONEXIT_Msk     (1UL << 1)
+
+extern "C" SysTick_Type sim_SysTick;
+extern "C" SCB_Type sim_SCB;
+#define SysTick (&sim_SysTick)
+#define SCB     (&sim_SCB)
+
+#endif
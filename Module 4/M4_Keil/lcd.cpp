@@ -0,0 +1,201 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file lcd.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      lcd.cpp                                              --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Flow, frequency and temperature on the serial LCD on SPI0.
+
+   The display is a 4 x 20 character module behind a serial backpack that
+   takes text, plus HD44780 commands after a 0xFE prefix.  Two copies of
+   the screen are kept: lcd_frame, what it should show, and lcd_shown,
+   what was sent.  Every refresh (LCD_REFRESH_HZ, scheduled from main.cpp)
+   lcd_update() formats the live values into lcd_frame, compares the two
+   and queues a cursor move plus the characters for each run that changed.
+   The queue goes out by DMA channel DMA_CH_LCD on the SPI0 transmit
+   request, so the CPU only formats and compares.  When nothing changed
+   nothing is sent.
+
+   A refresh that finds the last transfer still running is skipped and
+   counted in lcd_busy_count, the next one picks up the changes.
+
+   SPI setup from the ADC/SPI tutorial in: Freescale ARM Cortex-M Embedded
+   Programming: Using C Language (ARM books Book 3)
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+#include "MKL25Z4.h"
+
+#define LCD_ROWS           4
+#define LCD_COLS           20
+#define LCD_CMD            0xFE    /* backpack prefix, next byte is a command */
+#define LCD_CMD_CLEAR      0x01    /* HD44780 clear display */
+#define LCD_CMD_DDRAM      0x80    /* HD44780 set cursor, | address */
+#define LCD_RUN_GAP        2       /* unchanged characters cheaper to resend
+                                      than a cursor move */
+#define LCD_TX_SIZE        (LCD_ROWS*(LCD_COLS + 2) + 2)  /* whole screen */
+#define DMAMUX_SRC_SPI0_TX 17      /* DMA request source for SPI0 transmit */
+#define LCD_VALUE_COL      11      /* values right aligned in cols 11..19 */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static char lcd_frame[LCD_ROWS][LCD_COLS];   // screen to show
+   static char lcd_shown[LCD_ROWS][LCD_COLS];   // screen sent to the module
+   static UCHAR lcd_tx[LCD_TX_SIZE];            // DMA source, one transfer
+   static UCHAR lcd_busy = 0;                   // transfer in progress
+   uint16_t lcd_busy_count = 0;                 // refreshes skipped, busy
+
+   static const UCHAR lcd_row_addr[LCD_ROWS] = {0x00, 0x40, 0x14, 0x54};
+   static const char * const lcd_label[LCD_ROWS] =
+   {
+      "Flow(GPM)", "Freq(Hz)", "Temp(C)", ""
+   };
+
+/*****************************************************************************/
+/// \fn static void lcd_put_x100(char *dst, uint32_t x)
+/// @brief writes a (x100) value right aligned in the value columns, with
+/// two decimals, "1283.76"
+/*****************************************************************************/
+static void lcd_put_x100(char *dst, uint32_t x)
+{
+   fmt_dec(dst, x, 2, LCD_COLS - LCD_VALUE_COL);
+}
+
+/*****************************************************************************/
+/// \fn static void lcd_dma_start(uint16_t n)
+/// @brief asserts /SS and sends the first n bytes of lcd_tx
+/*****************************************************************************/
+static void lcd_dma_start(uint16_t n)
+{
+   lcd_busy = 1;
+   PTC->PCOR = 1;                           /* assert /SS */
+   DMA0->DMA[DMA_CH_LCD].SAR = (uintptr_t)lcd_tx;
+   DMA0->DMA[DMA_CH_LCD].DSR_BCR = DMA_DSR_BCR_BCR(n);
+   DMA0->DMA[DMA_CH_LCD].DCR |= DMA_DCR_ERQ_MASK;
+}
+
+/*****************************************************************************/
+/// \fn void lcd_init(void)
+/// @brief sets up SPI0 and its DMA channel, then clears the display
+/*****************************************************************************/
+void lcd_init(void)
+{
+   UCHAR r, c;
+
+   SIM->SCGC5 |= 0x0800;     /* enable clock to Port C */
+   /*Set ports to alternative 2 for SPI*/
+   PORTC->PCR[4] = 0x200;    /* make PTC4 pin as SPI0 PCS0 */
+   PORTC->PCR[5] = 0x200;    /* make PTC5 pin as SPI0 SCK */
+   PORTC->PCR[6] = 0x200;    /* make PTC6 pin as SPI0 MOSI */
+   PORTC->PCR[7] = 0x200;    /* make PTC7 pin as SPI0 MISO */
+   PTC->PDDR |= 0x01;        /* make PTC0 as output pin for /SS */
+   PTC->PSOR = 0x01;         /* make PTC0 idle high */
+   SIM->SCGC4 |= 0x400000;   /* enable clock to SPI0 */
+   SPI0->C1 = 0x10;          /* disable SPI and make SPI0 master */
+   SPI0->BR = 0x60;          /* set Baud rate to 1 MHz */
+   SPI0->C2 = SPI_C2_TXDMAE_MASK;  /* SPTEF requests the DMA */
+   SPI0->C1 |= 0x40;         /* Enable SPI module */
+
+/* DMA: byte writes from lcd_tx to the data register, one per request */
+   SIM->SCGC6 |= SIM_SCGC6_DMAMUX_MASK;
+   SIM->SCGC7 |= SIM_SCGC7_DMA_MASK;
+   DMAMUX0->CHCFG[DMA_CH_LCD] = 0;
+   DMA0->DMA[DMA_CH_LCD].DSR_BCR = DMA_DSR_BCR_DONE_MASK;
+   DMA0->DMA[DMA_CH_LCD].DAR = (uintptr_t)&SPI0->D;
+   DMA0->DMA[DMA_CH_LCD].DCR = DMA_DCR_CS_MASK | DMA_DCR_SINC_MASK |
+                 DMA_DCR_SSIZE(1) | DMA_DCR_DSIZE(1) | DMA_DCR_D_REQ_MASK;
+   DMAMUX0->CHCFG[DMA_CH_LCD] = DMAMUX_CHCFG_ENBL_MASK |
+                                DMAMUX_CHCFG_SOURCE(DMAMUX_SRC_SPI0_TX);
+
+/* the module is blank after the clear, the labels go out with the first
+   refresh */
+   for(r=0;r<LCD_ROWS;r++)
+   {
+      for(c=0;c<LCD_COLS;c++) lcd_shown[r][c] = lcd_frame[r][c] = ' ';
+      for(c=0;lcd_label[r][c] != 0;c++) lcd_frame[r][c] = lcd_label[r][c];
+   }
+   lcd_tx[0] = LCD_CMD;
+   lcd_tx[1] = LCD_CMD_CLEAR;
+   lcd_dma_start(2);
+}
+
+/*****************************************************************************/
+/// \fn UCHAR lcd_idle(void)
+/// @return 1 when no transfer is running, ends the last one if it is done
+/*****************************************************************************/
+UCHAR lcd_idle(void)
+{
+   if(lcd_busy)
+   {
+      if(!(DMA0->DMA[DMA_CH_LCD].DSR_BCR & DMA_DSR_BCR_DONE_MASK)) return 0;
+      if(!(SPI0->S & SPI_S_SPTEF_MASK)) return 0;  /* last byte queued */
+      DMA0->DMA[DMA_CH_LCD].DSR_BCR = DMA_DSR_BCR_DONE_MASK;  /* clear DONE */
+      (void)(UCHAR)SPI0->D;                 /* read to clear SPRF */
+      PTC->PSOR = 1;                        /* deassert /SS */
+      lcd_busy = 0;
+   }
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn void lcd_update(void)
+/// @brief one display refresh: formats the values and sends what changed
+/*****************************************************************************/
+void lcd_update(void)
+{
+   UCHAR r, c, start, end;
+   uint16_t n = 0;
+
+   if(!lcd_idle())
+   {
+      lcd_busy_count++;
+      return;
+   }
+
+   lcd_put_x100(&lcd_frame[0][LCD_VALUE_COL], Flow);
+   lcd_put_x100(&lcd_frame[1][LCD_VALUE_COL], frequency);
+   lcd_put_x100(&lcd_frame[2][LCD_VALUE_COL], temperature);
+
+   for(r=0;r<LCD_ROWS;r++)
+   {
+      c = 0;
+      for(;;)
+      {
+         while(c < LCD_COLS && lcd_frame[r][c] == lcd_shown[r][c]) c++;
+         if(c == LCD_COLS) break;
+         start = c;             // a run of changes, to the last change not
+         end = c;               // followed by more than LCD_RUN_GAP equal ones
+         while(c < LCD_COLS && c - end <= LCD_RUN_GAP)
+         {
+            if(lcd_frame[r][c] != lcd_shown[r][c]) end = c;
+            c++;
+         }
+         lcd_tx[n++] = LCD_CMD;
+         lcd_tx[n++] = LCD_CMD_DDRAM | (lcd_row_addr[r] + start);
+         for(c=start;c<=end;c++) lcd_tx[n++] = lcd_shown[r][c] = lcd_frame[r][c];
+      }
+   }
+   if(n != 0) lcd_dma_start(n);
+}
@@ -0,0 +1,186 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file pit_tick.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      pit_tick.cpp                                         --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   The timer0() tick from PIT channel PIT_CH_TICK.
+
+   The mbed Ticker reached timer0() through the us_ticker event queue: an
+   LPTMR interrupt, a search of the queue, the callback, and the next
+   event programmed, several microseconds of every 100 us tick.  Here the
+   PIT reloads itself from LDVAL and PIT_IRQHandler calls timer0()
+   directly.
+
+   The PIT counts the bus clock down from LDVAL and reloads when it
+   passes 0, so at the top of the handler LDVAL - CVAL is the time since
+   the tick was due: the interrupt entry latency, including any time the
+   interrupt was masked or a handler ahead of it ran.  The handler also
+   times timer0() with cycle_stamp().  Both are kept in tick_stat, in core
+   clock cycles, for the TICK command.
+
+   LDVAL - CVAL only tells lateness within one period.  Code that masks
+   interrupts for longer than a tick, the flash commands (flashlog.cpp),
+   reports the stretch with pit_tick_masked(), with pit_tick_phase() read
+   at its start.  The PIT holds one pending tick, so of the periods that
+   ended in the stretch all but one are lost; they are counted as missed
+   and System_Timer_count is that much behind.
+
+   pit_tick_period() changes the period at run time.  Everything counted
+   in ticks (task periods, the software timers, SEC) stretches with it,
+   100 us is the period they are written for.
+
+   Nothing else in the firmware may use the mbed time API (Ticker, Timer,
+   wait), which on this target takes PIT channels 0 and 1 for its counter.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+#include "MKL25Z4.h"
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static struct tick_stat tick_stat;
+   static uint32_t pit_bus_per_us = 0;   // bus clock cycles per microsecond
+   static UCHAR pit_core_per_bus = 1;    // core clocks per bus clock
+
+/*****************************************************************************/
+/// \fn void pit_tick_init(uint16_t us)
+/// @brief starts the PIT tick, timer0() runs every us microseconds from now
+/*****************************************************************************/
+void pit_tick_init(uint16_t us)
+{
+   pit_core_per_bus = ((SIM->CLKDIV1 & SIM_CLKDIV1_OUTDIV4_MASK) >>
+                       SIM_CLKDIV1_OUTDIV4_SHIFT) + 1;
+   pit_bus_per_us = SystemCoreClock/pit_core_per_bus/1000000;
+
+   SIM->SCGC6 |= SIM_SCGC6_PIT_MASK;        /* clock to the PIT */
+   PIT->MCR = PIT_MCR_FRZ_MASK;             /* enabled, stops in debug */
+   PIT->CHANNEL[PIT_CH_TICK].TCTRL = 0;
+   PIT->CHANNEL[PIT_CH_TICK].TFLG = PIT_TFLG_TIF_MASK;
+   NVIC_EnableIRQ(PIT_IRQn);
+   if(!pit_tick_period(us)) pit_tick_period(TICK_US_DEFAULT);
+}
+
+/*****************************************************************************/
+/// \fn UCHAR pit_tick_period(uint16_t us)
+/// @brief restarts the tick with a new period, and the statistics with it
+/// @param us TICK_US_MIN to TICK_US_MAX
+/// @return 1 if done, 0 for a period out of range
+/*****************************************************************************/
+UCHAR pit_tick_period(uint16_t us)
+{
+   if(us < TICK_US_MIN || us > TICK_US_MAX) return 0;
+
+   PIT->CHANNEL[PIT_CH_TICK].TCTRL = 0;     /* a new LDVAL loads on enable */
+   PIT->CHANNEL[PIT_CH_TICK].LDVAL = pit_bus_per_us*us - 1;
+   tick_stat.period_us = us;
+   pit_tick_reset();
+   PIT->CHANNEL[PIT_CH_TICK].TCTRL = PIT_TCTRL_TIE_MASK | PIT_TCTRL_TEN_MASK;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn void pit_tick_reset(void)
+/// @brief clears the latency and execution time statistics
+/*****************************************************************************/
+void pit_tick_reset(void)
+{
+   __disable_irq();
+   tick_stat.runs = 0;
+   tick_stat.lat_min = 0xFFFFFFFF;
+   tick_stat.lat_max = 0;
+   tick_stat.lat_avg = 0;
+   tick_stat.exec_max = 0;
+   tick_stat.exec_avg = 0;
+   tick_stat.mask_max = 0;
+   tick_stat.missed = 0;
+   __enable_irq();
+}
+
+/*****************************************************************************/
+/// \fn const struct tick_stat *pit_tick_stat(void)
+/// @return the tick period and timing statistics
+/*****************************************************************************/
+const struct tick_stat *pit_tick_stat(void)
+{
+   return &tick_stat;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t pit_tick_phase(void)
+/// @brief call with interrupts masked, at the start of the stretch
+/// @return core clock cycles since the tick before the one pending, so a
+/// tick due but not yet run counts a whole period
+/*****************************************************************************/
+uint32_t pit_tick_phase(void)
+{
+   uint32_t phase = (PIT->CHANNEL[PIT_CH_TICK].LDVAL -
+                     PIT->CHANNEL[PIT_CH_TICK].CVAL)*pit_core_per_bus;
+   if(PIT->CHANNEL[PIT_CH_TICK].TFLG & PIT_TFLG_TIF_MASK)
+      phase += (PIT->CHANNEL[PIT_CH_TICK].LDVAL + 1)*pit_core_per_bus;
+   return phase;
+}
+
+/*****************************************************************************/
+/// \fn void pit_tick_masked(uint32_t phase, uint32_t cycles)
+/// @brief counts the ticks lost while interrupts were masked, call before
+/// they are unmasked
+/// @param phase pit_tick_phase() at the start
+/// @param cycles core clock cycles they were masked
+/*****************************************************************************/
+void pit_tick_masked(uint32_t phase, uint32_t cycles)
+{
+   uint32_t due = (phase + cycles) /
+                  ((PIT->CHANNEL[PIT_CH_TICK].LDVAL + 1)*pit_core_per_bus);
+   if(cycles > tick_stat.mask_max) tick_stat.mask_max = cycles;
+   if(due > 1) tick_stat.missed += due - 1;
+}
+
+/*****************************************************************************/
+/// \fn void PIT_IRQHandler(void)
+/// @brief the tick: measures how late it was, runs timer0() and times it
+/*****************************************************************************/
+extern "C" void PIT_IRQHandler(void)
+{
+   uint32_t start = cycle_stamp();
+   uint32_t lat, exec;
+
+   lat = (PIT->CHANNEL[PIT_CH_TICK].LDVAL - PIT->CHANNEL[PIT_CH_TICK].CVAL)*
+         pit_core_per_bus;
+   PIT->CHANNEL[PIT_CH_TICK].TFLG = PIT_TFLG_TIF_MASK;   /* write 1 to clear */
+   TRACE(TR_TICK, lat > 0xFFFF ? 0xFFFF : lat);
+
+   timer0();
+
+   exec = cycles_since(start);
+   TRACE(TR_TICK_END, exec > 0xFFFF ? 0xFFFF : exec);
+   tick_stat.runs++;
+   if(lat < tick_stat.lat_min) tick_stat.lat_min = lat;
+   if(lat > tick_stat.lat_max) tick_stat.lat_max = lat;
+   if(exec > tick_stat.exec_max) tick_stat.exec_max = exec;
+   // running averages over about 16 ticks, no divide
+   tick_stat.lat_avg = tick_stat.lat_avg + ((int32_t)(lat - tick_stat.lat_avg) >> 4);
+   tick_stat.exec_avg = tick_stat.exec_avg + ((int32_t)(exec - tick_stat.exec_avg) >> 4);
+}
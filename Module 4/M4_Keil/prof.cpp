@@ -0,0 +1,118 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file prof.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      prof.cpp                                             --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Run time statistics for the stages of the super loop.
+
+   PROF_BEGIN(stage) and PROF_END(stage) bracket a stage in the task code.
+   Each pass is timed in core clock cycles with cycle_stamp() and added to
+   the stage's count, min, max, sum and histogram.  The histogram bins are
+   powers of 4 starting at 64 cycles:
+
+      bin   0     1      2      3      4       5       6        7
+      <    64   256   1024   4096   16384   65536  262144   and above
+
+   (64 cycles is 1.3 us and 262144 is 5.5 ms at 48 MHz).  Bin counts stop
+   at 0xFFFF.
+
+   The stages are not reentrant and only run from the loop, so no locking
+   is needed.  Without PROF_ENABLE in shared.h the macros are empty and
+   nothing is timed.  The statistics are printed by prof_report_poll() in
+   monitor.c after a 'P' command.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static struct prof_stat prof_table[PROF_STAGES];
+   static uint32_t prof_start[PROF_STAGES];  // cycle_stamp() at PROF_BEGIN
+
+   static const char * const prof_names[PROF_STAGES] =
+   {
+      "readFREQ", "flow", "serial", "UART_msg", "monitor", "LCD"
+   };
+
+/*****************************************************************************/
+/// \fn void prof_reset(void)
+/// @brief clears the statistics of every stage, call once before the
+/// stages run
+/*****************************************************************************/
+void prof_reset(void)
+{
+   UCHAR i, b;
+   for(i=0;i<PROF_STAGES;i++)
+   {
+      prof_table[i].name = prof_names[i];
+      prof_table[i].count = 0;
+      prof_table[i].min = 0xFFFFFFFF;
+      prof_table[i].max = 0;
+      prof_table[i].sum = 0;
+      for(b=0;b<PROF_HIST_BINS;b++) prof_table[i].hist[b] = 0;
+   }
+}
+
+/*****************************************************************************/
+/// \fn void prof_begin(UCHAR stage)
+/// @brief marks the entry of a stage, use PROF_BEGIN()
+/*****************************************************************************/
+void prof_begin(UCHAR stage)
+{
+   prof_start[stage] = cycle_stamp();
+}
+
+/*****************************************************************************/
+/// \fn void prof_end(UCHAR stage)
+/// @brief marks the exit of a stage and adds the pass to its statistics,
+/// use PROF_END()
+/*****************************************************************************/
+void prof_end(UCHAR stage)
+{
+   uint32_t cycles = cycles_since(prof_start[stage]);
+   struct prof_stat *p = &prof_table[stage];
+   uint32_t c;
+   UCHAR b;
+
+   p->count++;
+   p->sum += cycles;
+   if(cycles < p->min) p->min = cycles;
+   if(cycles > p->max) p->max = cycles;
+
+   // bin = log4(cycles/64), shifts only, there is no CLZ on the M0+
+   for(b=0, c=cycles>>6; c != 0 && b < PROF_HIST_BINS-1; b++) c >>= 2;
+   if(p->hist[b] != 0xFFFF) p->hist[b]++;
+}
+
+/*****************************************************************************/
+/// \fn const struct prof_stat *prof_stat_get(UCHAR stage)
+/// @return the statistics of a stage, NULL past the last one
+/*****************************************************************************/
+const struct prof_stat *prof_stat_get(UCHAR stage)
+{
+   if(stage >= PROF_STAGES) return NULL;
+   return &prof_table[stage];
+}
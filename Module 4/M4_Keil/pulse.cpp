@@ -0,0 +1,325 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file pulse.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      pulse.cpp                                            --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Scaled pulse output for external totalizers: K pulses per 1000
+   gallons (pulse_k()), a square wave on PTD0 from TPM0 channel 0 in edge
+   aligned PWM, a rising edge at every counter overflow.  TPM0 makes
+   every pulse; the CPU only changes the period, from task_flow after
+   each Flow.
+
+   A period is a whole number of TPM0 counts, so it cannot match the
+   rate Flow asks for.  pulse_update() keeps the pulses owed, Flow * K
+   integrated over the time between updates (SysTick), against the
+   pulses TPM0 has been set to put out, in pulse_lag, in 1/PULSE_UNIT of
+   a pulse.  When Flow changes the two periods either side of the rate
+   are worked out, then each update picks the short one while the output
+   is behind and the long one while it is ahead.  The lag stays within
+   what one update at the two periods differs by, so over a long run the
+   pulses put out are the integrated flow, to the pulse.
+
+   A new MOD (and CnV for half duty) is taken at the next overflow, so
+   the counts left in the period under way go at the old rate; the lag
+   is corrected for them, and a write too close to the overflow is left
+   to the next update.  The overflow flag tells when it was taken.  A
+   prescale change stops the counter and starts it from 0, the part of
+   the pulse under way goes back onto the lag.
+
+   Below the slowest rate TPM0 makes (prescale 128, 5.7 Hz) the counter
+   runs at that rate while the output is behind and stops while it is
+   ahead; stopped, it holds its count and the pulse goes on where it was.
+   Above PULSE_HZ_MAX the rate is held at PULSE_HZ_MAX and the update
+   counted in overrange, the pulses over it are not owed.
+
+   The mbed PwmOut sets the duty from the CPU and its period in whole
+   microseconds, so TPM0 is set up here directly.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+#include "MKL25Z4.h"
+
+#define PULSE_CH           0       /* TPM0_CH0, PTD0 */
+#define PULSE_PIN_MUX      4       /* PTD0 ALT4 */
+#define PULSE_COUNTS_MAX   65536   /* counts per period, MOD 0xFFFF */
+#define PULSE_PS_MAX       7       /* prescale 128 */
+#define PULSE_GUARD        256     /* counts before an overflow in which
+                                      a MOD write waits for the next Flow */
+#define PULSE_FK_MAX ((uint64_t)PULSE_HZ_MAX*6000*1000)
+#define PULSE_T_MAX        (1UL << 27)  /* clocks owed for one Flow, 2.8 s */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static struct pulse_stat pulse_stat;
+   static uint64_t pulse_fk;             // owed per TPM clock, Flow * K
+   static uint64_t pulse_r_hi;           // per clock at MOD pulse_stat.mod
+   static uint64_t pulse_r_lo;           //   one more, 0 to stop if gated
+   static uint64_t pulse_r;              // the rate being put out
+   static int64_t pulse_lag;             // owed less put out
+   static uint64_t pulse_acc;            // owed, under a whole pulse
+   static uint32_t pulse_flow;           // the rates are for
+   static UCHAR pulse_replan;            // K changed
+   static uint32_t pulse_stamp;          // cycle_stamp() at the last Flow
+   static uint32_t pulse_tick;           // System_Timer_count then
+
+   static uint16_t pulse_mod;            // TPM0 MOD in effect
+   static uint16_t pulse_mod_next;       // written, at the next overflow
+   static UCHAR pulse_pending;           // pulse_mod_next not taken yet
+   static UCHAR pulse_ps;                // TPM0 prescale
+   static UCHAR pulse_run;               // TPM0 counting
+
+/*****************************************************************************/
+/// \fn static uint64_t pulse_rate(uint32_t counts, UCHAR ps)
+/// @return pulses per TPM clock, in 1/PULSE_UNIT, at counts per period
+/*****************************************************************************/
+static uint64_t pulse_rate(uint32_t counts, UCHAR ps)
+{
+   return PULSE_UNIT/((uint64_t)counts << ps);
+}
+
+/*****************************************************************************/
+/// \fn static void pulse_plan(uint32_t flow)
+/// @brief the periods either side of the rate for flow, only when Flow or
+/// K changes
+/*****************************************************************************/
+static void pulse_plan(uint32_t flow)
+{
+   uint64_t clocks;
+   UCHAR ps = 0;
+
+   pulse_flow = flow;
+   pulse_fk = (uint64_t)flow*pulse_stat.k;
+   if(pulse_fk > PULSE_FK_MAX) pulse_fk = PULSE_FK_MAX;
+   pulse_stat.hz = pulse_fk/60000;
+   pulse_stat.gated = 0;
+   if(pulse_fk == 0)
+   {
+      pulse_r_hi = pulse_r_lo = 0;
+      return;
+   }
+   clocks = PULSE_UNIT/pulse_fk;                 // per pulse, 4800 or more
+   while(ps < PULSE_PS_MAX && (clocks >> ps) >= PULSE_COUNTS_MAX) ps++;
+   pulse_stat.ps = ps;
+   if((clocks >> ps) >= PULSE_COUNTS_MAX)
+   {                                /* slower than TPM0 goes, run part time */
+      pulse_stat.gated = 1;
+      pulse_stat.mod = PULSE_COUNTS_MAX - 1;
+      pulse_r_hi = pulse_rate(PULSE_COUNTS_MAX, ps);
+      pulse_r_lo = 0;
+      return;
+   }
+   pulse_stat.mod = (clocks >> ps) - 1;          // fast enough, or over
+   pulse_r_hi = pulse_rate(pulse_stat.mod + 1, ps);
+   pulse_r_lo = pulse_rate(pulse_stat.mod + 2, ps);
+}
+
+/*****************************************************************************/
+/// \fn static void pulse_stop(void)
+/// @brief stops TPM0 at once, the count held.  A MOD written but not taken
+/// never will be: the lag had it from the overflow on, it goes back
+/*****************************************************************************/
+static void pulse_stop(void)
+{
+   uint64_t left;
+
+   TPM0->SC = TPM_SC_PS(pulse_ps);
+   while(TPM0->SC & TPM_SC_CMOD_MASK);           /* taken at the TPM clock */
+   pulse_run = 0;
+   if(!pulse_pending) return;
+   if(TPM0->SC & TPM_SC_TOF_MASK)
+   {
+      pulse_mod = pulse_mod_next;
+      pulse_pending = 0;
+      return;
+   }
+   left = ((uint64_t)pulse_mod - TPM0->CNT + 1) << pulse_ps;
+   pulse_lag += (int64_t)(left*pulse_rate(pulse_mod + 1, pulse_ps)) -
+                (int64_t)(left*pulse_r);
+}
+
+/*****************************************************************************/
+/// \fn static void pulse_restart(uint16_t mod, UCHAR ps)
+/// @brief stops TPM0, drops the pulse under way onto the lag, and starts
+/// it from 0 at mod and ps
+/*****************************************************************************/
+static void pulse_restart(uint16_t mod, UCHAR ps)
+{
+   if(pulse_run) pulse_stop();
+   pulse_lag += (int64_t)(((uint64_t)TPM0->CNT << pulse_ps)*
+                          pulse_rate(pulse_mod + 1, pulse_ps));
+   TPM0->CNT = 0;                                /* any write clears it */
+   TPM0->SC = TPM_SC_TOF_MASK | TPM_SC_PS(ps);
+   TPM0->MOD = mod;                              /* at once while stopped */
+   TPM0->CONTROLS[PULSE_CH].CnV = ((uint32_t)mod + 1)/2;
+   TPM0->SC = TPM_SC_CMOD(1) | TPM_SC_PS(ps);
+   pulse_mod = mod;
+   pulse_ps = ps;
+   pulse_pending = 0;
+   pulse_run = 1;
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR pulse_write(uint64_t r, uint16_t mod)
+/// @brief a new MOD for the running counter, taken at the next overflow;
+/// the counts left to it still go at the old rate
+/// @return 1 if written, 0 if too close to the overflow
+/*****************************************************************************/
+static UCHAR pulse_write(uint64_t r, uint16_t mod)
+{
+   uint16_t c;
+   uint64_t left;
+
+   __disable_irq();
+   c = TPM0->CNT;
+   if(pulse_pending && (TPM0->SC & TPM_SC_TOF_MASK))
+   {
+      pulse_mod = pulse_mod_next;
+      pulse_pending = 0;
+   }
+   if(TPM0->CNT < c || pulse_mod - c < PULSE_GUARD)
+   {                                   /* an overflow went by, or will */
+      __enable_irq();
+      return 0;
+   }
+   TPM0->SC = TPM_SC_TOF_MASK | TPM_SC_CMOD(1) | TPM_SC_PS(pulse_ps);
+   TPM0->MOD = mod;
+   TPM0->CONTROLS[PULSE_CH].CnV = ((uint32_t)mod + 1)/2;
+   __enable_irq();
+   left = ((uint64_t)pulse_mod - c + 1) << pulse_ps;
+   pulse_lag -= (int64_t)(left*pulse_r) - (int64_t)(left*r);
+   pulse_mod_next = mod;
+   pulse_pending = 1;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn static void pulse_set(uint64_t r, uint16_t mod, UCHAR ps)
+/// @brief puts out rate r from here on, mod and ps for it (unless r is 0)
+/*****************************************************************************/
+static void pulse_set(uint64_t r, uint16_t mod, UCHAR ps)
+{
+   if(r == pulse_r) return;
+   if(r == 0) pulse_stop();
+   else if(!pulse_run && mod == pulse_mod && ps == pulse_ps && !pulse_pending)
+   {                                   /* on from the count it stopped at */
+      TPM0->SC = TPM_SC_CMOD(1) | TPM_SC_PS(ps);
+      pulse_run = 1;
+   }
+   else if(!pulse_run || ps != pulse_ps) pulse_restart(mod, ps);
+   else if(!pulse_write(r, mod))
+   {
+      pulse_stat.deferred++;
+      return;
+   }
+   pulse_r = r;
+}
+
+/*****************************************************************************/
+/// \fn void pulse_init(void)
+/// @brief TPM0 channel 0 to PTD0 as edge aligned PWM, stopped
+/*****************************************************************************/
+void pulse_init(void)
+{
+   pulse_stat.k = PULSE_K_DEFAULT;
+
+   SIM->SCGC5 |= SIM_SCGC5_PORTD_MASK;
+   PORTD->PCR[0] = PORT_PCR_MUX(PULSE_PIN_MUX);
+   SIM->SCGC6 |= SIM_SCGC6_TPM0_MASK;
+   SIM->SOPT2 |= SIM_SOPT2_PLLFLLSEL_MASK;
+   SIM->SOPT2 = (SIM->SOPT2 & ~SIM_SOPT2_TPMSRC_MASK) | SIM_SOPT2_TPMSRC(1);
+
+/* TPM0: high from each overflow to CnV, a rising edge a period */
+   TPM0->SC = 0;
+   TPM0->CNT = 0;
+   TPM0->MOD = PULSE_COUNTS_MAX - 1;
+   TPM0->CONTROLS[PULSE_CH].CnSC = TPM_CnSC_MSB_MASK | TPM_CnSC_ELSB_MASK;
+   TPM0->CONTROLS[PULSE_CH].CnV = PULSE_COUNTS_MAX/2;
+   pulse_mod = PULSE_COUNTS_MAX - 1;
+
+   pulse_stamp = cycle_stamp();
+   pulse_tick = System_Timer_count;
+   pulse_plan(0);
+}
+
+/*****************************************************************************/
+/// \fn void pulse_update(uint32_t flow)
+/// @brief owes the pulses of the Flow that held since the last update and
+/// sets the period for the new one; called from task_flow after every Flow
+/// @param flow GPM (x100)
+/*****************************************************************************/
+void pulse_update(uint32_t flow)
+{
+   uint32_t s = cycle_stamp();
+   uint32_t k = System_Timer_count;
+   uint64_t t = (s - pulse_stamp) & CYCLE_MASK;
+   uint64_t est = (uint64_t)(k - pulse_tick)*pit_tick_stat()->period_us*
+                  (SystemCoreClock/1000000);
+
+   while(est > t + CYCLE_MASK/2 && t < PULSE_T_MAX)
+      t += CYCLE_MASK + 1;                       // SysTick turned over
+   if(t > PULSE_T_MAX) t = PULSE_T_MAX;
+   pulse_stamp = s;
+   pulse_tick = k;
+
+/* the TPM counts the core clock, so t is in TPM clocks */
+   pulse_acc += t*pulse_fk;
+   pulse_lag += (int64_t)(t*pulse_fk) - (int64_t)(t*pulse_r);
+   pulse_stat.owed += pulse_acc/PULSE_UNIT;
+   pulse_acc %= PULSE_UNIT;
+
+   if(flow != pulse_flow || pulse_replan)
+   {
+      pulse_replan = 0;
+      pulse_plan(flow);
+   }
+   if((uint64_t)flow*pulse_stat.k > PULSE_FK_MAX) pulse_stat.overrange++;
+   if(pulse_lag > 0) pulse_set(pulse_r_hi, pulse_stat.mod, pulse_stat.ps);
+   else pulse_set(pulse_r_lo, pulse_stat.mod + 1, pulse_stat.ps);
+   pulse_stat.lag = pulse_lag/(int64_t)(PULSE_UNIT/1000);
+}
+
+/*****************************************************************************/
+/// \fn UCHAR pulse_k(uint32_t k)
+/// @brief sets the K-factor, pulses per 1000 gallons, 0 stops the output;
+/// the periods follow at the next Flow
+/// @return 1 if done, 0 above PULSE_K_MAX
+/*****************************************************************************/
+UCHAR pulse_k(uint32_t k)
+{
+   if(k > PULSE_K_MAX) return 0;
+   pulse_stat.k = k;
+   pulse_replan = 1;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn const struct pulse_stat *pulse_stat_get(void)
+/// @return the output settings and counts, for PO
+/*****************************************************************************/
+const struct pulse_stat *pulse_stat_get(void)
+{
+   return &pulse_stat;
+}
@@ -0,0 +1,303 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file sched.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      sched.cpp                                            --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Table driven cooperative scheduler for the super loop.
+
+   Each task is registered once with sched_add() with a period and a phase
+   in timer0 ticks (100 us) and a priority.  timer0() calls sched_tick()
+   every tick, which only counts down and marks tasks ready.  The loop
+   calls sched_dispatch(), which runs the ready tasks to completion, most
+   urgent first, and times each run with cycle_stamp().
+
+   A task released again before it was dispatched has overrun, the release
+   is counted in overruns and not queued.
+
+   Events: an interrupt with work for the loop posts a sched_event with
+   sched_post(), the DMA a full sample block, UART0 a received byte.
+   sched_dispatch() releases the tasks attached to the event with
+   sched_on_event().  A task added with period 0 runs on its event only, so
+   the loop no longer polls for the block or the byte.  An event is a byte
+   that the interrupt only sets and the loop only clears, like ready.
+
+   When no task is ready and no event is pending the loop calls
+   sched_idle(), which sleeps in WFI until the next interrupt, the timer0
+   tick at the latest.  The check and the WFI are done with interrupts
+   masked, so an interrupt in between cannot be slept through: WFI still
+   wakes on it, and it runs when the mask is lifted.  The time from waking
+   to the next sleep is summed as awake cycles, sched_awake_permille() is
+   the share of the last full second.  The sum is taken on every call, not
+   only at the sleep, so a busy stretch longer than the counter wraps in
+   is still counted.  SysTick is only read while the core runs, it is not
+   relied on in WFI.
+
+   cycle_stamp() reads SysTick, which free runs at the core clock with its
+   interrupt off (the tick comes from the PIT, pit_tick.cpp).
+   The counter is 24 bits, so intervals up to 349 ms can be measured.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static struct sched_task sched_table[SCHED_MAX_TASKS]; // sorted by prio
+   static UCHAR sched_count = 0;
+   static volatile UCHAR sched_events[SCHED_EVENTS]; // posted, not yet taken
+
+   static uint32_t awake_cycles = 0;   // since the window started
+   static uint32_t awake_stamp = 0;    // cycle_stamp() when the core woke
+   static uint32_t awake_window = 0;   // System_Timer_count at its start
+   static uint16_t awake_permille = 1000; // of the last full window
+
+/*****************************************************************************/
+/// \fn void sched_init(void)
+/// @brief empties the task table and starts the SysTick cycle counter
+/*****************************************************************************/
+void sched_init(void)
+{
+   sched_count = 0;
+   SysTick->CTRL = 0;
+   SysTick->LOAD = CYCLE_MASK;
+   SysTick->VAL = 0;
+   SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t cycle_stamp(void)
+/// @return core clock cycles, counting up, CYCLE_MASK wide
+/*****************************************************************************/
+uint32_t cycle_stamp(void)
+{
+   return CYCLE_MASK - SysTick->VAL;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t cycles_since(uint32_t start)
+/// @return core clock cycles from the cycle_stamp() start to now
+/*****************************************************************************/
+uint32_t cycles_since(uint32_t start)
+{
+   return (cycle_stamp() - start) & CYCLE_MASK;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR sched_add(task_fn fn, const char *name, uint16_t period,
+///                     uint16_t phase, UCHAR prio)
+/// @brief registers a task, call before the timer starts releasing them
+/// @param period ticks (100 us) between releases, 0 for a task released
+/// only by the event given to sched_on_event()
+/// @param phase ticks before the first release, spreads tasks with the
+/// same period over different ticks
+/// @param prio 0 is most urgent, equal priorities run in order of adding
+/// @return 1 if added, 0 if the table is full
+/*****************************************************************************/
+UCHAR sched_add(task_fn fn, const char *name, uint16_t period, uint16_t phase,
+                UCHAR prio)
+{
+   UCHAR i;
+   if(sched_count >= SCHED_MAX_TASKS) return 0;
+
+   i = sched_count;
+   while(i > 0 && sched_table[i-1].prio > prio)
+   {                              // insertion keeps the table in prio order
+      sched_table[i] = sched_table[i-1];
+      i--;
+   }
+   sched_table[i].fn = fn;
+   sched_table[i].name = name;
+   sched_table[i].period = period;
+   sched_table[i].countdown = phase + 1;
+   sched_table[i].prio = prio;
+   sched_table[i].event = SCHED_EV_NONE;
+   sched_table[i].ready = 0;
+   sched_table[i].overruns = 0;
+   sched_table[i].runs = 0;
+   sched_table[i].cycles_last = 0;
+   sched_table[i].cycles_max = 0;
+   sched_table[i].cycles_avg = 0;
+   sched_count++;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn void sched_tick(void)
+/// @brief called from timer0() every tick, releases the tasks that are due
+/*****************************************************************************/
+void sched_tick(void)
+{
+   UCHAR i;
+   struct sched_task *t = sched_table;
+   for(i=0;i<sched_count;i++,t++)
+   {
+      if(t->period == 0) continue;   // event only
+      if(--t->countdown == 0)
+      {
+         t->countdown = t->period;
+         if(t->ready) t->overruns++;   // last release not run yet
+         t->ready = 1;
+      }
+   }
+}
+
+/*****************************************************************************/
+/// \fn UCHAR sched_on_event(task_fn fn, UCHAR ev)
+/// @brief attaches a sched_event to a task added before, each post of it
+/// releases the task (again, a release while it is ready is not an overrun)
+/// @return 1 if done, 0 for an unknown task or event
+/*****************************************************************************/
+UCHAR sched_on_event(task_fn fn, UCHAR ev)
+{
+   UCHAR i;
+   if(ev >= SCHED_EVENTS) return 0;
+   for(i=0;i<sched_count;i++)
+   {
+      if(sched_table[i].fn == fn)
+      {
+         sched_table[i].event = ev;
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/*****************************************************************************/
+/// \fn void sched_post(UCHAR ev)
+/// @brief called from an interrupt, the loop has ev to handle
+/*****************************************************************************/
+void sched_post(UCHAR ev)
+{
+   sched_events[ev] = 1;
+}
+
+/*****************************************************************************/
+/// \fn static void sched_take_events(void)
+/// @brief releases the tasks of every event posted since the last call
+/*****************************************************************************/
+static void sched_take_events(void)
+{
+   UCHAR e, i;
+   for(e=0;e<SCHED_EVENTS;e++)
+   {
+      if(!sched_events[e]) continue;
+      sched_events[e] = 0;       // before the tasks run, a new post is kept
+      for(i=0;i<sched_count;i++)
+         if(sched_table[i].event == e) sched_table[i].ready = 1;
+   }
+}
+
+/*****************************************************************************/
+/// \fn void sched_dispatch(void)
+/// @brief releases the tasks of the posted events, runs every ready task,
+/// most urgent first, and returns when none is left.  The table is
+/// searched from the top after every task, so a task released meanwhile
+/// still goes before less urgent ones.
+///
+/// ready is a byte that the tick only sets and this only clears, so no
+/// interrupt lock is needed: a release that races the clear is counted as
+/// an overrun, which is what it is.
+/*****************************************************************************/
+void sched_dispatch(void)
+{
+   UCHAR i;
+   struct sched_task *t;
+   uint32_t start, cycles;
+
+   for(;;)
+   {
+      sched_take_events();
+      for(i=0, t=sched_table; i<sched_count; i++, t++)
+         if(t->ready) break;
+      if(i == sched_count) return;
+
+      t->ready = 0;
+      TRACE(TR_TASK, i);
+      start = cycle_stamp();
+      t->fn();
+      cycles = cycles_since(start);
+      TRACE(TR_TASK_END, i);
+
+      t->runs++;
+      t->cycles_last = cycles;
+      if(cycles > t->cycles_max) t->cycles_max = cycles;
+      // running average over about 16 runs, no divide
+      t->cycles_avg = t->cycles_avg + ((int32_t)(cycles - t->cycles_avg) >> 4);
+   }
+}
+
+/*****************************************************************************/
+/// \fn const struct sched_task *sched_task_get(UCHAR i)
+/// @return the i-th task in priority order, NULL past the last one
+/*****************************************************************************/
+const struct sched_task *sched_task_get(UCHAR i)
+{
+   if(i >= sched_count) return NULL;
+   return &sched_table[i];
+}
+
+/*****************************************************************************/
+/// \fn void sched_idle(void)
+/// @brief sleeps until the next interrupt when there is nothing to do,
+/// call after sched_dispatch()
+/*****************************************************************************/
+void sched_idle(void)
+{
+   UCHAR i, busy = 0;
+   uint32_t ticks, us;
+
+   __disable_irq();
+   for(i=0;i<SCHED_EVENTS;i++) busy |= sched_events[i];
+   for(i=0;i<sched_count;i++) busy |= sched_table[i].ready;
+   awake_cycles += cycles_since(awake_stamp);   // every call, SysTick wraps
+   awake_stamp = cycle_stamp();                 // in 349 ms
+   if(!busy)
+   {
+      TRACE(TR_SLEEP, 0);
+      __WFI();                   // wakes on an interrupt, even masked
+      awake_stamp = cycle_stamp();
+      TRACE(TR_WAKE, 0);
+   }
+   __enable_irq();               // the interrupt that woke us runs here
+
+   us = pit_tick_stat()->period_us;             // TICK may have changed it
+   ticks = System_Timer_count - awake_window;
+   if(ticks >= 1000000 / us)
+   {                             // once a second, the divides are rare
+      awake_window += ticks;
+      ticks = ticks * (SystemCoreClock / 1000000 * us) / 1000; // per permille
+      awake_permille = awake_cycles >= ticks*1000 ? 1000 : awake_cycles / ticks;
+      awake_cycles = 0;
+   }
+}
+
+/*****************************************************************************/
+/// \fn uint16_t sched_awake_permille(void)
+/// @return permille of the last full second the core was awake, not in WFI
+/*****************************************************************************/
+uint16_t sched_awake_permille(void)
+{
+   return awake_permille;
+}
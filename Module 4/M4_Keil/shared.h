@@ -48,17 +48,367 @@
 #define LED_FLASH_PERIOD .5   /* in seconds */
  
 #define CLOCK_FREQUENCY_MHZ 8
+
+#define ADC_SAMPLE_HZ 10000      /* flow sensor sample rate (100 usec.) */
+#define ADC_BLOCK_SIZE 256       /* samples per DMA block, 25.6 ms */
+#define ADC_HK_TEMP 0            /* housekeeping channel index, temperature */
+#define ADC_HK_VREFL 1           /* housekeeping channel index, VREFL */
+#define ADC_HK_COUNT 2
+
+#define SCHED_MAX_TASKS 8        /* cooperative scheduler table size */
+#define CYCLE_MASK 0x00FFFFFF    /* cycle_stamp() is 24 bits (SysTick) */
+#define PROF_ENABLE              /* time the loop stages, see prof.cpp */
+#define PROF_HIST_BINS 8         /* histogram bins per stage, powers of 4 */
+#define TRACE_ENABLE             /* event trace, see trace.cpp */
+#define TRACE_LOOP_SIZE 128      /* records in the loop ring, a power of 2 */
+#define TRACE_IRQ_SIZE 256       /* records in the interrupt ring, the same */
+#define TRACE_RING_LOOP 0        /* trace rings, one per execution level */
+#define TRACE_RING_IRQ 1
+#define TRACE_RINGS 2
+
+/* DMA channel assignments */
+#define DMA_CH_ADC 0             /* ADC0 flow samples, adc_dma.cpp */
+#define DMA_CH_AOUT 1            /* DAC0 4-20 mA codes, aout.cpp; PIT
+                                    channel n triggers DMA channel n */
+#define DMA_CH_LCD 2             /* SPI0 transmit to the LCD, lcd.cpp */
+
+/* PIT channel assignments */
+#define PIT_CH_TICK 0            /* timer0() tick, pit_tick.cpp */
+#define PIT_CH_AOUT 1            /* DMA_CH_AOUT trigger, aout.cpp */
+#define TICK_US_DEFAULT 100      /* tick period, SEC ticks per second */
+#define TICK_US_MIN 50           /* pit_tick_period() range */
+#define TICK_US_MAX 1000
+
+/* TPM assignments, all clocked at TPM_CLOCK_HZ */
+#define TPM_CLOCK_HZ 48000000    /* MCGPLLCLK/2, the core clock as well */
+                                 /* TPM1: ADC0 trigger, adc_dma.cpp */
+                                 /* TPM0: pulse output, pulse.cpp */
+#define SWT_LEVELS 4             /* software timer wheel, swtimer.cpp */
+#define SWT_SLOT_BITS 5          /* 32 slots a level, 2^20 ticks in all */
+#define SWT_POOL_SIZE 8          /* timers for swt_alloc() */
+
+#define LCD_REFRESH_HZ 5         /* display refreshes per second */
+
+/* 4-20 mA output, aout.cpp; currents in uA */
+#define AOUT_UPDATE_HZ 1000      /* DAC0 updates a second during a ramp */
+#define AOUT_RAMP_SIZE 32        /* updates in a ramp, over a flow update */
+#define AOUT_FULL_UA 24000       /* at DAC code 4095, the V to I stage */
+#define AOUT_ZERO_UA 4000        /* at the low end of the range */
+#define AOUT_SPAN_UA 16000       /*   to 20 mA at the high end */
+#define AOUT_SAT_LO_UA 3800      /* NAMUR NE 43 measurement limits */
+#define AOUT_SAT_HI_UA 20500
+#define AOUT_ALARM_LO_UA 3600    /* a fault current is at most this, */
+#define AOUT_ALARM_HI_UA 21000   /*   or at least this */
+#define AOUT_STALE_TICKS (SEC/2) /* no Flow for this long is a fault */
+#define AOUT_FLOW_LO_DEFAULT 0   /* GPM (x100) at 4 mA */
+#define AOUT_FLOW_HI_DEFAULT 200000 /* GPM (x100) at 20 mA */
+#define AOUT_FLOW_MAX 1000000    /* GPM, the most AOR takes */
+#define AOUT_SLEW_DEFAULT 100    /* mA per second */
+
+/* scaled pulse output, pulse.cpp; K-factor in pulses per 1000 gallons */
+#define PULSE_K_DEFAULT 10000    /* 10 pulses per gallon */
+#define PULSE_K_MAX 100000000
+#define PULSE_HZ_MAX 10000       /* the most a totalizer input takes */
+#define PULSE_UNIT (6000ULL*1000*TPM_CLOCK_HZ) /* owed per TPM clock is
+                                    Flow (x100 GPM) * K in 1/PULSE_UNIT
+                                    pulses */
+#define SIN_Q15_SIZE 256         /* sine table entries per turn */
+#define FREQ_ENGINE_NONE 0xFF    /* no engine, freq_engine_compared() */
+#define CMD_ARGS_MAX 3           /* numbers after a monitor command */
+#define CMD_NONE 0xFF            /* no command, Monitor.cpp */
+#define CMD_MODES_ALL 0xFF       /* monitor_cmd modes, any display mode */
+#define CMD_NOT_QUIET (CMD_MODES_ALL & ~(1 << QUIET))
+#define FMT_DEC_MAX 11           /* fmt_dec() text, 10 digits and a point */
+#define FMT_DECI_MAX 9           /* fmt_dec() decimals, "0." and 9 fit */
+
+/* BINARY mode status record, telemetry.cpp; byte offsets, little endian */
+#define TEL_TYPE_STATUS 0x01     /* record type, byte 0 */
+#define TEL_OFS_TYPE    0        /* 8 bits, TEL_TYPE_ */
+#define TEL_OFS_SEQ     1        /* 8 bits, counts records, gaps are skips */
+#define TEL_OFS_TIME    2        /* 32 bits, System_Timer_count, ticks */
+#define TEL_OFS_FLOW    6        /* 32 bits, GPM (x100) */
+#define TEL_OFS_FREQ    10       /* 32 bits, Hz (x100) */
+#define TEL_OFS_TEMP    14       /* 32 bits, C (x100) */
+#define TEL_OFS_RE      18       /* 32 bits */
+#define TEL_OFS_ST      22       /* 16 bits, St (x10,000) running average */
+#define TEL_OFS_FLAGS   24       /* 8 bits, TEL_FLAG_ */
+#define TEL_OFS_ENGINE  25       /* 8 bits, frequency engine in use */
+#define TEL_OFS_TICK_US 26       /* 16 bits, the tick period in us */
+#define TEL_OFS_CRC     28       /* 16 bits, CRC-16/CCITT of bytes 0..27 */
+#define TEL_REC_SIZE    30
+#define TEL_FRAME_MAX   (TEL_REC_SIZE + 2)  /* COBS code byte and 0 delimiter */
+#define TEL_FLAG_FREQ   0x01     /* the frequency engine has a reading */
+#define TEL_FLAG_ADC_OVR 0x02    /* ADC blocks lost since the last record */
+#define TEL_FLAG_SKIP   0x04     /* records skipped since the last, no room */
+#define TEL_FLAG_TX_DROP 0x08    /* text bytes dropped since the last record */
+#define TEL_EVERY_MAX   9        /* BIN<n>, a record every n flow updates */
+/* LOGD read back frame, flashlog.cpp; framed as the status record, with
+   the CRC after the data */
+#define TEL_TYPE_LOG    0x02     /* record type, byte 0 */
+#define TEL_LOG_OFS_SEQ 1        /* 32 bits, sequence number of the sector */
+#define TEL_LOG_OFS_POS 5        /* 16 bits, byte offset in the sector,
+                                    TEL_LOG_END in the last frame */
+#define TEL_LOG_OFS_DATA 7       /* the sector bytes from there on */
+#define TEL_LOG_DATA_MAX 64
+#define TEL_LOG_END     0xFFFF
+#define TEL_LOG_FRAME_MAX (TEL_LOG_OFS_DATA + TEL_LOG_DATA_MAX + 4)
+/* TRD trace read back frame, trace.cpp; framed as the LOGD frame */
+#define TEL_TYPE_TRACE  0x03     /* record type, byte 0 */
+#define TEL_TRACE_OFS_RING 1     /* 8 bits, TRACE_RING_, TEL_TRACE_HEAD or
+                                    TEL_TRACE_END */
+#define TEL_TRACE_OFS_INDEX 2    /* 16 bits, number of the first record */
+#define TEL_TRACE_OFS_DATA 4     /* struct trace_rec from there on */
+#define TEL_TRACE_RECS  8        /* records a frame at most */
+#define TRACE_REC_SIZE  8        /* struct trace_rec, little endian */
+#define TEL_TRACE_HEAD  0xFF     /* the first frame, no records: */
+#define TEL_TRACE_OFS_CLOCK 2    /*   32 bits, SystemCoreClock */
+#define TEL_TRACE_OFS_TICK_US 6  /*   16 bits, the tick period */
+#define TEL_TRACE_OFS_NOW 8      /*   16 bits, System_Timer_count */
+#define TEL_TRACE_HEAD_SIZE 10
+#define TEL_TRACE_END   0xFE     /* the last frame, no records */
+
+/* flash data logger, flashlog.cpp.  The top FLOG_SECTORS of program flash,
+   left out of the image by the scatter file.  A sector starts with a
+   header; chunks follow, each a length byte (0xFF where none was written)
+   and that many bytes of records, padded to a longword.  The first record
+   of a chunk holds its values, the rest the change from the one before:
+      time   0.1 s since the boot, varint
+      Flow   GPM (x100), varint, zigzag varint as a change
+      freq   Hz (x100), the same
+      temp   C (x100), the same
+   A varint is 7 bits a byte, least significant first, 0x80 while more
+   follow; zigzag is (d << 1) ^ (d >> 31) */
+#define FLOG_BASE       0x1C000  /* byte address of the first sector */
+#define FLOG_SECTORS    16
+#define FLOG_SECTOR_SIZE 1024    /* the FTFA erase unit */
+#define FLOG_MAGIC      0x4C46   /* "FL", header bytes 0..1 */
+#define FLOG_OFS_BOOT   2        /* 16 bits, power ups, the first is 1 */
+#define FLOG_OFS_SEQ    4        /* 32 bits, sectors started, never reused */
+#define FLOG_HDR_SIZE   8
+#define FLOG_CHUNK_NONE 0xFF     /* length byte of flash not written */
+#define FLOG_EVERY_DEFAULT 5     /* seconds between records */
+#define FLOG_EVERY_MAX  3600
 #define CODE_VERSION "2.0.2 2018/10/04"   /*   YYYY/MM/DD  */
 #define COPYRIGHT "Copyright (c) University of Colorado" 
      
  //enum boolean { FALSE, TRUE };           /// \enum boolean  
- enum dmode {QUIET, NORMAL, DEBUG, VERSION}; 
+ enum dmode {QUIET, NORMAL, DEBUG, VERSION, BINARY}; 
  
  typedef unsigned char UCHAR;       
  typedef unsigned char bit;
  typedef unsigned int uint32_t;
  typedef unsigned short uint16_t;
  
+ typedef void (*task_fn)(void);      /// \typedef scheduled task entry point
+ 
+ /// \enum sched_event posted by the interrupts with sched_post(), each one
+ /// releases the tasks attached to it with sched_on_event()
+ enum sched_event {EV_ADC_BLOCK, EV_UART_RX, EV_TIMER, SCHED_EVENTS};
+ #define SCHED_EV_NONE 0xFF       /* sched_task event, released by time only */
+
+ /// \struct sched_task one entry of the scheduler table, see sched.cpp
+ struct sched_task
+ {
+    task_fn fn;
+    const char *name;
+    uint16_t period;            // ticks (100 usec.) between releases, 0 for
+                                // a task released by its event only
+    uint16_t countdown;         // ticks to the next release
+    UCHAR prio;                 // 0 is most urgent
+    UCHAR event;                // sched_event that also releases it
+    volatile UCHAR ready;       // released, waiting for dispatch
+    volatile uint16_t overruns; // released again before it ran
+    uint32_t runs;
+    uint32_t cycles_last;       // core clock cycles of the last run
+    uint32_t cycles_max;
+    uint32_t cycles_avg;
+ };
+
+ /// \enum prof_stage the profiled stages of the loop, see prof.cpp
+ enum prof_stage {PROF_FREQ, PROF_FLOW, PROF_SERIAL, PROF_UART_MSG,
+                  PROF_MONITOR, PROF_LCD, PROF_STAGES};
+
+ /// \struct prof_stat run time statistics of one stage, in core clock cycles
+ struct prof_stat
+ {
+    const char *name;
+    uint32_t count;             // passes timed
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;               // for the mean, sum/count
+    uint16_t hist[PROF_HIST_BINS]; // passes per bin, saturating
+ };
+
+ typedef void (*swt_fn)(void *);     /// \typedef software timer callback
+
+ /// \enum swt_state of a struct swtimer
+ enum swt_state {SWT_IDLE, SWT_ARMED, SWT_FIRED};
+
+ /// \struct swtimer one software timer, see swtimer.cpp.  The memory is the
+ /// user's, or from swt_alloc(), the fields belong to swtimer.cpp
+ struct swtimer
+ {
+    struct swtimer *next;       // in a wheel slot or the fired list
+    struct swtimer **pprev;     // what points to this one, O(1) unlink
+    uint32_t expires;           // swt_ticks() when it is due
+    uint32_t period;            // ticks to the next expiry, 0 for one shot
+    swt_fn fn;                  // called from the loop, or NULL
+    void *arg;
+    volatile UCHAR *flag;       // set in the interrupt when fn is NULL
+    volatile UCHAR state;       // swt_state
+ };
+
+ /// \struct tick_stat timer0() tick timing, in core clock cycles, see
+ /// pit_tick.cpp
+ struct tick_stat
+ {
+    uint16_t period_us;
+    uint32_t runs;
+    uint32_t lat_min;           // tick due to PIT_IRQHandler entry
+    uint32_t lat_max;
+    uint32_t lat_avg;
+    uint32_t exec_max;          // in PIT_IRQHandler, timer0() included
+    uint32_t exec_avg;
+    uint32_t mask_max;          // longest pit_tick_masked() stretch
+    uint32_t missed;            // ticks lost in them, the PIT keeps only one
+ };
+
+ /// \enum trace_event trace record ids.  The high nibble is the class, a
+ /// bit of trace_mask each; the arg of each is given beside it
+ enum trace_event
+ {
+    TR_TICK = 0x00,             // PIT tick, latency in core clock cycles
+    TR_TICK_END,                // timer0() done, cycles in PIT_IRQHandler
+    TR_UART_RX = 0x10,          // byte received
+    TR_UART_TX,                 // byte sent from tx_buf
+    TR_UART_LINE,               // command line taken by the loop, length
+    TR_ADC_BLOCK = 0x20,        // sample block full, 1 if it was dropped
+    TR_ADC_HK,                  // housekeeping conversion, ADC_HK_ index
+    TR_TASK = 0x30,             // task started, index in sched_task_get()
+    TR_TASK_END,                // task returned, the same index
+    TR_STAGE = 0x40,            // PROF_BEGIN, prof_stage
+    TR_STAGE_END,               // PROF_END, prof_stage
+    TR_SLEEP = 0x50,            // WFI in sched_idle()
+    TR_WAKE,
+    TR_FLASH = 0x60,            // FTFA command launched, its code
+    TR_FLASH_END,               // done or suspended, FSTAT
+    TR_MARK = 0x70              // free for debugging, where BugMe was toggled
+ };
+
+ /// \struct trace_rec one trace event, see trace.cpp
+ struct trace_rec
+ {
+    uint32_t stamp;             // cycle_stamp() in bits 0..23, trace_event
+                                // in 24..31
+    uint16_t tick;              // System_Timer_count, low 16 bits
+    uint16_t arg;
+ };
+
+ /// \struct aout_stat the 4-20 mA output, see aout.cpp
+ struct aout_stat
+ {
+    uint32_t flow_lo;           // GPM (x100) at 4 mA
+    uint32_t flow_hi;           // GPM (x100) at 20 mA
+    uint16_t slew;              // mA per second, 0 for no limit
+    uint16_t alarm_ua;          // on a fault, 0 holds the output
+    uint16_t target_ua;         // for the last Flow
+    uint16_t out_ua;            // from the DAC code now
+    uint16_t code;
+    UCHAR fault;                // no Flow for AOUT_STALE_TICKS
+    uint32_t ramps;             // DMA ramps started
+    uint32_t faults;
+ };
+
+ /// \struct pulse_stat the scaled pulse output, see pulse.cpp
+ struct pulse_stat
+ {
+    uint32_t k;                 // pulses per 1000 gallons, 0 for off
+    uint32_t hz;                // (x100) for the last Flow
+    UCHAR ps;                   // TPM0 prescale, 2^ps
+    uint16_t mod;               // TPM0 MOD, or one more to fall behind
+    UCHAR gated;                // slower than TPM0 can, run and stopped
+    uint32_t owed;              // whole pulses of the integrated Flow
+    int32_t lag;                // owed less put out, pulses (x1000)
+    uint32_t overrange;         // Flow updates above PULSE_HZ_MAX
+    uint32_t deferred;          // period changes left to the next Flow
+ };
+
+ /// \struct flog_stat the flash data logger, see flashlog.cpp
+ struct flog_stat
+ {
+    uint16_t every;             // seconds between records
+    uint16_t boot;              // power ups, from the sector headers
+    UCHAR sectors;              // holding records, of FLOG_SECTORS
+    UCHAR erasing;              // sectors waiting for or in erase
+    uint16_t staged;            // records in RAM, not yet in flash
+    uint32_t records;           // since the boot, staged ones included
+    uint16_t drops;             // records lost, the stage was full
+    uint16_t errors;            // flash commands that failed
+    uint32_t erases;
+    uint16_t slices_max;        // most erase slices one erase took
+    uint16_t erase_timeouts;    // erases finished unsuspended, too many slices
+    uint32_t stall_max;         // core clock cycles with interrupts masked
+ };
+
+ /// \struct freq_engine a frequency estimator behind readFREQ(), see
+ /// freq_engine.cpp
+ struct freq_engine
+ {
+    const char *name;
+    void (*init)(void);         // start, from the last published frequency
+    UCHAR (*block)(const uint16_t *, uint16_t); // 1 if a new frequency
+    uint32_t (*frequency)(void);    // latest, Hz (x100), 0 if no signal
+ };
+
+ /// \struct fft_peak_vars settings and cost of the spectral peak engine,
+ /// see fft_peak.cpp
+ struct fft_peak_vars
+ {
+    UCHAR log2n;                // frame of 2^log2n samples
+    UCHAR every;                // ADC blocks per estimate
+    uint32_t estimates;
+    uint32_t cycles_last;       // core clock cycles of the last estimate
+    uint32_t cycles_max;
+ };
+
+ typedef UCHAR (*cmd_fn)(UCHAR argc, const uint32_t *argv);
+ 
+ /// \struct monitor_cmd one monitor command, see monitor_cmds[] in
+ /// Monitor.cpp
+ struct monitor_cmd
+ {
+    const char *name;           // upper case, typed in either case
+    UCHAR min_args;             // numbers after the name
+    UCHAR max_args;
+    UCHAR modes;                // display modes it works in, 1 << dmode
+    cmd_fn handler;             // returns 0 for a bad argument
+    const char *help;           // line of the command list
+ };
+
+ /// \struct flow_params settings of the flow engine, flow_engine_pipe() and
+ /// flow_engine_avg()
+ struct flow_params
+ {
+    uint16_t pid;               // pipe inner diameter (0.001 in)
+    uint16_t d;                 // bluff body width (0.001 in)
+    UCHAR st_shift;             // St average over 2^st_shift updates
+ };
+
+ /// \struct flow_vars results of the last flow_engine_update(), units as in
+ /// flow_engine.cpp
+ struct flow_vars
+ {
+    uint32_t viscosity;         // (x1,000,000)
+    uint32_t density;           // kg/m^3
+    uint32_t St;                // (x10,000) at the last Re
+    uint32_t St_const;          // (x10,000) running average of St
+    uint32_t velocity;          // in/s (x100)
+    uint32_t Re;
+    uint32_t Flow;              // GPM (x100)
+    uint32_t cycles_last;       // core clock cycles of the last update
+    uint32_t cycles_max;
+ };
+ 
 #ifdef __cplusplus 
 extern "C" {
 #endif
@@ -68,16 +418,22 @@ extern "C" {
 /************************************************************************/
  
  extern unsigned char Error_status;          // Variable for debugging use
- extern UCHAR  display_timer;  // \var 1 second software timer for display   
- extern UCHAR  display_flag;   // flag between timer interrupt and monitor.c, 
+ extern volatile UCHAR display_flag; // set by a timer every report period, 
                         // like a binary semaphore
- extern UCHAR tx_in_progress;                        
- extern UCHAR *rx_in_ptr; /* pointer to the receive in data */
+ extern volatile uint32_t System_Timer_count;  // timer0 ticks (100 us) since start
+ extern volatile UCHAR tx_in_progress;                        
+ extern UCHAR * volatile rx_in_ptr; /* pointer to the receive in data, moved
+                                      by UART0_IRQHandler */
  extern UCHAR *rx_out_ptr; /* pointer to the receive out data*/
- extern UCHAR *tx_in_ptr; /* pointer to the transmit in data*/
- extern UCHAR *tx_out_ptr; /*pointer to the transmit out */                       
-#define RX_BUF_SIZE 10            /* size of receive buffer in bytes */
-#define TX_BUF_SIZE 40           /* size of transmit buffer in bytes */
+ extern UCHAR * volatile tx_in_ptr; /* pointer to the transmit in data*/
+ extern UCHAR * volatile tx_out_ptr; /*pointer to the transmit out, moved by
+                                       UART0_IRQHandler */                       
+ extern uint16_t tx_drop_count;  /* transmit bytes dropped, buffer full */
+#define RX_BUF_SIZE 64            /* size of receive (echo) buffer in bytes */
+#define RX_LINE_QUEUE 4           /* received command lines waiting */
+#ifndef TX_BUF_SIZE
+#define TX_BUF_SIZE 256          /* size of transmit buffer in bytes */
+#endif
                                                                     
 /******************************************************************************
 * Some variable definitions are done in the module main.c and are externed in 
@@ -89,16 +445,16 @@ extern "C" {
  
  UCHAR serial_flag = 0;
  
- UCHAR tx_in_progress; 
- UCHAR *rx_in_ptr; /* pointer to the receive in data */
+ volatile UCHAR tx_in_progress; 
+ UCHAR * volatile rx_in_ptr; /* pointer to the receive in data */
  UCHAR *rx_out_ptr; /* pointer to the receive out data*/
- UCHAR *tx_in_ptr; /* pointer to the transmit in data*/
- UCHAR *tx_out_ptr; /*pointer to the transmit out */        
+ UCHAR * volatile tx_in_ptr; /* pointer to the transmit in data*/
+ UCHAR * volatile tx_out_ptr; /*pointer to the transmit out */        
     
  UCHAR  rx_buf[RX_BUF_SIZE];      /* define the storage */
  UCHAR  tx_buf[TX_BUF_SIZE];      /* define the storage */
 
-#define MSG_BUF_SIZE 10
+#define MSG_BUF_SIZE 16
  UCHAR msg_buf[MSG_BUF_SIZE]; // define the storage for UART received messages
  UCHAR msg_buf_idx = 0;    // index into the received message buffer       
 
@@ -113,15 +469,6 @@ extern "C" {
 /*   Declarations     */
 /**********************/
 
-   extern volatile     UCHAR swtimer0;
-   extern volatile     UCHAR swtimer1;
-   extern volatile     UCHAR swtimer2;
-   extern volatile     UCHAR swtimer3; 
-   extern volatile     UCHAR swtimer4;    
-   extern volatile     UCHAR swtimer5;    
-   extern volatile     UCHAR swtimer6;    
-   extern volatile     UCHAR swtimer7;    
-  
   extern UCHAR serial_flag;
     
   extern enum dmode display_mode;
@@ -129,7 +476,7 @@ extern "C" {
   extern UCHAR  rx_buf[];      /* declare the storage */
   extern UCHAR  tx_buf[];      /* declare the storage */
 
-#define MSG_BUF_SIZE 10    
+#define MSG_BUF_SIZE 16    
   extern  UCHAR msg_buf[MSG_BUF_SIZE]; // declare the storage for UART received messages
   extern  UCHAR msg_buf_idx;         // index into the received message buffer
 
@@ -142,21 +489,160 @@ extern void monitor(void);  /* located in module monitor.c */
 extern void timer0(void);   /* located in module timer0.c */
 extern void serial(void);   /* located in module UART_poll.c */
 
-extern void UART_put(UCHAR);                 		/* located in module UART_poll.c */
+extern void UART_init(void);                 		/* located in module UART_poll.c */
+extern UCHAR UART_put(UCHAR);                		/* located in module UART_poll.c */
+extern uint16_t UART_tx_space(void);         		/* located in module UART_poll.c */
 extern UCHAR UART_get(void);                 		/* located in module UART_poll.c */
 extern UCHAR UART_input(void);               		/* located in module UART_poll.c */
+extern UCHAR UART_line_get(UCHAR *, UCHAR *); 		/* located in module UART_poll.c */
+extern volatile uint16_t rx_overrun_count;   		/* located in module UART_poll.c */
+extern volatile uint16_t rx_line_lost;       		/* located in module UART_poll.c */
 extern void UART_direct_msg_put(const char *); 	/* located in module UART_poll.c */
 extern void UART_direct_hex_int_put(uint32_t, uint8_t);
-//extern void UART_msg_put(const char *); 				/* located in module UART_poll.c */
+extern UCHAR UART_msg_put(const char *); 				/* located in module UART_poll.c */
+extern void UART_word_hex_put(uint32_t);     		/* located in module UART_poll.c */
+extern void UART_hex_int_put(uint32_t, uint8_t); 	/* located in module UART_poll.c */
+extern void UART_dec_put(uint32_t, UCHAR);   		/* located in module UART_poll.c */
 extern void UART_direct_hex_put(UCHAR);      		/* located in module UART_poll.c */
 extern void UART_direct_put(UCHAR);          		/* located in module UART_poll.c */
-//extern void UART_hex_put(UCHAR);             		/* located in module UART_poll.c */
+extern void UART_hex_put(UCHAR);             		/* located in module UART_poll.c */
+extern UCHAR hex_to_asc(UCHAR);              		/* located in module UART_poll.c */
 extern void UART_low_nibble_direct_put(UCHAR);      /* located in module UART_poll.c */
 extern void UART_direct_word_hex_put(uint32_t); /* located in module UART_poll.c */
 extern void chk_UART_msg(void);              /* located in module monitor.c */
 extern void UART_msg_process(void);          /* located in module monitors.c */
 extern void status_report(void);             /* located in module monitor.c */  
+extern void sched_report_poll(void);         /* located in module monitor.c */
+extern void freq_engine_report(void);        /* located in module monitor.c */
+extern void fft_report(void);                /* located in module monitor.c */
+extern void fmt_bench_report(void);          /* located in module monitor.c */
 extern void set_display_mode(void);          /* located in module monitor.c */
+extern void monitor_init(void);              /* located in module monitor.c */
+extern void help_report_poll(void);          /* located in module monitor.c */
+extern void adc_init(void);                  /* located in module adc_dma.cpp */
+extern void swt_init(void);                  /* located in module swtimer.cpp */
+extern void swt_setup(struct swtimer *, swt_fn, void *, volatile UCHAR *);
+                                             /* located in module swtimer.cpp */
+extern void swt_start(struct swtimer *, uint32_t, uint32_t);
+                                             /* located in module swtimer.cpp */
+extern void swt_stop(struct swtimer *);      /* located in module swtimer.cpp */
+extern UCHAR swt_active(const struct swtimer *); /* module swtimer.cpp */
+extern struct swtimer *swt_alloc(void);      /* located in module swtimer.cpp */
+extern void swt_free(struct swtimer *);      /* located in module swtimer.cpp */
+extern void swt_tick(void);                  /* located in module swtimer.cpp */
+extern void swt_run(void);                   /* located in module swtimer.cpp */
+extern uint32_t swt_ticks(void);             /* located in module swtimer.cpp */
+extern void pit_tick_init(uint16_t);         /* located in module pit_tick.cpp */
+extern UCHAR pit_tick_period(uint16_t);      /* located in module pit_tick.cpp */
+extern void pit_tick_reset(void);            /* located in module pit_tick.cpp */
+extern const struct tick_stat *pit_tick_stat(void); /* module pit_tick.cpp */
+extern uint32_t pit_tick_phase(void);        /* located in module pit_tick.cpp */
+extern void pit_tick_masked(uint32_t, uint32_t); /* module pit_tick.cpp */
+extern const uint16_t *adc_block_get(void);  /* located in module adc_dma.cpp */
+extern void adc_block_release(void);         /* located in module adc_dma.cpp */
+extern uint16_t adc_hk_read(UCHAR);          /* located in module adc_dma.cpp */
+extern volatile uint16_t adc_overrun;        /* located in module adc_dma.cpp */
+extern uint32_t lut_viscosity(uint32_t);     /* located in module flow_lut.cpp */
+extern uint32_t lut_density(uint32_t);       /* located in module flow_lut.cpp */
+extern uint32_t lut_strouhal(uint32_t);      /* located in module flow_lut.cpp */
+extern void flow_engine_init(uint32_t);      /* located in module flow_engine.cpp */
+extern uint32_t flow_engine_update(uint32_t, uint32_t);
+                                             /* located in module flow_engine.cpp */
+extern const struct flow_vars *flow_engine_vars(void); /* module flow_engine.cpp */
+extern UCHAR flow_engine_pipe(uint16_t, uint16_t); /* module flow_engine.cpp */
+extern UCHAR flow_engine_avg(UCHAR);         /* located in module flow_engine.cpp */
+extern const struct flow_params *flow_engine_params(void); /* flow_engine.cpp */
+extern void sched_init(void);                /* located in module sched.cpp */
+extern UCHAR sched_add(task_fn, const char *, uint16_t, uint16_t, UCHAR);
+                                             /* located in module sched.cpp */
+extern void sched_tick(void);                /* located in module sched.cpp */
+extern void sched_dispatch(void);            /* located in module sched.cpp */
+extern UCHAR sched_on_event(task_fn, UCHAR); /* located in module sched.cpp */
+extern void sched_post(UCHAR);               /* located in module sched.cpp */
+extern void sched_idle(void);                /* located in module sched.cpp */
+extern uint16_t sched_awake_permille(void);  /* located in module sched.cpp */
+extern const struct sched_task *sched_task_get(UCHAR); /* module sched.cpp */
+extern uint32_t cycle_stamp(void);           /* located in module sched.cpp */
+extern uint32_t cycles_since(uint32_t);      /* located in module sched.cpp */
+extern void prof_reset(void);                /* located in module prof.cpp */
+extern void prof_begin(UCHAR);               /* located in module prof.cpp */
+extern void prof_end(UCHAR);                 /* located in module prof.cpp */
+extern const struct prof_stat *prof_stat_get(UCHAR); /* module prof.cpp */
+extern void prof_report_start(void);         /* located in module monitor.c */
+extern void prof_report_poll(void);          /* located in module monitor.c */
+extern volatile UCHAR trace_mask;            /* located in module trace.cpp */
+extern void trace_put(UCHAR, uint16_t);      /* located in module trace.cpp */
+extern UCHAR trace_classes(void);            /* located in module trace.cpp */
+extern void trace_config(UCHAR);             /* located in module trace.cpp */
+extern uint32_t trace_count(UCHAR);          /* located in module trace.cpp */
+extern void trace_dump_start(void);          /* located in module trace.cpp */
+extern void trace_dump_poll(void);           /* located in module trace.cpp */
+#ifdef TRACE_ENABLE
+#define TRACE(id, arg) do { if(trace_mask & (1 << ((id) >> 4))) \
+                               trace_put((id), (arg)); } while(0)
+#else
+#define TRACE(id, arg)
+#endif
+#ifdef PROF_ENABLE
+#define PROF_BEGIN(stage) do { TRACE(TR_STAGE, stage); prof_begin(stage); } while(0)
+#define PROF_END(stage)   do { prof_end(stage); TRACE(TR_STAGE_END, stage); } while(0)
+#else
+#define PROF_BEGIN(stage) TRACE(TR_STAGE, stage)
+#define PROF_END(stage)   TRACE(TR_STAGE_END, stage)
+#endif
+extern void lcd_init(void);                  /* located in module lcd.cpp */
+extern void lcd_update(void);                /* located in module lcd.cpp */
+extern UCHAR lcd_idle(void);                 /* located in module lcd.cpp */
+extern uint16_t lcd_busy_count;              /* located in module lcd.cpp */
+extern uint32_t fmt_divu10(uint32_t, UCHAR *); /* located in module fmt.cpp */
+extern UCHAR fmt_dec(char *, uint32_t, UCHAR, UCHAR); /* module fmt.cpp */
+extern void tel_update(void);                /* located in module telemetry.cpp */
+extern UCHAR tel_config(UCHAR);              /* located in module telemetry.cpp */
+extern UCHAR tel_every(void);                /* located in module telemetry.cpp */
+extern uint16_t tel_skip_count;              /* located in module telemetry.cpp */
+extern UCHAR tel_frame_put(UCHAR *, UCHAR);  /* located in module telemetry.cpp */
+extern void flog_init(void);                 /* located in module flashlog.cpp */
+extern void flog_run(void);                  /* located in module flashlog.cpp */
+extern UCHAR flog_config(uint16_t);          /* located in module flashlog.cpp */
+extern void flog_clear(void);                /* located in module flashlog.cpp */
+extern void flog_dump_start(void);           /* located in module flashlog.cpp */
+extern void flog_dump_poll(void);            /* located in module flashlog.cpp */
+extern const struct flog_stat *flog_stat_get(void); /* module flashlog.cpp */
+extern void aout_init(void);                 /* located in module aout.cpp */
+extern void aout_update(uint32_t);           /* located in module aout.cpp */
+extern void aout_tick(void);                 /* located in module aout.cpp */
+extern UCHAR aout_range(uint32_t, uint32_t); /* located in module aout.cpp */
+extern UCHAR aout_slew(uint16_t);            /* located in module aout.cpp */
+extern UCHAR aout_alarm(uint16_t);           /* located in module aout.cpp */
+extern const struct aout_stat *aout_stat_get(void); /* module aout.cpp */
+extern void pulse_init(void);                /* located in module pulse.cpp */
+extern void pulse_update(uint32_t);          /* located in module pulse.cpp */
+extern UCHAR pulse_k(uint32_t);              /* located in module pulse.cpp */
+extern const struct pulse_stat *pulse_stat_get(void); /* module pulse.cpp */
+extern void zc_init(void);                   /* located in module zero_cross.cpp */
+extern UCHAR zc_sample(uint16_t);            /* located in module zero_cross.cpp */
+extern UCHAR zc_block(const uint16_t *, uint16_t); /* module zero_cross.cpp */
+extern uint32_t zc_frequency(void);          /* located in module zero_cross.cpp */
+extern void tt_init(void);                   /* located in module tone_track.cpp */
+extern UCHAR tt_block(const uint16_t *, uint16_t); /* module tone_track.cpp */
+extern uint32_t tt_frequency(void);          /* located in module tone_track.cpp */
+extern const int16_t sin_q15[SIN_Q15_SIZE];  /* located in module tone_track.cpp */
+extern void fp_init(void);                   /* located in module fft_peak.cpp */
+extern UCHAR fp_config(UCHAR, UCHAR);        /* located in module fft_peak.cpp */
+extern UCHAR fp_block(const uint16_t *, uint16_t); /* module fft_peak.cpp */
+extern uint32_t fp_frequency(void);          /* located in module fft_peak.cpp */
+extern const struct fft_peak_vars *fp_vars(void); /* module fft_peak.cpp */
+extern void am_init(void);                   /* located in module amdf.cpp */
+extern UCHAR am_block(const uint16_t *, uint16_t); /* located in module amdf.cpp */
+extern uint32_t am_frequency(void);          /* located in module amdf.cpp */
+extern UCHAR freq_engine_select(UCHAR);      /* located in module freq_engine.cpp */
+extern UCHAR freq_engine_current(void);      /* located in module freq_engine.cpp */
+extern UCHAR freq_engine_compare(UCHAR);     /* located in module freq_engine.cpp */
+extern UCHAR freq_engine_compared(void);     /* located in module freq_engine.cpp */
+extern const struct freq_engine *freq_engine_get(UCHAR); /* freq_engine.cpp */
+extern UCHAR freq_engine_block(const uint16_t *, uint16_t);
+                                             /* located in module freq_engine.cpp */
+extern uint32_t freq_engine_frequency(void); /* located in module freq_engine.cpp */
 extern uint32_t frequency;
 extern uint32_t temperature;
 //extern uint32_t velocity;
@@ -0,0 +1,326 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file swtimer.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      swtimer.cpp                                          --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Software timers on a hierarchical timer wheel, in timer0 ticks.
+
+   These replace swtimer0..7, eight byte counters that timer0() counted
+   down at fixed rates whether they were in use or not.  A timer is a
+   struct swtimer, owned by its user or taken from a pool of
+   SWT_POOL_SIZE with swt_alloc(), so there is no fixed number of them.
+
+   The wheel has SWT_LEVELS levels of 2^SWT_SLOT_BITS slots.  A timer due
+   in fewer than 32 ticks sits in a level 0 slot, the one for its tick.
+   One due in fewer than 32*32 sits in the level 1 slot for its group of
+   32 ticks, and so on up to level 3, 2^20 ticks (105 s at 100 us).  A
+   timer further out than that waits in the level 3 slot visited last and
+   is placed again when it comes up.  swt_tick() visits one level 0 slot
+   per tick.  Each time the level below wraps it empties the current
+   slot of the next level up into the lower levels (the cascade).
+
+   Start and stop are O(1): the slot follows from the due tick, and each
+   timer keeps a pointer to the pointer to it, so it is unlinked without
+   walking a list.  A tick costs the timers in its slot, plus a cascade
+   every 32 ticks, however many timers are running.
+
+   A timer is delivered one of two ways:
+   - flag: swt_tick() sets the flag.  A periodic flag timer is restarted
+     in the interrupt.
+   - callback: swt_tick() moves it to the fired list and posts EV_TIMER.
+     swt_run(), a task released by that event, calls the callback from
+     the loop.  A periodic callback timer is restarted there, from its
+     due tick, so a late loop does not make it drift.  A loop a period or
+     more late finds it due already, it goes out on the next tick.
+
+   The lists are shared with swt_tick(), so the loop side changes them
+   with interrupts masked, for a few instructions at a time.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+#define SWT_SLOTS      (1 << SWT_SLOT_BITS)
+#define SWT_SLOT_MASK  (SWT_SLOTS - 1)
+#define SWT_SPAN       (1UL << (SWT_SLOT_BITS*SWT_LEVELS)) /* ticks the wheel holds */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static struct swtimer *swt_wheel[SWT_LEVELS][SWT_SLOTS];
+   static struct swtimer *swt_fired = NULL;      // callbacks for swt_run()
+   static struct swtimer **swt_fired_tail = &swt_fired;
+   static uint32_t swt_now = 0;                  // the last tick visited
+   static struct swtimer swt_pool[SWT_POOL_SIZE];
+   static struct swtimer *swt_free_list = NULL;
+
+/*****************************************************************************/
+/// \fn static void swt_link(struct swtimer **head, struct swtimer *t)
+/// @brief puts t at the front of a list
+/*****************************************************************************/
+static void swt_link(struct swtimer **head, struct swtimer *t)
+{
+   t->next = *head;
+   if(t->next) t->next->pprev = &t->next;
+   t->pprev = head;
+   *head = t;
+}
+
+/*****************************************************************************/
+/// \fn static void swt_unlink(struct swtimer *t)
+/// @brief takes t out of whichever list it is in
+/*****************************************************************************/
+static void swt_unlink(struct swtimer *t)
+{
+   if(t->next) t->next->pprev = t->pprev;
+   else if(swt_fired_tail == &t->next) swt_fired_tail = t->pprev;
+   *t->pprev = t->next;
+   t->next = NULL;
+   t->pprev = NULL;
+}
+
+/*****************************************************************************/
+/// \fn static void swt_insert(struct swtimer *t, UCHAR cascade)
+/// @brief puts an armed timer in the wheel slot for t->expires
+/// @param cascade 1 from swt_tick() before it visits the slot of swt_now,
+/// which still takes a timer due now.  Anywhere else that slot is done
+/// and a timer due now goes in the next tick, not a wheel turn later.
+/*****************************************************************************/
+static void swt_insert(struct swtimer *t, UCHAR cascade)
+{
+   int32_t delta = (int32_t)(t->expires - swt_now);
+   uint32_t e = t->expires;
+   UCHAR level;
+
+   if(delta < 0 || (delta == 0 && !cascade))
+      e = swt_now + 1;                         // overdue, the next tick
+   else if((uint32_t)delta >= SWT_SPAN)        // beyond the wheel, placed
+      e = swt_now + SWT_SPAN - 1;              //   again when it comes up
+   delta = e - swt_now;
+   for(level = 0; level < SWT_LEVELS - 1; level++)
+      if((uint32_t)delta < (1UL << (SWT_SLOT_BITS*(level + 1)))) break;
+   swt_link(&swt_wheel[level][(e >> (SWT_SLOT_BITS*level)) & SWT_SLOT_MASK], t);
+   t->state = SWT_ARMED;
+}
+
+/*****************************************************************************/
+/// \fn void swt_init(void)
+/// @brief empties the wheel and fills the pool
+/*****************************************************************************/
+void swt_init(void)
+{
+   UCHAR l, s;
+   for(l = 0; l < SWT_LEVELS; l++)
+      for(s = 0; s < SWT_SLOTS; s++) swt_wheel[l][s] = NULL;
+   swt_fired = NULL;
+   swt_fired_tail = &swt_fired;
+   swt_free_list = NULL;
+   for(s = 0; s < SWT_POOL_SIZE; s++)
+   {
+      swt_pool[s].next = swt_free_list;
+      swt_free_list = &swt_pool[s];
+   }
+}
+
+/*****************************************************************************/
+/// \fn void swt_setup(struct swtimer *t, swt_fn fn, void *arg,
+///                    volatile UCHAR *flag)
+/// @brief sets how a stopped timer is delivered
+/// @param fn called as fn(arg) from the loop by swt_run(), or NULL
+/// @param flag set to 1 in the interrupt when fn is NULL
+/*****************************************************************************/
+void swt_setup(struct swtimer *t, swt_fn fn, void *arg, volatile UCHAR *flag)
+{
+   t->next = NULL;
+   t->pprev = NULL;
+   t->fn = fn;
+   t->arg = arg;
+   t->flag = flag;
+   t->period = 0;
+   t->state = SWT_IDLE;
+}
+
+/*****************************************************************************/
+/// \fn void swt_start(struct swtimer *t, uint32_t ticks, uint32_t period)
+/// @brief (re)starts a timer, a running one is stopped first
+/// @param ticks until it is due, at least 1
+/// @param period ticks between later expiries, 0 for a one shot
+/*****************************************************************************/
+void swt_start(struct swtimer *t, uint32_t ticks, uint32_t period)
+{
+   __disable_irq();
+   if(t->state != SWT_IDLE) swt_unlink(t);
+   t->expires = swt_now + (ticks ? ticks : 1);
+   t->period = period;
+   swt_insert(t, 0);
+   __enable_irq();
+}
+
+/*****************************************************************************/
+/// \fn void swt_stop(struct swtimer *t)
+/// @brief stops a timer, also one that fired and waits for swt_run()
+/*****************************************************************************/
+void swt_stop(struct swtimer *t)
+{
+   __disable_irq();
+   if(t->state != SWT_IDLE) swt_unlink(t);
+   t->state = SWT_IDLE;
+   __enable_irq();
+}
+
+/*****************************************************************************/
+/// \fn UCHAR swt_active(const struct swtimer *t)
+/// @return 1 if the timer is running or its callback is still to run
+/*****************************************************************************/
+UCHAR swt_active(const struct swtimer *t)
+{
+   return t->state != SWT_IDLE;
+}
+
+/*****************************************************************************/
+/// \fn struct swtimer *swt_alloc(void)
+/// @return a timer from the pool, NULL if all are in use
+/*****************************************************************************/
+struct swtimer *swt_alloc(void)
+{
+   struct swtimer *t;
+   __disable_irq();
+   t = swt_free_list;
+   if(t) swt_free_list = t->next;
+   __enable_irq();
+   if(t) swt_setup(t, NULL, NULL, NULL);
+   return t;
+}
+
+/*****************************************************************************/
+/// \fn void swt_free(struct swtimer *t)
+/// @brief stops a timer from swt_alloc() and gives it back to the pool
+/*****************************************************************************/
+void swt_free(struct swtimer *t)
+{
+   swt_stop(t);
+   __disable_irq();
+   t->next = swt_free_list;
+   swt_free_list = t;
+   __enable_irq();
+}
+
+/*****************************************************************************/
+/// \fn static void swt_cascade(UCHAR level)
+/// @brief moves the timers of the current slot of level down the wheel
+/*****************************************************************************/
+static void swt_cascade(UCHAR level)
+{
+   struct swtimer **slot =
+      &swt_wheel[level][(swt_now >> (SWT_SLOT_BITS*level)) & SWT_SLOT_MASK];
+   struct swtimer *t;
+   while((t = *slot) != NULL)
+   {
+      swt_unlink(t);
+      swt_insert(t, 1);
+   }
+}
+
+/*****************************************************************************/
+/// \fn void swt_tick(void)
+/// @brief called from timer0() every tick, delivers the timers that are due
+/*****************************************************************************/
+void swt_tick(void)
+{
+   struct swtimer **slot, *t;
+   UCHAR level;
+
+   swt_now++;
+   for(level = 1; level < SWT_LEVELS; level++)
+   {                             // each level wraps, cascade the next one up
+      if(((swt_now >> (SWT_SLOT_BITS*(level - 1))) & SWT_SLOT_MASK) != 0) break;
+      swt_cascade(level);
+   }
+
+   slot = &swt_wheel[0][swt_now & SWT_SLOT_MASK];
+   while((t = *slot) != NULL)
+   {
+      swt_unlink(t);
+      if((int32_t)(t->expires - swt_now) > 0)
+      {                          // beyond the wheel, not due yet
+         swt_insert(t, 0);
+         continue;
+      }
+      if(t->fn)
+      {                          // swt_run() calls it
+         t->state = SWT_FIRED;
+         swt_link(swt_fired_tail, t);
+         swt_fired_tail = &t->next;
+         sched_post(EV_TIMER);
+      }
+      else
+      {
+         if(t->flag) *t->flag = 1;
+         if(t->period)
+         {
+            t->expires += t->period;
+            swt_insert(t, 0);
+         }
+         else t->state = SWT_IDLE;
+      }
+   }
+}
+
+/*****************************************************************************/
+/// \fn void swt_run(void)
+/// @brief the task released by EV_TIMER, calls the callbacks of the timers
+/// that fired, in the order they did
+/*****************************************************************************/
+void swt_run(void)
+{
+   struct swtimer *t;
+   for(;;)
+   {
+      __disable_irq();
+      t = swt_fired;
+      if(t == NULL)
+      {
+         __enable_irq();
+         return;
+      }
+      swt_unlink(t);
+      if(t->period)
+      {                          // from its due tick, no drift
+         t->expires += t->period;   // due now if a period late
+         swt_insert(t, 0);
+      }
+      else t->state = SWT_IDLE;
+      __enable_irq();
+      t->fn(t->arg);             // may stop or restart t
+   }
+}
+
+/*****************************************************************************/
+/// \fn uint32_t swt_ticks(void)
+/// @return the wheel's tick count, the time base of every timer
+/*****************************************************************************/
+uint32_t swt_ticks(void)
+{
+   return swt_now;
+}
@@ -0,0 +1,197 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file telemetry.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      telemetry.cpp                                        --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   BINARY display mode: fixed layout status records instead of the text
+   reports, for a data logger on the serial port.
+
+   Every tel_every() flow updates (BIN<n> command, 1 to TEL_EVERY_MAX),
+   tel_update() packs time, Flow, frequency, temperature, Re, St, flags,
+   the frequency engine and the tick period into TEL_REC_SIZE bytes
+   (offsets in shared.h), ending with a CRC-16/CCITT from the mbed MbedCRC
+   class.  The record is COBS framed: the zero bytes are replaced by the
+   distance to the next one, a code byte in front gives the first, so the
+   only zero on the line is the 0 that ends each frame.  A reader that
+   starts mid frame, or meets a corrupted one, picks up at the next 0.
+   Text sent in this mode, the answer to a command, fails the CRC and is
+   passed over the same way.
+
+   A record goes out whole or not at all: when tx_buf has no room for
+   TEL_FRAME_MAX bytes it is skipped, counted in tel_skip_count and
+   flagged in the next one.  At 9600 baud a frame every flow update,
+   39 a second, is more than the line carries, so BIN1 will skip some.
+
+   The time is System_Timer_count, in ticks, and the record carries the
+   tick period so a reader needs no TICK default.  Count times period is
+   the time since the boot as long as TICK has not been changed since.
+
+   A frame is 32 bytes for what the DEBUG report says in about 170.
+
+   tools/tel_decode turns a capture into one text line per record.
+
+   tel_frame_put() frames other records the same way, the LOGD read back
+   of the flash log (flashlog.cpp) uses it.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+#define TEL_EVERY_DEFAULT 4     /* a record every 102 ms */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static MbedCRC<POLY_16BIT_CCITT, 16> tel_crc(0xFFFF, 0, false, false);
+   static UCHAR tel_every_n = TEL_EVERY_DEFAULT;  // flow updates per record
+   static UCHAR tel_count = 0;                    // flow updates since one
+   static UCHAR tel_seq = 0;
+   static UCHAR tel_flags = 0;                    // events for the next one
+   static uint16_t tel_adc_overrun = 0;           // adc_overrun last time
+   static uint16_t tel_tx_drop = 0;               // tx_drop_count last time
+   uint16_t tel_skip_count = 0;                   // records skipped, no room
+
+/*****************************************************************************/
+/// \fn static void tel_put32(UCHAR *p, uint32_t x)
+/// @brief stores x little endian
+/*****************************************************************************/
+static void tel_put32(UCHAR *p, uint32_t x)
+{
+   p[0] = x;
+   p[1] = x >> 8;
+   p[2] = x >> 16;
+   p[3] = x >> 24;
+}
+
+/*****************************************************************************/
+/// \fn static UCHAR tel_cobs(UCHAR *dst, const UCHAR *src, UCHAR n)
+/// @brief COBS encodes n bytes (n < 254) and adds the 0 delimiter
+/// @return bytes in dst, n + 2
+/*****************************************************************************/
+static UCHAR tel_cobs(UCHAR *dst, const UCHAR *src, UCHAR n)
+{
+   UCHAR code = 0, out = 1, i;   // dst[code] is the open code byte
+
+   for(i=0;i<n;i++)
+   {
+      if(src[i] == 0)
+      {
+         dst[code] = out - code;  // distance to this zero
+         code = out++;
+      }
+      else dst[out++] = src[i];
+   }
+   dst[code] = out - code;
+   dst[out++] = 0;
+   return out;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR tel_frame_put(UCHAR *rec, UCHAR n)
+/// @brief adds the CRC-16/CCITT of n bytes at rec[n], and sends the record
+/// COBS framed, whole or not at all
+/// @param rec n bytes, and 2 more for the CRC
+/// @param n up to TEL_LOG_FRAME_MAX - 4
+/// @return 1 if sent, 0 if tx_buf has no room for it
+/*****************************************************************************/
+UCHAR tel_frame_put(UCHAR *rec, UCHAR n)
+{
+   UCHAR frame[TEL_LOG_FRAME_MAX];
+   UCHAR i, len;
+   uint32_t crc;
+
+   if(n > TEL_LOG_FRAME_MAX - 4 || UART_tx_space() < n + 4) return 0;
+   tel_crc.compute(rec, n, &crc);
+   rec[n] = crc;
+   rec[n + 1] = crc >> 8;
+   len = tel_cobs(frame, rec, n + 2);
+   for(i=0;i<len;i++) UART_put(frame[i]);
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR tel_config(UCHAR every)
+/// @brief sets the record rate, one every 'every' flow updates
+/// @return 1 if done, 0 if every is out of range
+/*****************************************************************************/
+UCHAR tel_config(UCHAR every)
+{
+   if(every < 1 || every > TEL_EVERY_MAX) return 0;
+   tel_every_n = every;
+   tel_count = 0;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR tel_every(void)
+/// @return flow updates per record
+/*****************************************************************************/
+UCHAR tel_every(void)
+{
+   return tel_every_n;
+}
+
+/*****************************************************************************/
+/// \fn void tel_update(void)
+/// @brief called after each flow update, sends a record every tel_every()
+/// of them in BINARY mode
+/*****************************************************************************/
+void tel_update(void)
+{
+   UCHAR rec[TEL_REC_SIZE];
+   const struct flow_vars *v;
+
+   if(display_mode != BINARY) return;
+   if(++tel_count < tel_every_n) return;
+   tel_count = 0;
+
+   if(adc_overrun != tel_adc_overrun) tel_flags |= TEL_FLAG_ADC_OVR;
+   tel_adc_overrun = adc_overrun;
+   if(tx_drop_count != tel_tx_drop) tel_flags |= TEL_FLAG_TX_DROP;
+   tel_tx_drop = tx_drop_count;
+   if(UART_tx_space() < TEL_FRAME_MAX)
+   {
+      tel_skip_count++;
+      tel_seq++;                  // the gap shows in the sequence too
+      tel_flags |= TEL_FLAG_SKIP;
+      return;
+   }
+
+   v = flow_engine_vars();
+   rec[TEL_OFS_TYPE] = TEL_TYPE_STATUS;
+   rec[TEL_OFS_SEQ] = tel_seq++;
+   tel_put32(&rec[TEL_OFS_TIME], System_Timer_count);
+   tel_put32(&rec[TEL_OFS_FLOW], Flow);
+   tel_put32(&rec[TEL_OFS_FREQ], frequency);
+   tel_put32(&rec[TEL_OFS_TEMP], temperature);
+   tel_put32(&rec[TEL_OFS_RE], v->Re);
+   rec[TEL_OFS_ST] = v->St_const;
+   rec[TEL_OFS_ST + 1] = v->St_const >> 8;
+   rec[TEL_OFS_FLAGS] = tel_flags | (frequency != 0 ? TEL_FLAG_FREQ : 0);
+   rec[TEL_OFS_ENGINE] = freq_engine_current();
+   rec[TEL_OFS_TICK_US] = pit_tick_stat()->period_us;
+   rec[TEL_OFS_TICK_US + 1] = pit_tick_stat()->period_us >> 8;
+   tel_flags = 0;
+   tel_frame_put(rec, TEL_OFS_CRC);      // room checked above
+}
@@ -24,11 +24,11 @@
 --               
 --               
    Functional Description:  
-   This file contains code for the only interrupt routine, based on the System
-   Timer.  
-   The System Timer interrupt happens every
-   100 us as determined by mbed Component Configuration.
-   The System Timer interrupt acts as the real time scheduler for the firmware.
+   This file contains timer0(), the System Timer tick.  PIT_IRQHandler
+   (pit_tick.cpp) calls it every TICK_US_DEFAULT, 100 us, or the period
+   set with the TICK command; the group times below are for 100 us.  The
+   UART0, ADC0 and DMA0 interrupts have routines of their own.
+   The System Timer tick acts as the real time scheduler for the firmware.
    Each time the interrupt occurs, different tasks are done based on critical 
    timing requirement for each task.  
    There are 256 timer states (an 8-bit counter that rolls over) so the 
@@ -40,14 +40,15 @@
     
    I.  Entry and timer state calculation
    II. 100 us group
-      A.  Fast Software timers
+      A.  Software timer wheel (swtimer.cpp)
       B.  Read Sensors
-      C.  Update 
+      C.  Release scheduled tasks (sched.cpp)
+      D.  4-20 mA alarm current when Flow stops (aout.cpp)
    III. 200 us group
       A. 
       B.
    IV.  400 us group
-      A.  Medium Software timers
+      A. 
       B. 
     V.   800 us group
       A.  Set 420 PWM Period
@@ -55,9 +56,9 @@
       A. Display timer and flag
       B. Heartbeat/ LED outputs
    VII  3.2 ms group
-      A. Slow Software Timers   
+      A.    
     VIII 6.4 ms group A
-      A. Very Slow Software Timers
+      A. 
    IX.  Long time group
       A. Determine Mode
       B. Heartbeat/ LED outputs       
@@ -88,18 +89,10 @@ extern "C" {
 /*   Definitions     */
 /**********************/
 
-   volatile    UCHAR swtimer0 = 0;
-   volatile    UCHAR swtimer1 = 0;
-   volatile    UCHAR swtimer2 = 0;
-   volatile    UCHAR swtimer3 = 0; 
-   volatile    UCHAR swtimer4 = 0;    
-   volatile    UCHAR swtimer5 = 0;    
-   volatile    UCHAR swtimer6 = 0;    
-   volatile    UCHAR swtimer7 = 0; 
-
   volatile uint16_t SwTimerIsrCounter = 0U;
-  UCHAR  display_timer = 0;  // 1 second software timer for display   
-  UCHAR  display_flag = 0;   // flag between timer interrupt and monitor.c, like
+  volatile uint32_t System_Timer_count = 0; // 32 bits, counts for 
+                                            // 119 hours at 100 us period
+  volatile UCHAR display_flag = 0; // set by a timer every report period, like
                         // a binary semaphore      
 
 	
@@ -120,8 +113,6 @@ DigitalOut redLED(LED_RED);
 void timer0(void)
  {
 	 static   uint16_t display_led = 0; // start counter for red led
-	 static   uint32_t System_Timer_count = 0; // 32 bits, counts for 
-                                                  // 119 hours at 100 us period
 	 static   uint16_t timer0_count = 0; // 16 bits, counts for 
                                           // 6.5 seconds at 100 us period 
 	 static   UCHAR timer_state = 0;   
@@ -145,14 +136,17 @@ void timer0(void)
 /*******************************************************************/
 //  II.  100 us Group
 
-//     A. Update Fast Software timers 
-   if (swtimer0 > 0)     // if not yet expired, 
-      (swtimer0)--;        // then decrement fast timer (1 ms to 256 ms)
-   if (swtimer1 > 0)     // if not yet expired, 
-      (swtimer1)--;        // then decrement fast timer (1 ms to 256 ms)
+//     A. Software timers, only the ones due this tick are touched
+   swt_tick();
   
 //    B.   Update Sensors
 
+//    C.   Release scheduled tasks that are due
+   sched_tick();
+
+//    D.   4-20 mA output to the alarm current if Flow has stopped coming
+   aout_tick();
+
 
 /*******************************************************************/
 /*      200 us Group                                                 */
@@ -171,12 +165,7 @@ void timer0(void)
 //   IV.  400 us group  
 //           timer states 2,6,10,14,18,22,...254 
 
-//      A.  Medium Software timers
-      if (swtimer2 > 0)  // if not yet expired, every other time 
-         (swtimer2)--;     // then decrement med timer  (4 ms to 1024 ms)
-      if (swtimer3 > 0) // if not yet expired, every other time 
-         (swtimer3)--;        // then decrement med timer  (4 ms to 1024 ms)
-
+//      A.  
 //      B.  
    } // end 4 ms group
    
@@ -209,13 +198,7 @@ void timer0(void)
 // VII  3.2 ms group
 //          timer states 16, 48, 80, 112, 144, 176, 208, 240
 
-//    A. Slow Software Timers
-      if (swtimer4 > 0)  // if not yet expired, every 32nd time
-         (swtimer4)--;        // then decrement slow timer (32 ms to 8 s)
-      if (swtimer5 > 0) // if not yet expired, every 32nd time
-         (swtimer5)--;        // then decrement slow timer (32 ms to 8 s)
-         
-//    B.  Update
+//    A.  Update
     
    }   // end 3.2 ms group
    
@@ -227,16 +210,7 @@ void timer0(void)
 // VIII 6.4 ms group A
 //           timer states 32, 96, 160, 224 
 
-//    A. Very Slow Software Timers
-      if (swtimer6 > 0)  // if not yet expired, every 64th 
-                                            // time 
-         (swtimer6)--;        // then decrement very slow timer (6.4 ms to 1.6s)
-
-      if (swtimer7 > 0)  // if not yet expired, every 64th 
-                                            // time 
-         (swtimer7)--;        // then decrement very slow timer (64 ms to 1.6s)
-
-//    B.  Update
+//    A.  Update
 
    }   // end 6.4 ms group A
    
@@ -250,9 +224,7 @@ void timer0(void)
 
 //    A.  Update
 
-//    A. Display timer and flag
-      display_timer--; // decrement display timer every 6.4 ms.  Total time is      
-                      // 256*6.4ms = 1.6384 seconds. 
+//    A. LED timer (display_flag is set by report_timer, Monitor.cpp)
 		 display_led++; // increments led timer every 6.4 ms. 
 		 /***************************************************************
 		  * step counter from 0 to 155 for a total of 156 steps
@@ -262,8 +234,6 @@ void timer0(void)
 		 if(display_led == 155)	
 		 { display_led = 0;
 		 }
-      if (display_timer == 1)
-         display_flag = 1;     // every 1.6384 seconds, now OK to display
 			
 //    B. Heartbeat/ LED outputs
 //   Generate Outputs  ************************************
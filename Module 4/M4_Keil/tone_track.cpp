@@ -0,0 +1,277 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file tone_track.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      tone_track.cpp                                       --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Narrowband tracking frequency estimator, one of the engines behind
+   readFREQ() (freq_engine.cpp).  Once per ADC block:
+
+   I.   Remove the block mean, scale the samples to q15 and apply a Hann
+        window, which keeps the negative frequency image and other tones
+        out of the neighbouring bins
+   II.  Evaluate a bank of TT_BINS single DFT bins, the Goertzel bins of
+        the frequencies around the last estimate, as a correlation with a
+        table sine/cosine phasor.  A q15 Goertzel resonator grows as
+        1/sin(w) and overflows 32 bits at the low shedding frequencies, the
+        phasor form does not and costs two multiplies per sample per bin.
+   III. Locked when the strongest bin holds most of the block's signal:
+        fit a parabola through it and its neighbours for the fraction of
+        a bin, publish, and centre the bank there for the next block.
+        Centred on the tone the neighbours are equal, so the tracking
+        settles where the parabola has no bias.
+        Unlocked, the bank spreads to whole bin spacing and steps outward
+        from where the tone was lost, a stretch either side in turn, so a
+        step in the flow is found again within a few blocks.  The last
+        frequency is held meanwhile, and dropped to 0 after a second.
+
+   Noise and harmonics outside the bank do not reach the estimate, so it
+   holds on signals the zero crossing detector miscounts.  The window is
+   4 bins wide, which sets the lowest frequency, TT_F_MIN.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+#define TT_FS_HZ        ADC_SAMPLE_HZ
+#define TT_BINS         5         /* bins in the bank, odd */
+#define TT_BIN_X100     (100UL*TT_FS_HZ/ADC_BLOCK_SIZE)  /* DFT bin, Hz (x100) */
+#define TT_TRACK_STEP   (TT_BIN_X100/2)  /* bank spacing when locked */
+#define TT_F_MIN        10000     /* search band, Hz (x100) */
+#define TT_F_MAX        450000
+#define TT_LOCK_RATIO   15        /* peak/(sum |x|), a clean tone gives 50 */
+#define TT_LOST_BLOCKS  (TT_FS_HZ/ADC_BLOCK_SIZE)  /* unlocked for 1 s, no flow */
+#define TT_SCAN_STEP    (TT_BINS*TT_BIN_X100)     /* bank width when searching */
+/* phase increment per Hz (x100), 2^32/(100*fs) rounded */
+#define TT_INC_PER_X100 ((uint32_t)((4294967296ULL + 50*TT_FS_HZ)/(100*TT_FS_HZ)))
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static uint32_t tt_center = TT_F_MIN;  // bank centre, Hz (x100)
+   static UCHAR    tt_locked = 0;
+   static uint32_t tt_home = TT_F_MIN;    // search origin, Hz (x100)
+   static uint16_t tt_scan = 0;           // search stretch, 0 is tt_home
+   static uint16_t tt_miss = 0;           // blocks without the tone
+   static uint32_t tt_freq = 0;           // latest estimate, Hz (x100)
+
+/* sin(2*pi*i/256), q15 */
+const int16_t sin_q15[SIN_Q15_SIZE] =
+{
+        0,    804,   1608,   2410,   3212,   4011,   4808,   5602,
+     6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+    12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+    18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+    23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,
+    27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+    30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,
+    32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+    32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+    32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+    30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,
+    27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+    23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,
+    18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+    12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+     6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+        0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,
+    -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+   -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530,
+   -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+   -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+   -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+   -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971,
+   -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+   -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285,
+   -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+   -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+   -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+   -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868,
+   -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+   -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,
+    -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804
+};
+
+/*****************************************************************************/
+/// \fn static uint32_t tt_mag(int32_t re, int32_t im)
+/// @brief |re + j im| within 7%, max + 3/8 min, no square root.  Good
+/// enough for the lock test, not for interpolation.
+/*****************************************************************************/
+static uint32_t tt_mag(int32_t re, int32_t im)
+{
+   uint32_t a = (re < 0) ? -re : re;
+   uint32_t b = (im < 0) ? -im : im;
+   if(a < b) { uint32_t t = a; a = b; b = t; }
+   return a + ((b*3) >> 3);
+}
+
+/*****************************************************************************/
+/// \fn void tt_init(void)
+/// @brief starts tracking at the last published frequency, or searching
+/// when there is none
+/*****************************************************************************/
+void tt_init(void)
+{
+   tt_freq = frequency;
+   tt_locked = (frequency >= TT_F_MIN && frequency <= TT_F_MAX);
+   tt_center = tt_locked ? frequency : TT_F_MIN;
+   tt_home = tt_center;
+   tt_scan = 0;
+   tt_miss = 0;
+}
+
+/*****************************************************************************/
+/// \fn static void tt_scan_next(void)
+/// @brief moves the bank to the next search stretch: tt_home, one up, one
+/// down, two up...  Stretches outside the band are skipped, and the search
+/// starts over at tt_home when both sides are exhausted.
+/*****************************************************************************/
+static void tt_scan_next(void)
+{
+   int32_t off, c;
+   for(;;)
+   {
+      tt_scan++;
+      off = ((tt_scan + 1) >> 1)*TT_SCAN_STEP;
+      c = (tt_scan & 1) ? (int32_t)tt_home + off : (int32_t)tt_home - off;
+      if(c + TT_SCAN_STEP/2 >= TT_F_MIN && c - TT_SCAN_STEP/2 <= TT_F_MAX)
+         break;
+      if((int32_t)tt_home - off + TT_SCAN_STEP/2 < TT_F_MIN &&
+         (int32_t)tt_home + off - TT_SCAN_STEP/2 > TT_F_MAX)
+      {
+         tt_scan = 0;
+         c = tt_home;
+         break;
+      }
+   }
+   tt_center = c;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR tt_block(const uint16_t *blk, uint16_t n)
+/// @brief runs the bin bank over one block of samples
+/// @param blk raw 16 bit ADC readings
+/// @return 1 if a new frequency was published, 0 otherwise
+/*****************************************************************************/
+UCHAR tt_block(const uint16_t *blk, uint16_t n)
+{
+   int32_t re[TT_BINS], im[TT_BINS];
+   uint32_t ph[TT_BINS], inc[TT_BINS], pw[TT_BINS];
+   uint32_t step = tt_locked ? TT_TRACK_STEP : TT_BIN_X100;
+   uint32_t f0 = tt_center - (TT_BINS/2)*step;   // may wrap below 0
+   uint32_t sum = 0, abs_sum = 0, peak;
+   int32_t mean, x, num, den, big;
+   uint16_t i;
+   UCHAR k, kp, sh;
+
+// I. Block mean
+   for(i=0;i<n;i++) sum += blk[i];
+   mean = sum/n;
+
+// II. Bin bank
+   for(k=0;k<TT_BINS;k++)
+   {
+      uint32_t f = f0 + k*step;
+      inc[k] = ((int32_t)f > 0) ? f*TT_INC_PER_X100 : 0;
+      ph[k] = 0;
+      re[k] = 0;
+      im[k] = 0;
+   }
+   for(i=0;i<n;i++)
+   {
+      x = ((int32_t)blk[i] - mean) >> 1;               // q15
+      abs_sum += (x < 0) ? -x : x;
+      // Hann, (1 - cos)/2 from the sine table
+      x = (x*((32768 - sin_q15[(UCHAR)(i*SIN_Q15_SIZE/n + SIN_Q15_SIZE/4)]) >> 1)) >> 15;
+      for(k=0;k<TT_BINS;k++)
+      {
+         UCHAR idx = ph[k] >> 24;
+         re[k] += (x*sin_q15[(UCHAR)(idx + SIN_Q15_SIZE/4)]) >> 8;
+         im[k] += (x*sin_q15[idx]) >> 8;
+         ph[k] += inc[k];
+      }
+   }
+   // bin powers, re and im scaled to 15 bits so the squares fit
+   big = 0;
+   for(k=0;k<TT_BINS;k++)
+   {
+      if(!inc[k]) re[k] = im[k] = 0;
+      if(re[k] > big) big = re[k];
+      if(-re[k] > big) big = -re[k];
+      if(im[k] > big) big = im[k];
+      if(-im[k] > big) big = -im[k];
+   }
+   for(sh=0; (big >> sh) >= 0x8000; sh++) ;
+   kp = 0;
+   for(k=0;k<TT_BINS;k++)
+   {
+      int32_t r = re[k] >> sh, m = im[k] >> sh;
+      pw[k] = (uint32_t)(r*r) + (uint32_t)(m*m);
+      if(pw[k] > pw[kp]) kp = k;
+   }
+   peak = f0 + kp*step;
+
+// III. Lock, interpolate, re-centre
+   if(tt_mag(re[kp], im[kp]) < abs_sum*TT_LOCK_RATIO || abs_sum == 0)
+   {
+      if(tt_locked)
+      {                          // lost the tone, search around here
+         tt_locked = 0;
+         tt_home = tt_center;
+         tt_scan = 0;
+      }
+      tt_scan_next();
+      if(tt_freq == 0 || ++tt_miss < TT_LOST_BLOCKS) return 0;
+      tt_freq = 0;               // no flow
+      return 1;
+   }
+   tt_miss = 0;
+   if(!tt_locked || kp == 0 || kp == TT_BINS-1)
+   {                             // found, or moving off the edge of the bank
+      tt_locked = 1;
+      tt_center = peak;
+      return 0;
+   }
+
+   // vertex of the parabola through the powers a, b, c of the peak bin
+   // and its neighbours, offset = (c - a)/(2(2b - a - c)) spacings.  The
+   // powers are cut to 16 bits so num*step fits.
+   for(sh=0; (pw[kp] >> sh) >= 0x10000; sh++) ;
+   num = (int32_t)(pw[kp+1] >> sh) - (int32_t)(pw[kp-1] >> sh);
+   den = 2*(2*(int32_t)(pw[kp] >> sh) - (int32_t)(pw[kp-1] >> sh) -
+            (int32_t)(pw[kp+1] >> sh));
+   if(den > 0) peak += (num*(int32_t)step)/den;
+
+   tt_freq = peak;
+   tt_center = peak;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t tt_frequency(void)
+/// @return the latest published frequency in Hz (x100), 0 if no signal
+/*****************************************************************************/
+uint32_t tt_frequency(void)
+{
+   return tt_freq;
+}
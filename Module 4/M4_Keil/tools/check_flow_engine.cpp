@@ -0,0 +1,103 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file check_flow_engine.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      check_flow_engine.cpp                                --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Tools used:  any host C++ compiler (see Makefile)
+--
+   Functional Description:
+   Runs the integer flow engine in flow_engine.cpp over temperatures from
+   0 to 100 C and frequencies from 10 Hz to the 5 kHz Nyquist rate, next to
+   the float formulas in flow_ref.h with the same Strouhal average.  Each
+   pair starts from the same Re and runs ENGINE_UPDATES updates, so the Re
+   to St feedback is checked too.  Exits non-zero if velocity, Re or flow
+   is ever further than the allowed relative bound from the float result.
+--
+*/
+#include <stdio.h>
+#include <math.h>
+#include "flow_ref.h"
+#include "../shared.h"
+
+#define VEL_BOUND     0.10    /* percent */
+#define RE_BOUND      0.25    /* percent */
+#define FLOW_BOUND    0.10    /* percent */
+#define ENGINE_UPDATES 64
+#define ST_SHIFT      4       /* FE_ST_SHIFT in flow_engine.cpp */
+
+/* no cycle counter on the host */
+extern "C" uint32_t cycle_stamp(void) { return 0; }
+extern "C" uint32_t cycles_since(uint32_t start) { return 0; }
+
+/// tracks the worst relative error of one result
+struct bound
+{
+   const char *name;
+   double limit;
+   double worst;
+   double at_f;
+   double at_t;
+};
+
+static void track(struct bound *b, double fixed, double ref, double f, double t)
+{
+   double e = 100*fabs(fixed - ref)/ref;
+   if(e > b->worst) { b->worst = e; b->at_f = f; b->at_t = t; }
+}
+
+static int report(const struct bound *b)
+{
+   int ok = b->worst <= b->limit;
+   printf("%-10s max error %6.3f%% at f %8.0f T %5.0f  (bound %.2f%%)  %s\n",
+          b->name, b->worst, b->at_f, b->at_t, b->limit, ok ? "ok" : "FAIL");
+   return ok;
+}
+
+int main(void)
+{
+   static const uint32_t temps[] = {0, 500, 2300, 5000, 7500, 10000};
+   struct bound vel = {"velocity", VEL_BOUND, 0, 0, 0};
+   struct bound re = {"Re", RE_BOUND, 0, 0, 0};
+   struct bound flow = {"flow", FLOW_BOUND, 0, 0, 0};
+   const struct flow_vars *v = flow_engine_vars();
+   double f, Re, St_avg, velocity;
+   uint32_t ti, t, n;
+   int ok = 1;
+
+   for(ti = 0; ti < sizeof(temps)/sizeof(temps[0]); ti++)
+   {
+      t = temps[ti];
+      for(f = 1000; f <= 500000; f *= 1.05)
+      {
+         flow_engine_init(1500000);
+         Re = 1500000;
+         St_avg = 0;
+         for(n = 0; n < ENGINE_UPDATES; n++)
+         {
+            double St = ref_strouhal(Re);
+            St_avg = (n == 0) ? St : St_avg + (St - St_avg)/(1 << ST_SHIFT);
+            velocity = ref_velocity((uint32_t)f, St_avg);
+            Re = ref_reynolds(ref_density(t), velocity, ref_viscosity(t));
+
+            flow_engine_update((uint32_t)f, t);
+            track(&vel, v->velocity, velocity, f, t);
+            track(&re, v->Re, Re, f, t);
+            track(&flow, v->Flow, ref_flow(velocity), f, t);
+         }
+      }
+   }
+   ok &= report(&vel);
+   ok &= report(&re);
+   ok &= report(&flow);
+   return ok ? 0 : 1;
+}
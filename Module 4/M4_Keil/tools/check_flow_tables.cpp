@@ -0,0 +1,79 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file check_flow_tables.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      check_flow_tables.cpp                                --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Tools used:  any host C++ compiler (see Makefile)
+--
+   Functional Description:
+   Runs the firmware lookups in flow_lut.cpp over every temperature from
+   0 to 100 C (0.01 C steps) and over Re from 10,000 to 10,000,000, and
+   compares them with the float models in flow_ref.h.  Exits non-zero if
+   any lookup is further than the allowed bound from the float result.
+--
+*/
+#include <stdio.h>
+#include <math.h>
+#include "flow_ref.h"
+#include "../shared.h"
+
+#define VISC_BOUND  1.0    /* x1,000,000 units, about 0.1% */
+#define RHO_BOUND   1.0    /* kg/m^3 */
+#define ST_BOUND    1.0    /* x10,000 units */
+
+/// tracks the worst error of one lookup
+struct bound
+{
+   const char *name;
+   double limit;
+   double worst;
+   double at;
+};
+
+static void track(struct bound *b, double lut, double ref, double key)
+{
+   double e = fabs(lut - ref);
+   if(e > b->worst) { b->worst = e; b->at = key; }
+}
+
+static int report(const struct bound *b)
+{
+   int ok = b->worst <= b->limit;
+   printf("%-10s max error %8.4f at %10.0f  (bound %.2f)  %s\n", b->name,
+          b->worst, b->at, b->limit, ok ? "ok" : "FAIL");
+   return ok;
+}
+
+int main(void)
+{
+   struct bound visc = {"viscosity", VISC_BOUND, 0, 0};
+   struct bound rho = {"density", RHO_BOUND, 0, 0};
+   struct bound st = {"strouhal", ST_BOUND, 0, 0};
+   uint32_t t;
+   double Re;
+   int ok = 1;
+
+   for(t = 0; t <= 10000; t++)
+   {
+      track(&visc, lut_viscosity(t), ref_viscosity(t), t);
+      track(&rho, lut_density(t), ref_density(t), t);
+   }
+   for(Re = 10000; Re <= 10000000; Re *= 1.0001)
+   {
+      track(&st, lut_strouhal((uint32_t)Re), ref_strouhal((uint32_t)Re), Re);
+   }
+   ok &= report(&visc);
+   ok &= report(&rho);
+   ok &= report(&st);
+   return ok ? 0 : 1;
+}
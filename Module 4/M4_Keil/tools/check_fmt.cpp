@@ -0,0 +1,121 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file check_fmt.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      check_fmt.cpp                                        --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Tools used:  any host C++ compiler (see Makefile)
+--
+   Functional Description:
+   Checks fmt.cpp against the C library.  fmt_divu10() on every argument
+   below 2^24, at each multiple of 10 and its neighbours above, and at
+   random; fmt_dec() against printf for 0 to 4 decimals, with and without
+   a width, up to FMT_DECI_MAX decimals at the ends of the range, and '*'s
+   for more.  Exits non-zero on the first few differences.
+--
+*/
+#include <stdio.h>
+#include <string.h>
+#include "../shared.h"
+
+#define RANDOM_VALUES 2000000
+
+static int fails = 0;
+
+static uint32_t rnd(void)
+{
+   static uint32_t s = 2463534242u;
+   s ^= s << 13;
+   s ^= s >> 17;
+   s ^= s << 5;
+   return s;
+}
+
+static void check_div(uint32_t n)
+{
+   UCHAR r;
+   uint32_t q = fmt_divu10(n, &r);
+   if((q != n / 10 || r != n % 10) && fails++ < 10)
+      printf("fmt_divu10(%u) = %u r %u\n", n, q, r);
+}
+
+static void check_dec(uint32_t x, UCHAR deci, UCHAR width)
+{
+   char want[32], got[32];
+   uint64_t p = 1;
+   UCHAR i, n;
+
+   for(i=0;i<deci;i++) p *= 10;
+   if(deci > FMT_DECI_MAX)
+   {
+      memset(want, '*', width ? width : 1);
+      want[width ? width : 1] = 0;
+   }
+   else if(deci) snprintf(want, sizeof(want), "%*u.%0*u", width > deci ? width - deci - 1 : 0,
+                     (uint32_t)(x / p), deci, (uint32_t)(x % p));
+   else snprintf(want, sizeof(want), "%*u", width, x);
+   if(width != 0 && strlen(want) > width) memset(want, '*', width), want[width] = 0;
+
+   n = fmt_dec(got, x, deci, width);
+   got[n] = 0;
+   if((strcmp(got, want) != 0 || n > (width ? width : FMT_DEC_MAX)) && fails++ < 10)
+      printf("fmt_dec(%u, %u, %u) = \"%s\", want \"%s\"\n", x, deci, width, got, want);
+}
+
+int main(void)
+{
+   uint32_t n, i;
+   UCHAR deci;
+
+   for(n = 0; n < 1u << 24; n++) check_div(n);
+   for(n = 0xFFFFFFFFu / 10 * 10; n > (1u << 24); n -= 10)
+   {
+      if((n / 10) % 97 != 0) continue;     // every 97th multiple
+      check_div(n - 1);
+      check_div(n);
+      check_div(n + 9);
+   }
+   check_div(0xFFFFFFFFu);
+   for(i = 0; i < RANDOM_VALUES; i++) check_div(rnd());
+
+   for(i = 0; i < RANDOM_VALUES; i++)
+   {
+      n = rnd() >> (i % 32);
+      deci = i % 5;
+      check_dec(n, deci, 0);
+      check_dec(n, deci, 9);
+   }
+   for(deci = 0; deci < 5; deci++)
+   {
+      check_dec(0, deci, 0);
+      check_dec(0xFFFFFFFFu, deci, 0);
+      check_dec(99999999u, deci, 9);
+      check_dec(999999999u, deci, 9);
+   }
+   for(deci = 5; deci <= FMT_DECI_MAX; deci++)
+   {
+      check_dec(0, deci, 0);
+      check_dec(7, deci, 0);
+      check_dec(0xFFFFFFFFu, deci, 0);
+      check_dec(0xFFFFFFFFu, deci, 12);
+   }
+   check_dec(12345, FMT_DECI_MAX + 1, 0);
+   check_dec(12345, 255, 6);
+
+   if(fails)
+   {
+      printf("fmt: %d differences\n", fails);
+      return 1;
+   }
+   printf("fmt: fmt_divu10 and fmt_dec match the C library\n");
+   return 0;
+}
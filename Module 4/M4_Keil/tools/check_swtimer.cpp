@@ -0,0 +1,221 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file check_swtimer.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      check_swtimer.cpp                                    --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Tools used:  any host C++ compiler (see Makefile)
+--
+   Functional Description:
+   Checks the timer wheel of swtimer.cpp against a plain list of due ticks.
+   Timers are started, restarted and stopped at random, one shot and
+   periodic, with flag and callback delivery, due from 1 tick to beyond
+   the 2^20 the wheel holds.  Every flag must be set on the tick its timer
+   is due, every callback run on the first swt_run() from then on, and
+   nothing may fire that is not due.  The run covers several turns of the
+   top level.  Then a periodic callback is run from 0 to 3 periods late,
+   and must fire again at its next due tick or, if that has passed, on
+   the next tick.  Exits non-zero on the first few differences.
+--
+*/
+#include <stdio.h>
+#include <string.h>
+#include "../shared.h"
+
+#define TIMERS        48           /* user owned, plus the pool */
+#define TICKS         3500000UL    /* 3.3 turns of the whole wheel */
+#define RUN_EVERY     7            /* swt_run() as a late loop would */
+#define LATE_PERIOD   20           /* the period of the late loop check */
+
+static int fails = 0;
+
+static struct check_timer
+{
+   struct swtimer *t;
+   struct swtimer own;
+   UCHAR callback;                 // else flag delivery
+   volatile UCHAR flag;
+   UCHAR armed;
+   uint32_t due;                   // reference
+   uint32_t period;
+} ct[TIMERS + SWT_POOL_SIZE];
+
+static uint32_t rnd(void)
+{
+   static uint32_t s = 2463534242u;
+   s ^= s << 13;
+   s ^= s >> 17;
+   s ^= s << 5;
+   return s;
+}
+
+static void fail(const char *what, int i, uint32_t now)
+{
+   if(fails++ < 10)
+      printf("swtimer: %s, timer %d at %u, due %u period %u\n", what, i, now,
+             ct[i].due, ct[i].period);
+}
+
+void sched_post(UCHAR ev)          // the loop side is called directly
+{
+   (void)ev;
+}
+
+static void fired(void *arg)
+{
+   struct check_timer *c = (struct check_timer *)arg;
+   uint32_t now = swt_ticks();
+   int i = c - ct;
+   if(!c->armed) fail("callback of a stopped timer", i, now);
+   else if((int32_t)(now - c->due) < 0 || now - c->due >= RUN_EVERY)
+      fail("callback at the wrong tick", i, now);
+   if(c->period) c->due += c->period;
+   else c->armed = 0;
+}
+
+static void late_fired(void *arg)
+{
+   (*(unsigned long *)arg)++;
+}
+
+/* swt_run() 0 to 3 periods late, the next expiry must not slip a turn;
+   returns the callbacks checked */
+static unsigned long check_late(void)
+{
+   struct swtimer t;
+   unsigned long runs = 0, n = 0;
+   uint32_t late, due, next, i;
+
+   swt_setup(&t, late_fired, &runs, NULL);
+   for(late = 0; late <= 3*LATE_PERIOD; late++)
+   {
+      swt_start(&t, LATE_PERIOD, LATE_PERIOD);
+      due = swt_ticks() + LATE_PERIOD;
+      for(i = 0; i < LATE_PERIOD + late; i++) swt_tick();
+      if(t.state != SWT_FIRED) fail("late loop, not fired", 0, swt_ticks());
+      swt_run();
+      next = due + LATE_PERIOD;
+      if((int32_t)(next - swt_ticks()) <= 0) next = swt_ticks() + 1;
+      while(t.state != SWT_FIRED &&
+            swt_ticks() != next + (2UL << SWT_SLOT_BITS)) swt_tick();
+      if(swt_ticks() != next)
+      {
+         if(fails++ < 10)
+            printf("swtimer: loop %u ticks late, due again at %u, "
+                   "fired at %u\n", late, next, swt_ticks());
+      }
+      swt_stop(&t);
+      n++;
+   }
+   if(runs != n) fail("late loop, callbacks", 0, swt_ticks());
+   return n;
+}
+
+static uint32_t random_ticks(void)
+{
+   switch(rnd() % 8)
+   {
+      case 0: case 1: case 2: return 1 + rnd() % 40;
+      case 3: case 4: return 1 + rnd() % 1500;
+      case 5: return 1 + rnd() % 40000;
+      case 6: return 1 + rnd() % (1UL << 20);
+      default: return (1UL << 20) - 3 + rnd() % (1UL << 21);
+   }
+}
+
+int main(void)
+{
+   uint32_t now, ticks;
+   int i, n = TIMERS + SWT_POOL_SIZE;
+   unsigned long flags = 0, callbacks = 0, starts = 0, late;
+
+   swt_init();
+   for(i = 0; i < n; i++)
+   {
+      ct[i].t = (i < TIMERS) ? &ct[i].own : swt_alloc();
+      if(ct[i].t == NULL) { fail("pool empty", i, 0); return 1; }
+      ct[i].callback = i & 1;
+      if(ct[i].callback) swt_setup(ct[i].t, fired, &ct[i], NULL);
+      else swt_setup(ct[i].t, NULL, NULL, &ct[i].flag);
+   }
+   if(swt_alloc() != NULL) fail("pool larger than SWT_POOL_SIZE", 0, 0);
+
+   for(now = 0; now < TICKS; )
+   {
+      // the loop: start, restart or stop a timer now and then
+      if(rnd() % 4 == 0)
+      {
+         i = rnd() % n;
+         if(rnd() % 5 == 0)
+         {
+            swt_stop(ct[i].t);
+            ct[i].armed = 0;
+         }
+         else
+         {
+            ticks = random_ticks();
+            ct[i].period = (rnd() % 3 == 0) ? RUN_EVERY + random_ticks() % 3000 : 0;
+            swt_start(ct[i].t, ticks, ct[i].period);
+            ct[i].due = now + ticks;
+            ct[i].armed = 1;
+            starts++;
+         }
+      }
+      if(swt_active(ct[0].t) != (ct[0].armed || ct[0].t->state == SWT_FIRED))
+         fail("swt_active() wrong", 0, now);
+
+      // the interrupt
+      swt_tick();
+      now++;
+      if(swt_ticks() != now) fail("tick count", 0, now);
+      for(i = 0; i < n; i++)
+      {
+         if(ct[i].callback) continue;
+         if(ct[i].flag)
+         {
+            ct[i].flag = 0;
+            flags++;
+            if(!ct[i].armed) fail("flag of a stopped timer", i, now);
+            else if(ct[i].due != now) fail("flag at the wrong tick", i, now);
+            if(ct[i].period) ct[i].due += ct[i].period;
+            else ct[i].armed = 0;
+         }
+         else if(ct[i].armed && ct[i].due == now) fail("flag missed", i, now);
+      }
+
+      // the loop again, late
+      if(now % RUN_EVERY == 0)
+      {
+         for(i = 0; i < n; i++)
+            if(ct[i].callback && ct[i].armed && (int32_t)(now - ct[i].due) >= 0)
+               callbacks++;
+         swt_run();
+         for(i = 0; i < n; i++)
+            if(ct[i].callback && ct[i].armed && (int32_t)(now - ct[i].due) >= 0)
+               fail("callback missed", i, now);
+      }
+   }
+
+   for(i = 0; i < n; i++) swt_stop(ct[i].t);
+   swt_run();
+   late = check_late();
+
+   for(i = TIMERS; i < n; i++) swt_free(ct[i].t);
+   for(i = 0; i < SWT_POOL_SIZE; i++)
+      if(swt_alloc() == NULL) fail("pool lost a timer", i, now);
+
+   if(fails) return 1;
+   printf("swtimer: %lu starts, %lu flags and %lu callbacks on time over "
+          "%lu ticks, %lu late loop restarts\n", starts, flags, callbacks,
+          TICKS, late);
+   return 0;
+}
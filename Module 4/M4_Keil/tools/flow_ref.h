@@ -0,0 +1,69 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file flow_ref.h
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      flow_ref.h                                           --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+--
+   Functional Description:
+   Float reference models for the fluid properties and the flow formulas,
+   written exactly as the original calculate_flow() in main.cpp evaluated
+   them.  The table generator samples them, the table check compares the
+   firmware lookups and the engine check flow_engine.cpp against them.
+--
+*/
+#ifndef FLOW_REF_H
+#define FLOW_REF_H
+
+#include <math.h>
+
+/// viscosity (x1,000,000) at temperature T (Celsius x100)
+static inline double ref_viscosity(double temperature)
+{
+   double temperatureK = temperature + 27315; //Kelvin (x100)
+   return 24*powf(10,24780.0f/((float)temperatureK - 14000.0f));
+}
+
+/// density (kg/m^3) at temperature T (Celsius x100)
+static inline double ref_density(double temperature)
+{
+   return 1000*( 1- (((float)temperature+28894.14)/
+                    (508929.2*((float) temperature+6812.963 )))
+                    *powf((((float)temperature*0.01)-3.9863),2));
+}
+
+/// Strouhal number (x10,000) at Reynolds number Re
+static inline double ref_strouhal(double Re)
+{
+   return 2684-10356/powf(Re,0.5);
+}
+
+/// velocity (in/s x100) at frequency (Hz x100) and St_const (x10,000)
+static inline double ref_velocity(double frequency, double St_const)
+{
+   return 10000*frequency*0.5/St_const;          // d_width 0.5 in
+}
+
+/// Reynolds number at density, velocity (x100) and viscosity (x1,000,000)
+static inline double ref_reynolds(double rho_density, double velocity,
+                                  double viscosity)
+{
+   return 1000000*(rho_density*(velocity/3937)*(0.07366))/viscosity; // PIDm
+}
+
+/// flow (GPM x100) at velocity (in/s x100)
+static inline double ref_flow(double velocity)
+{
+   return 2.45*2.900*2.900*velocity/12;          // PID 2.900 in
+}
+
+#endif
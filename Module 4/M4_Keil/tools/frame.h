@@ -0,0 +1,65 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file frame.h
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      frame.h                                              --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+--
+   Functional Description:
+   The frame layer the decoders share: the COBS framing and CRC-16/CCITT
+   of tel_frame_put() (telemetry.cpp), and the little endian fields of
+   the records.  Included by tel_decode, log_decode and trace_view, after
+   ../shared.h, which has no include guard.
+--
+*/
+#ifndef FRAME_H
+#define FRAME_H
+
+/* CRC-16/CCITT, 0x1021 from 0xFFFF, as MbedCRC in telemetry.cpp */
+static inline uint16_t crc16(const UCHAR *p, int n)
+{
+   uint16_t crc = 0xFFFF;
+   while(n-- > 0)
+   {
+      crc ^= (uint16_t)(*p++) << 8;
+      for(int b = 0; b < 8; b++)
+         crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+   }
+   return crc;
+}
+
+static inline uint32_t get32(const UCHAR *p)
+{
+   return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t get16(const UCHAR *p)
+{
+   return p[0] | (p[1] << 8);
+}
+
+/* COBS decode into out, returns the length or -1 if it is not COBS.  out
+   may be p, the decoded bytes are never ahead of the encoded ones. */
+static inline int cobs_decode(UCHAR *out, const UCHAR *p, int n)
+{
+   int in = 0, len = 0;
+   while(in < n)
+   {
+      int code = p[in++];
+      if(code == 0 || in + code - 1 > n) return -1;
+      for(int i = 1; i < code; i++) out[len++] = p[in++];
+      if(in < n) out[len++] = 0;   // the zero the code stood for
+   }
+   return len;
+}
+
+#endif
@@ -0,0 +1,89 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file gen_flow_tables.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      gen_flow_tables.cpp                                  --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Tools used:  any host C++ compiler (see Makefile)
+--
+   Functional Description:
+   Generates flow_tables.h, the const flash tables used by flow_lut.cpp.
+
+   Temperature tables (viscosity, density) are keyed by Celsius x100 in steps
+   of 2^FT_TEMP_SHIFT so the firmware indexes them with a shift instead of a
+   divide.  The Strouhal table is keyed by Reynolds number, 2^FT_RE_SUB
+   linear segments per octave from 2^FT_RE_OCT_MIN to 2^FT_RE_OCT_MAX.
+   All entries are Q4 (x16) in the units calculate_flow() already used.
+
+   Usage:  gen_flow_tables > ../flow_tables.h
+--
+*/
+#include <stdio.h>
+#include <math.h>
+#include "flow_ref.h"
+
+#define FT_Q             4      /* fraction bits in every table */
+#define FT_TEMP_SHIFT    7      /* temperature step 128 = 1.28 C */
+#define FT_TEMP_COUNT    80     /* 0 to 101.12 C */
+#define FT_RE_OCT_MIN    13     /* Re 8192 */
+#define FT_RE_OCT_MAX    24     /* Re 16777216 */
+#define FT_RE_SUB        3      /* 8 segments per octave */
+#define FT_RE_COUNT      (((FT_RE_OCT_MAX - FT_RE_OCT_MIN) << FT_RE_SUB) + 1)
+
+/// prints one table as a C array, 8 entries per line
+static void emit(const char *name, const char *desc, double (*f)(double),
+                 double (*key)(int), int count)
+{
+   int i;
+   printf("\n/* %s */\nconst uint16_t %s[%d] =\n{", desc, name, count);
+   for(i = 0; i < count; i++)
+   {
+      long v = lround(f(key(i)) * (1 << FT_Q));
+      printf("%s%5ld%s", (i % 8) ? " " : "\n   ", v, (i < count - 1) ? "," : "");
+   }
+   printf("\n};\n");
+}
+
+static double temp_key(int i) { return (double)(i << FT_TEMP_SHIFT); }
+
+static double re_key(int i)
+{
+   int oct = FT_RE_OCT_MIN + (i >> FT_RE_SUB);
+   int sub = i & ((1 << FT_RE_SUB) - 1);
+   return ldexp(1.0 + (double)sub / (1 << FT_RE_SUB), oct);
+}
+
+int main(void)
+{
+   printf("/**------------------------------------------------------------------"
+          "----------\n");
+   printf("             \\file flow_tables.h\n\n");
+   printf("   Generated by tools/gen_flow_tables.cpp, do not edit.\n\n");
+   printf("   Fluid property tables for flow_lut.cpp, all entries Q%d.\n*/\n",
+          FT_Q);
+   printf("#ifndef FLOW_TABLES_H\n#define FLOW_TABLES_H\n\n");
+   printf("#define FT_Q             %d\n", FT_Q);
+   printf("#define FT_TEMP_SHIFT    %d\n", FT_TEMP_SHIFT);
+   printf("#define FT_TEMP_COUNT    %d\n", FT_TEMP_COUNT);
+   printf("#define FT_RE_OCT_MIN    %d\n", FT_RE_OCT_MIN);
+   printf("#define FT_RE_OCT_MAX    %d\n", FT_RE_OCT_MAX);
+   printf("#define FT_RE_SUB        %d\n", FT_RE_SUB);
+   printf("#define FT_RE_COUNT      %d\n", FT_RE_COUNT);
+   emit("visc_tab", "viscosity (x1,000,000) vs temperature (C x100)",
+        ref_viscosity, temp_key, FT_TEMP_COUNT);
+   emit("rho_tab", "density (kg/m^3) vs temperature (C x100)",
+        ref_density, temp_key, FT_TEMP_COUNT);
+   emit("st_tab", "Strouhal number (x10,000) vs Reynolds number",
+        ref_strouhal, re_key, FT_RE_COUNT);
+   printf("\n#endif\n");
+   return 0;
+}
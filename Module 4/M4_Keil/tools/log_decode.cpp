@@ -0,0 +1,171 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file log_decode.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      log_decode.cpp                                       --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Tools used:  any host C++ compiler (see Makefile)
+--
+   Functional Description:
+   Decodes a capture of the LOGD read back of the flash log (flashlog.cpp)
+   into one line per record, oldest first:
+
+      boot time_s flow_gpm freq_hz temp_c
+
+   from a file named on the command line, or stdin.  The stream is split
+   at each 0 and every piece COBS decoded; text in front of a frame is
+   passed over by trying the piece from each byte on until a TEL_TYPE_LOG
+   frame with a good CRC comes out.  The frames put the sectors back
+   together, which are then read chunk by chunk (format in shared.h).
+   Counts of sectors, records and rejected frames go to stderr, with a
+   warning if the end frame was not seen.
+
+      log_decode capture.bin > history.txt
+--
+*/
+#include <stdio.h>
+#include <string.h>
+#include "../shared.h"
+#include "frame.h"
+
+#define PIECE_MAX 1024
+
+static struct sector
+{
+   uint32_t seq;
+   uint16_t len;                  // bytes received, in order
+   UCHAR data[FLOG_SECTOR_SIZE];
+} sec[FLOG_SECTORS];
+static int sectors = 0;
+
+/* the varint at *p, advancing it, 0 past the end */
+static int varint(const UCHAR **p, const UCHAR *end, uint32_t *x)
+{
+   int shift = 0;
+   *x = 0;
+   while(*p < end && shift < 35)
+   {
+      UCHAR b = *(*p)++;
+      *x |= (uint32_t)(b & 0x7F) << shift;
+      if(!(b & 0x80)) return 1;
+      shift += 7;
+   }
+   return 0;
+}
+
+static uint32_t unzigzag(uint32_t z)
+{
+   return (z >> 1) ^ (0 - (z & 1));
+}
+
+/* a decoded frame: the sector bytes go where the position says */
+static int take_frame(const UCHAR *f, int n)
+{
+   uint32_t seq = get32(&f[TEL_LOG_OFS_SEQ]);
+   int pos = f[TEL_LOG_OFS_POS] | (f[TEL_LOG_OFS_POS + 1] << 8);
+   int len = n - TEL_LOG_OFS_DATA;
+
+   if(pos == TEL_LOG_END) return 1;
+   if(sectors == 0 || sec[sectors - 1].seq != seq)
+   {
+      if(sectors == FLOG_SECTORS) return 0;
+      sec[sectors].seq = seq;
+      sec[sectors].len = 0;
+      sectors++;
+   }
+   struct sector *s = &sec[sectors - 1];
+   if(pos != s->len || pos + len > FLOG_SECTOR_SIZE) return 0;  // a frame lost
+   memcpy(&s->data[pos], &f[TEL_LOG_OFS_DATA], len);
+   s->len += len;
+   return 0;
+}
+
+/* the records of one sector, returns how many */
+static unsigned long print_sector(const struct sector *s)
+{
+   unsigned long n = 0;
+   uint32_t t, flow, freq, temp, d;
+   int boot, ofs = FLOG_HDR_SIZE;
+
+   if(s->len < FLOG_HDR_SIZE || (s->data[0] | (s->data[1] << 8)) != FLOG_MAGIC)
+      return 0;
+   boot = s->data[FLOG_OFS_BOOT] | (s->data[FLOG_OFS_BOOT + 1] << 8);
+   while(ofs < s->len && s->data[ofs] != FLOG_CHUNK_NONE && s->data[ofs] != 0)
+   {
+      const UCHAR *p = &s->data[ofs + 1];
+      const UCHAR *end = p + s->data[ofs];
+      if(ofs + 1 + s->data[ofs] > s->len) break;
+      if(!varint(&p, end, &t) || !varint(&p, end, &flow) ||
+         !varint(&p, end, &freq) || !varint(&p, end, &temp))
+         break;
+      for(;;)
+      {
+         printf("%4d %10.1f %9.2f %8.2f %6.2f\n", boot, t / 10.0, flow / 100.0,
+                freq / 100.0, temp / 100.0);
+         n++;
+         if(p >= end) break;
+         if(!varint(&p, end, &d)) break;
+         t += d;
+         if(!varint(&p, end, &d)) break;
+         flow += unzigzag(d);
+         if(!varint(&p, end, &d)) break;
+         freq += unzigzag(d);
+         if(!varint(&p, end, &d)) break;
+         temp += unzigzag(d);
+      }
+      ofs += (s->data[ofs] + 1 + 3) & ~3;
+   }
+   return n;
+}
+
+int main(int argc, char **argv)
+{
+   FILE *f = stdin;
+   static UCHAR piece[PIECE_MAX], frame[PIECE_MAX];
+   int c, i, len, n = 0, ended = 0;
+   unsigned long records = 0, bad = 0;
+
+   if(argc > 1 && (f = fopen(argv[1], "rb")) == NULL)
+   {
+      perror(argv[1]);
+      return 1;
+   }
+   while((c = getc(f)) != EOF && !ended)
+   {
+      if(c != 0)
+      {
+         if(n == PIECE_MAX)
+         {                            // long text, keep the end of it
+            memmove(piece, &piece[PIECE_MAX/2], PIECE_MAX/2);
+            n = PIECE_MAX/2;
+         }
+         piece[n++] = c;
+         continue;
+      }
+      for(i = 0; i < n; i++)          // text may come first
+      {
+         len = cobs_decode(frame, &piece[i], n - i);
+         if(len >= TEL_LOG_OFS_DATA + 2 && frame[TEL_OFS_TYPE] == TEL_TYPE_LOG &&
+            crc16(frame, len - 2) == (frame[len - 2] | (frame[len - 1] << 8)))
+            break;
+      }
+      if(i == n) bad++;
+      else ended = take_frame(frame, len - 2);
+      n = 0;
+   }
+
+   printf("boot time_s flow_gpm freq_hz temp_c\n");
+   for(i = 0; i < sectors; i++) records += print_sector(&sec[i]);
+   fprintf(stderr, "%d sectors, %lu records, %lu other frames\n", sectors, records, bad);
+   if(!ended) fprintf(stderr, "no end frame, the read back is incomplete\n");
+   return 0;
+}
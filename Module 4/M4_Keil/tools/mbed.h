@@ -0,0 +1,21 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file mbed.h
+--
+   Functional Description:
+   Stand-in for the mbed SDK header when firmware modules that need no
+   peripherals are compiled on the host by the tools in this directory.
+   The tools are single threaded, so masking interrupts does nothing.
+--
+*/
+#ifndef TOOLS_MBED_H
+#define TOOLS_MBED_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+static inline void __disable_irq(void) { }
+static inline void __enable_irq(void) { }
+
+#endif
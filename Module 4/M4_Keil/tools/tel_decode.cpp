@@ -0,0 +1,88 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file tel_decode.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      tel_decode.cpp                                       --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Tools used:  any host C++ compiler (see Makefile)
+--
+   Functional Description:
+   Decodes a capture of the BINARY display mode (telemetry.cpp) into one
+   line per record:
+
+      seq time_s flow_gpm freq_hz temp_c Re St flags engine
+
+   from a file named on the command line, or stdin.  The stream is split
+   at each 0, every piece is COBS decoded and kept only if it is a whole
+   record with a good CRC.  A record always encodes to TEL_REC_SIZE + 1
+   bytes, so of a longer piece only the end is decoded: text sent before
+   a record, the answer to a command, has no 0 of its own to end it.
+   time_s is the tick count times the tick period, both from the record.
+   Counts of records, rejected frames and sequence gaps (records the
+   firmware skipped) go to stderr at the end.
+
+      tel_decode capture.bin > capture.txt
+--
+*/
+#include <stdio.h>
+#include "../shared.h"
+#include "frame.h"
+
+#define FRAME_LEN (TEL_REC_SIZE + 1)    /* a record COBS encoded, no 0 */
+
+int main(int argc, char **argv)
+{
+   FILE *f = stdin;
+   UCHAR ring[FRAME_LEN], rec[FRAME_LEN];   // the last FRAME_LEN bytes
+   int c, i, len, n = 0, last_seq = -1;
+   unsigned long good = 0, bad = 0, gaps = 0;
+
+   if(argc > 1 && (f = fopen(argv[1], "rb")) == NULL)
+   {
+      perror(argv[1]);
+      return 1;
+   }
+   printf("seq time_s flow_gpm freq_hz temp_c Re St flags engine\n");
+   while((c = getc(f)) != EOF)
+   {
+      if(c != 0)
+      {
+         ring[n++ % FRAME_LEN] = c;
+         continue;
+      }
+      for(i = 0; i < FRAME_LEN; i++) rec[i] = ring[(n + i) % FRAME_LEN];
+      len = n;
+      n = 0;
+      if(len < FRAME_LEN || cobs_decode(rec, rec, FRAME_LEN) != TEL_REC_SIZE ||
+         rec[TEL_OFS_TYPE] != TEL_TYPE_STATUS ||
+         crc16(rec, TEL_OFS_CRC) != (rec[TEL_OFS_CRC] | (rec[TEL_OFS_CRC + 1] << 8)))
+      {
+         bad++;
+         continue;
+      }
+      if(last_seq >= 0 && rec[TEL_OFS_SEQ] != ((last_seq + 1) & 0xFF)) gaps++;
+      last_seq = rec[TEL_OFS_SEQ];
+      good++;
+      printf("%3u %10.4f %9.2f %8.2f %6.2f %8u %6.4f 0x%02x %u\n",
+             rec[TEL_OFS_SEQ],
+             get32(&rec[TEL_OFS_TIME]) * 1e-6 *
+                (rec[TEL_OFS_TICK_US] | (rec[TEL_OFS_TICK_US + 1] << 8)),
+             get32(&rec[TEL_OFS_FLOW]) / 100.0,
+             get32(&rec[TEL_OFS_FREQ]) / 100.0,
+             get32(&rec[TEL_OFS_TEMP]) / 100.0,
+             get32(&rec[TEL_OFS_RE]),
+             (rec[TEL_OFS_ST] | (rec[TEL_OFS_ST + 1] << 8)) / 10000.0,
+             rec[TEL_OFS_FLAGS], rec[TEL_OFS_ENGINE]);
+   }
+   fprintf(stderr, "%lu records, %lu other frames, %lu sequence gaps\n", good, bad, gaps);
+   return 0;
+}
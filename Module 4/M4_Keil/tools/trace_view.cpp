@@ -0,0 +1,281 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file trace_view.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Host Tools                                                 --
+--                      trace_view.cpp                                       --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Tools used:  any host C++ compiler (see Makefile)
+--
+   Functional Description:
+   Shows a capture of the TRD read back of the event trace (trace.cpp) as
+   one time line, one line per event:
+
+      time_us level event arg
+
+   time_us from the oldest event, level L for the loop and I for a
+   handler.  -s leaves the time line out.  A summary follows on stderr:
+   the tick period and latency seen, the time in PIT_IRQHandler, each
+   task's longest run and how many handler events fell inside its runs,
+   and the share of the time asleep.
+
+   The frames are found as log_decode finds them.  An event's stamp is
+   SysTick, 24 bits of core clock cycles, and its tick the low 16 bits of
+   System_Timer_count.  The ticks are counted back from the tick in the
+   head frame, so each ring is on the same count; the tick times the
+   cycles per tick then tells which turn of SysTick the stamp is in, and
+   the stamp gives the time to the cycle.  This holds while the tick
+   period was not changed (TICK<us>) in the time the trace covers.
+
+      trace_view capture.bin > timeline.txt
+--
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../shared.h"
+#include "frame.h"
+
+#define PIECE_MAX 1024
+#define EVENTS_MAX (TRACE_LOOP_SIZE + TRACE_IRQ_SIZE)
+#define TASKS_MAX 16
+
+static struct event
+{
+   UCHAR ring;
+   UCHAR id;
+   uint16_t tick;
+   uint32_t stamp;                // 24 bits
+   uint16_t arg;
+   uint32_t number;               // in its ring, for the order
+   double t;                      // cycles, once placed
+} ev[EVENTS_MAX];
+static int events = 0;
+
+static uint32_t clock_hz = 0;
+static uint16_t tick_us = 0;
+static uint16_t tick_now = 0;
+static int have_head = 0;
+
+static const struct { UCHAR id; const char *name; } names[] =
+{
+   {TR_TICK, "tick"}, {TR_TICK_END, "tick_end"},
+   {TR_UART_RX, "uart_rx"}, {TR_UART_TX, "uart_tx"}, {TR_UART_LINE, "line"},
+   {TR_ADC_BLOCK, "adc_block"}, {TR_ADC_HK, "adc_hk"},
+   {TR_TASK, "task"}, {TR_TASK_END, "task_end"},
+   {TR_STAGE, "stage"}, {TR_STAGE_END, "stage_end"},
+   {TR_SLEEP, "sleep"}, {TR_WAKE, "wake"},
+   {TR_FLASH, "flash"}, {TR_FLASH_END, "flash_end"},
+   {TR_MARK, "mark"}
+};
+
+static const char *name_of(UCHAR id)
+{
+   static char other[8];
+   for(unsigned i = 0; i < sizeof(names)/sizeof(names[0]); i++)
+      if(names[i].id == id) return names[i].name;
+   snprintf(other, sizeof(other), "0x%02x", id);
+   return other;
+}
+
+/* a decoded frame, returns 1 for the end frame */
+static int take_frame(const UCHAR *f, int n)
+{
+   UCHAR ring = f[TEL_TRACE_OFS_RING];
+   uint32_t number;
+
+   if(ring == TEL_TRACE_END) return 1;
+   if(ring == TEL_TRACE_HEAD)
+   {
+      if(n < TEL_TRACE_HEAD_SIZE) return 0;
+      clock_hz = get32(&f[TEL_TRACE_OFS_CLOCK]);
+      tick_us = get16(&f[TEL_TRACE_OFS_TICK_US]);
+      tick_now = get16(&f[TEL_TRACE_OFS_NOW]);
+      have_head = 1;
+      events = 0;                  // a read back starts over
+      return 0;
+   }
+   if(ring >= TRACE_RINGS) return 0;
+   number = get16(&f[TEL_TRACE_OFS_INDEX]);
+   for(int p = TEL_TRACE_OFS_DATA; p + TRACE_REC_SIZE <= n && events < EVENTS_MAX;
+       p += TRACE_REC_SIZE, number++)
+   {
+      struct event *e = &ev[events++];
+      e->ring = ring;
+      e->stamp = get32(&f[p]) & CYCLE_MASK;
+      e->id = f[p + 3];
+      e->tick = get16(&f[p + 4]);
+      e->arg = get16(&f[p + 6]);
+      e->number = number;
+   }
+   return 0;
+}
+
+/* the time of every event in cycles, see the description */
+static void place(void)
+{
+   double cpt = (double)clock_hz * tick_us / 1e6;
+   int64_t full, ref = -1;
+   int i, r, last;
+
+   for(r = 0; r < TRACE_RINGS; r++)
+   {
+      full = (1LL << 32) + tick_now;          // kept positive
+      last = -1;
+      for(i = events - 1; i >= 0; i--)
+      {                                       // newest first
+         if(ev[i].ring != r) continue;
+         full -= (uint16_t)((last < 0 ? tick_now : ev[last].tick) - ev[i].tick);
+         last = i;
+         double base = full*cpt;
+         int64_t b = (int64_t)base;
+         if(ref < 0) ref = (ev[i].stamp - b) & CYCLE_MASK;
+         int32_t d = (int32_t)((ev[i].stamp - b - ref) & CYCLE_MASK);
+         if(d > (int32_t)(CYCLE_MASK >> 1)) d -= CYCLE_MASK + 1;
+         ev[i].t = b + ref + d;
+      }
+   }
+}
+
+static int by_time(const void *a, const void *b)
+{
+   const struct event *x = (const struct event *)a, *y = (const struct event *)b;
+   if(x->t != y->t) return x->t < y->t ? -1 : 1;
+   if(x->ring != y->ring) return x->ring > y->ring ? -1 : 1;  // a handler first
+   return x->number < y->number ? -1 : 1;
+}
+
+int main(int argc, char **argv)
+{
+   FILE *f = stdin;
+   static UCHAR piece[PIECE_MAX], frame[PIECE_MAX];
+   int c, i, len, n = 0, ended = 0, quiet = 0;
+   unsigned long bad = 0;
+
+   for(i = 1; i < argc; i++)
+   {
+      if(strcmp(argv[i], "-s") == 0) quiet = 1;
+      else if((f = fopen(argv[i], "rb")) == NULL)
+      {
+         perror(argv[i]);
+         return 1;
+      }
+   }
+   while((c = getc(f)) != EOF && !ended)
+   {
+      if(c != 0)
+      {
+         if(n == PIECE_MAX)
+         {                            // long text, keep the end of it
+            memmove(piece, &piece[PIECE_MAX/2], PIECE_MAX/2);
+            n = PIECE_MAX/2;
+         }
+         piece[n++] = c;
+         continue;
+      }
+      for(i = 0; i < n; i++)          // text may come first
+      {
+         len = cobs_decode(frame, &piece[i], n - i);
+         if(len >= TEL_TRACE_OFS_DATA + 2 && frame[TEL_OFS_TYPE] == TEL_TYPE_TRACE &&
+            crc16(frame, len - 2) == (frame[len - 2] | (frame[len - 1] << 8)))
+            break;
+      }
+      if(i == n) bad++;
+      else ended = take_frame(frame, len - 2);
+      n = 0;
+   }
+   if(!have_head || clock_hz == 0 || tick_us == 0)
+   {
+      fprintf(stderr, "no trace head frame, %lu other frames\n", bad);
+      return 1;
+   }
+
+   place();
+   qsort(ev, events, sizeof(ev[0]), by_time);
+
+   double us = 1e6/clock_hz;
+   double t0 = events ? ev[0].t : 0;
+   double tick_last = -1, tick_min = 1e30, tick_max = 0, tick_sum = 0;
+   unsigned long ticks = 0, lat_n = 0, lat_sum = 0, lat_max = 0, exec_max = 0;
+   double task_start[TASKS_MAX], task_max[TASKS_MAX] = {0}, sleep_start = -1, asleep = 0;
+   unsigned long task_runs[TASKS_MAX] = {0}, task_hit[TASKS_MAX] = {0};
+   int task = -1;
+
+   if(!quiet) printf("time_us level event arg\n");
+   for(i = 0; i < events; i++)
+   {
+      struct event *e = &ev[i];
+      if(!quiet)
+         printf("%12.2f %c %-10s %u\n", (e->t - t0)*us,
+                e->ring == TRACE_RING_IRQ ? 'I' : 'L', name_of(e->id), e->arg);
+      if(e->ring == TRACE_RING_IRQ && task >= 0) task_hit[task]++;
+      switch(e->id)
+      {
+         case TR_TICK:
+            if(tick_last >= 0)
+            {
+               double d = e->t - tick_last;
+               if(d < tick_min) tick_min = d;
+               if(d > tick_max) tick_max = d;
+               tick_sum += d;
+               ticks++;
+            }
+            tick_last = e->t;
+            lat_n++;
+            lat_sum += e->arg;
+            if(e->arg > lat_max) lat_max = e->arg;
+            break;
+         case TR_TICK_END:
+            if(e->arg > exec_max) exec_max = e->arg;
+            break;
+         case TR_TASK:
+            if(e->arg < TASKS_MAX)
+            {
+               task = e->arg;
+               task_start[task] = e->t;
+            }
+            break;
+         case TR_TASK_END:
+            if(e->arg < TASKS_MAX && task == e->arg)
+            {
+               double d = e->t - task_start[task];
+               if(d > task_max[task]) task_max[task] = d;
+               task_runs[task]++;
+            }
+            task = -1;
+            break;
+         case TR_SLEEP:
+            sleep_start = e->t;
+            break;
+         case TR_WAKE:
+            if(sleep_start >= 0) asleep += e->t - sleep_start;
+            sleep_start = -1;
+            break;
+      }
+   }
+
+   double span = events ? (ev[events - 1].t - t0) : 0;
+   fprintf(stderr, "%d events over %.1f us, clock %lu Hz, tick %u us, %lu other frames\n",
+           events, span*us, (unsigned long)clock_hz, tick_us, bad);
+   if(ticks)
+      fprintf(stderr, "tick period us min avg max %.2f %.2f %.2f\n",
+              tick_min*us, tick_sum/ticks*us, tick_max*us);
+   if(lat_n)
+      fprintf(stderr, "tick latency cycles avg max %lu %lu, PIT_IRQHandler max %lu\n",
+              lat_sum/lat_n, lat_max, exec_max);
+   for(i = 0; i < TASKS_MAX; i++)
+      if(task_runs[i])
+         fprintf(stderr, "task %d: %lu runs, longest %.1f us, %lu handler events inside\n",
+                 i, task_runs[i], task_max[i]*us, task_hit[i]);
+   if(span > 0) fprintf(stderr, "asleep %.1f%%\n", 100.0*asleep/span);
+   if(!ended) fprintf(stderr, "no end frame, the read back is incomplete\n");
+   return 0;
+}
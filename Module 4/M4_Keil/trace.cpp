@@ -0,0 +1,218 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file trace.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      trace.cpp                                            --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   An always on event trace, in place of BugMe toggles and prints.
+
+   TRACE(id, arg) keeps a struct trace_rec of 8 bytes: the trace_event,
+   cycle_stamp(), the low 16 bits of System_Timer_count and a 16 bit arg.
+   The events are in shared.h: the tick, UART0, the ADC blocks, each task
+   and loop stage, sleep, and the flash commands.  Their class (the high
+   nibble) picks a bit of trace_mask, the TR<m> command; the test of the
+   bit is in the macro, so an event turned off costs a load and a branch.
+
+   The records go into one of two rings, by the execution level the
+   writer runs at: TRACE_RING_IRQ from any handler (IPSR not 0), else
+   TRACE_RING_LOOP.  No interrupt priority is set in this firmware, so
+   no handler preempts another, and each ring has a single writer at a
+   time; the loop ring's writer can be interrupted, but the handler
+   writes the other ring.  So no interrupt is masked: the record is
+   filled, then head is moved on by one 32 bit store.  The oldest record
+   is overwritten, the rings hold the latest TRACE_LOOP_SIZE and
+   TRACE_IRQ_SIZE events.  A handler given a priority of its own would
+   need a ring of its own.
+
+   TRD sends both rings in binary.  It first sets trace_mask to 0, which
+   freezes them (a handler runs to the end before the loop goes on, so no
+   record is left half written), sends a head frame, the records oldest
+   first, and an end frame, all as TEL_TYPE_TRACE frames through
+   tel_frame_put(), then restores the mask.  tools/trace_view puts the
+   two rings back on one time line.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+#include "MKL25Z4.h"
+
+#define TRACE_DUMP_FRAMES  3     /* TRD frames per trace_dump_poll() */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   struct trace_ring
+   {
+      struct trace_rec *rec;
+      uint16_t mask;                      // records - 1
+      volatile uint32_t head;             // records written, the next goes
+   };                                     //   to rec[head & mask]
+
+   static struct trace_rec trace_loop[TRACE_LOOP_SIZE];
+   static struct trace_rec trace_irq[TRACE_IRQ_SIZE];
+   static struct trace_ring trace_rings[TRACE_RINGS] =
+   {
+      {trace_loop, TRACE_LOOP_SIZE - 1, 0},
+      {trace_irq, TRACE_IRQ_SIZE - 1, 0}
+   };
+
+   volatile UCHAR trace_mask = 0xFF;      // classes traced, 0 while frozen
+   static UCHAR trace_set = 0xFF;         // classes asked for with TR<m>
+
+   static UCHAR trace_dump = 0;           // TRD: 1 head, 2 records, 3 end
+   static UCHAR trace_dump_ring;
+   static uint32_t trace_dump_next;       // record number to send next
+   static uint32_t trace_dump_head;       // of the ring, frozen
+
+/*****************************************************************************/
+/// \fn void trace_put(UCHAR id, uint16_t arg)
+/// @brief keeps one event, from the loop or a handler; use TRACE(id, arg)
+/*****************************************************************************/
+void trace_put(UCHAR id, uint16_t arg)
+{
+   struct trace_ring *r = &trace_rings[__get_IPSR() ? TRACE_RING_IRQ :
+                                                      TRACE_RING_LOOP];
+   uint32_t h = r->head;
+   struct trace_rec *p = &r->rec[h & r->mask];
+
+   p->stamp = (CYCLE_MASK - SysTick->VAL) | ((uint32_t)id << 24);
+   p->tick = System_Timer_count;
+   p->arg = arg;
+   r->head = h + 1;                       // the record is whole, publish it
+}
+
+/*****************************************************************************/
+/// \fn UCHAR trace_classes(void)
+/// @return the event classes traced, a bit each, as set with trace_config()
+/*****************************************************************************/
+UCHAR trace_classes(void)
+{
+   return trace_set;
+}
+
+/*****************************************************************************/
+/// \fn void trace_config(UCHAR classes)
+/// @brief sets the event classes traced, bit n for ids 0xn0 to 0xnF;
+/// during a TRD read back it takes effect at the end of it
+/*****************************************************************************/
+void trace_config(UCHAR classes)
+{
+   trace_set = classes;
+   if(!trace_dump) trace_mask = classes;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t trace_count(UCHAR ring)
+/// @return the events written to a ring since the reset
+/*****************************************************************************/
+uint32_t trace_count(UCHAR ring)
+{
+   return ring < TRACE_RINGS ? trace_rings[ring].head : 0;
+}
+
+/*****************************************************************************/
+/// \fn void trace_dump_start(void)
+/// @brief TRD: freezes the rings, trace_dump_poll() then sends them
+/*****************************************************************************/
+void trace_dump_start(void)
+{
+   trace_mask = 0;
+   trace_dump = 1;
+}
+
+/*****************************************************************************/
+/// \fn static void trace_dump_ring_start(UCHAR ring)
+/// @brief the records of ring still held go next, oldest first
+/*****************************************************************************/
+static void trace_dump_ring_start(UCHAR ring)
+{
+   struct trace_ring *r = &trace_rings[ring];
+   trace_dump_ring = ring;
+   trace_dump_head = r->head;
+   trace_dump_next = (trace_dump_head > (uint32_t)r->mask + 1) ?
+                     trace_dump_head - r->mask - 1 : 0;
+}
+
+/*****************************************************************************/
+/// \fn void trace_dump_poll(void)
+/// @brief sends a few frames of the TRD read back when the transmit buffer
+/// has room, called every monitor() pass.  A TEL_TRACE_HEAD frame, the
+/// records of each ring in TEL_TYPE_TRACE frames, a TEL_TRACE_END frame
+/*****************************************************************************/
+void trace_dump_poll(void)
+{
+   UCHAR rec[TEL_LOG_FRAME_MAX];
+   UCHAR f, n;
+   struct trace_ring *r;
+
+   if(!trace_dump) return;
+   for(f=0; f<TRACE_DUMP_FRAMES; f++)
+   {
+      rec[TEL_OFS_TYPE] = TEL_TYPE_TRACE;
+      if(trace_dump == 1)
+      {                                    // what the time stamps need
+         rec[TEL_TRACE_OFS_RING] = TEL_TRACE_HEAD;
+         rec[TEL_TRACE_OFS_CLOCK] = SystemCoreClock;
+         rec[TEL_TRACE_OFS_CLOCK + 1] = SystemCoreClock >> 8;
+         rec[TEL_TRACE_OFS_CLOCK + 2] = SystemCoreClock >> 16;
+         rec[TEL_TRACE_OFS_CLOCK + 3] = SystemCoreClock >> 24;
+         rec[TEL_TRACE_OFS_TICK_US] = pit_tick_stat()->period_us;
+         rec[TEL_TRACE_OFS_TICK_US + 1] = pit_tick_stat()->period_us >> 8;
+         rec[TEL_TRACE_OFS_NOW] = System_Timer_count;
+         rec[TEL_TRACE_OFS_NOW + 1] = System_Timer_count >> 8;
+         if(!tel_frame_put(rec, TEL_TRACE_HEAD_SIZE)) return;
+         trace_dump_ring_start(TRACE_RING_LOOP);
+         trace_dump = 2;
+         continue;
+      }
+      if(trace_dump == 2)
+      {
+         if(trace_dump_next == trace_dump_head)
+         {
+            if(trace_dump_ring + 1 < TRACE_RINGS)
+               trace_dump_ring_start(trace_dump_ring + 1);
+            else trace_dump = 3;
+            continue;
+         }
+         r = &trace_rings[trace_dump_ring];
+         rec[TEL_TRACE_OFS_RING] = trace_dump_ring;
+         rec[TEL_TRACE_OFS_INDEX] = trace_dump_next;
+         rec[TEL_TRACE_OFS_INDEX + 1] = trace_dump_next >> 8;
+         for(n=0; n<TEL_TRACE_RECS && trace_dump_next + n != trace_dump_head; n++)
+            memcpy(&rec[TEL_TRACE_OFS_DATA + n*TRACE_REC_SIZE],
+                   &r->rec[(trace_dump_next + n) & r->mask],
+                   TRACE_REC_SIZE);
+         if(!tel_frame_put(rec, TEL_TRACE_OFS_DATA + n*TRACE_REC_SIZE))
+            return;
+         trace_dump_next += n;
+         continue;
+      }
+      rec[TEL_TRACE_OFS_RING] = TEL_TRACE_END;
+      rec[TEL_TRACE_OFS_INDEX] = 0;
+      rec[TEL_TRACE_OFS_INDEX + 1] = 0;
+      if(!tel_frame_put(rec, TEL_TRACE_OFS_DATA)) return;
+      trace_dump = 0;
+      trace_mask = trace_set;              // running again
+      return;
+   }
+}
@@ -0,0 +1,175 @@
+/**----------------------------------------------------------------------------
+ *
+ *            \file zero_cross.cpp
+--                                                                           --
+--              ECEN 5803 Mastering Embedded System Architecture             --
+--                  Project 1 Module 4                                       --
+--                Microcontroller Firmware                                   --
+--                      zero_cross.cpp                                       --
+--                                                                           --
+-------------------------------------------------------------------------------
+--
+--  Designed for:  University of Colorado at Boulder
+--
+--
+--  Designed by:  David James & Ismail Yesildirek
+--
+-- Version: 2.0.3
+-- Date of current revision:  2018-10-12
+-- Target Microcontroller: Freescale MKL25ZVMT4
+-- Tools used:  ARM mbed compiler
+--              ARM mbed SDK
+--              Freescale FRDM-KL25Z Freedom Board
+--
+--
+   Functional Description:
+   Streaming frequency estimator for the vortex shedding signal.  Every ADC
+   sample is handed to zc_sample() as it arrives, and costs a fixed amount of
+   integer work:
+
+   I.   Track the DC level of the signal (first order IIR, Q8)
+   II.  Track the signal envelope (peak hold with slow decay, Q8)
+   III. Hysteresis comparator around the DC level, threshold set from the
+        envelope so the detector follows the signal amplitude
+   IV.  On every rising crossing, push the period (in samples) into a small
+        ring and keep a running sum, then publish a new frequency
+
+   Only the publish step divides, once per shedding period, so the frequency
+   is refreshed at the vortex shedding rate.
+--
+--      Copyright (c) 2015 Tim Scherr  All rights reserved.
+*/
+
+#include "shared.h"
+
+#define ZC_FS_HZ          ADC_SAMPLE_HZ   /* sample rate */
+#define ZC_DC_SHIFT       10              /* DC time constant, 2^10 samples */
+#define ZC_ENV_SHIFT      10              /* envelope decay time constant */
+#define ZC_HYST_SHIFT     2               /* hysteresis is 1/4 of envelope */
+#define ZC_MIN_HYST       256             /* counts, rejects noise floor */
+#define ZC_AVG_PERIODS    8               /* periods in the average, 2^n */
+#define ZC_TIMEOUT        ZC_FS_HZ        /* no crossing for 1 s, no flow */
+
+/**********************/
+/*   Definitions     */
+/**********************/
+   static int32_t  zc_dc = 0;          // DC level (Q8)
+   static uint32_t zc_env = 0;         // envelope, peak deviation (Q8)
+   static bool     zc_high = false;    // comparator state
+   static bool     zc_armed = false;   // a first crossing has been seen
+   static uint32_t zc_since_edge = 0;  // samples since the last rising crossing
+   static uint16_t zc_period[ZC_AVG_PERIODS]; // last periods (samples)
+   static uint32_t zc_period_sum = 0;  // running total of zc_period[]
+   static uint8_t  zc_period_idx = 0;  // oldest entry in zc_period[]
+   static uint8_t  zc_period_cnt = 0;  // valid entries in zc_period[]
+   static uint32_t zc_freq = 0;        // latest estimate, Hz (x100)
+
+/*****************************************************************************/
+/// \fn static void zc_clear_periods(void)
+/// @brief empties the period ring, the next crossing starts a new average
+/*****************************************************************************/
+static void zc_clear_periods(void)
+{
+   uint8_t i;
+   for(i=0;i<ZC_AVG_PERIODS;i++) zc_period[i] = 0;
+   zc_period_sum = 0;
+   zc_period_idx = 0;
+   zc_period_cnt = 0;
+   zc_armed = false;
+   zc_freq = 0;
+}
+
+/*****************************************************************************/
+/// \fn void zc_init(void)
+/// @brief resets the estimator, the DC level starts at mid scale
+/*****************************************************************************/
+void zc_init(void)
+{
+   zc_dc = (int32_t)0x8000 << 8;
+   zc_env = 0;
+   zc_high = false;
+   zc_since_edge = 0;
+   zc_clear_periods();
+}
+
+/*****************************************************************************/
+/// \fn UCHAR zc_sample(uint16_t sample)
+/// @brief feeds one ADC sample to the estimator
+/// @param sample raw 16 bit ADC reading
+/// @return 1 if a new frequency was published, 0 otherwise
+/*****************************************************************************/
+UCHAR zc_sample(uint16_t sample)
+{
+   int32_t x = (int32_t)sample << 8;   // sample (Q8)
+   int32_t dev;                        // deviation from DC (Q8)
+   uint32_t mag;                       // |dev|
+   int32_t hyst;                       // comparator threshold (Q8)
+
+// I. DC level
+   zc_dc += (x - zc_dc) >> ZC_DC_SHIFT;
+   dev = x - zc_dc;
+
+// II. Envelope
+   mag = (dev < 0) ? (uint32_t)(-dev) : (uint32_t)dev;
+   if(mag > zc_env) zc_env = mag;
+   else zc_env -= zc_env >> ZC_ENV_SHIFT;
+
+// III. Hysteresis comparator
+   hyst = (int32_t)(zc_env >> ZC_HYST_SHIFT);
+   if(hyst < (ZC_MIN_HYST << 8)) hyst = ZC_MIN_HYST << 8;
+
+   if(zc_since_edge < ZC_TIMEOUT) zc_since_edge++;
+   else if(zc_armed)
+   {                        // lost the signal, start over
+      zc_clear_periods();
+      return 1;
+   }
+
+   if(zc_high)
+   {
+      if(dev < -hyst) zc_high = false;   // falling crossing, re-arm
+      return 0;
+   }
+   if(dev <= hyst) return 0;
+   zc_high = true;                        // rising crossing
+
+// IV. Period accumulator
+   if(!zc_armed)
+   {                        // first crossing only starts the period count
+      zc_armed = true;
+      zc_since_edge = 0;
+      return 0;
+   }
+   zc_period_sum += zc_since_edge - zc_period[zc_period_idx];
+   zc_period[zc_period_idx] = (uint16_t)zc_since_edge;
+   zc_period_idx = (zc_period_idx + 1) & (ZC_AVG_PERIODS - 1);
+   if(zc_period_cnt < ZC_AVG_PERIODS) zc_period_cnt++;
+   zc_since_edge = 0;
+
+   // f = n/(sum*Ts), 100 is a scalar for lossless integer math
+   zc_freq = (100U*ZC_FS_HZ*zc_period_cnt)/zc_period_sum;
+   return 1;
+}
+
+/*****************************************************************************/
+/// \fn UCHAR zc_block(const uint16_t *blk, uint16_t n)
+/// @brief feeds a block of ADC samples to the estimator, the freq_engine
+/// interface to zc_sample()
+/// @return 1 if a new frequency was published during the block
+/*****************************************************************************/
+UCHAR zc_block(const uint16_t *blk, uint16_t n)
+{
+   UCHAR published = 0;
+   uint16_t i;
+   for(i=0;i<n;i++) published |= zc_sample(blk[i]);
+   return published;
+}
+
+/*****************************************************************************/
+/// \fn uint32_t zc_frequency(void)
+/// @return the latest published frequency in Hz (x100), 0 if no signal
+/*****************************************************************************/
+uint32_t zc_frequency(void)
+{
+   return zc_freq;
+}